@@ -81,6 +81,26 @@ type FenceRequest struct {
 	// Note: In case the FillValue is not set, and any of the provided coordinates
 	// fall outside the seismic cube, the request will be rejected with an error.
 	FillValue *float32 `json:"fillValue"`
+
+	// Optional vertical windows, as [top, bottom] pairs in the unit of the
+	// sample axis, e.g. [[1000, 1200]]. Only samples within the windows are
+	// returned. Give either a single window, used for all coordinates, or one
+	// window per coordinate. top and bottom snap to the nearest sample and are
+	// both inclusive. All windows must cover the same number of samples.
+	// Not supported with level of detail.
+	// Defaults to the whole trace.
+	VerticalWindows [][]float32 `json:"verticalWindows" example:"[[1000, 1200]]"`
+
+	// Level of detail
+	//
+	// Fetch decimated traces. At level of detail n only every 2^n-th sample
+	// along the trace is returned. The coordinates are always given at full
+	// resolution.
+	//
+	// The VDS must have been written with the requested level of detail.
+	// Level of detail is not supported for binary operations between two
+	// cubes. Defaults to 0, full resolution.
+	Lod int `json:"lod" example:"0"`
 } //@name FenceRequest
 
 func (f FenceRequest) toString() (string, error) {
@@ -103,8 +123,16 @@ func (f FenceRequest) toString() (string, error) {
 		fillValue = fmt.Sprintf("%.2f", *f.FillValue)
 	}
 
+	windows := "None"
+	if len(f.VerticalWindows) == 1 {
+		windows = fmt.Sprintf("%v", f.VerticalWindows[0])
+	} else if len(f.VerticalWindows) > 1 {
+		windows = fmt.Sprintf("%d window(s)", len(f.VerticalWindows))
+	}
+
 	msg := "{%s, coordinate system: %s, coordinates: %s, " +
-		"interpolation (optional): %s, fill value (optional): %s}"
+		"interpolation (optional): %s, fill value (optional): %s, " +
+		"vertical windows (optional): %s, lod (optional): %d}"
 
 	return fmt.Sprintf(
 		msg,
@@ -113,6 +141,8 @@ func (f FenceRequest) toString() (string, error) {
 		coordinates,
 		f.Interpolation,
 		fillValue,
+		windows,
+		f.Lod,
 	), nil
 }
 
@@ -155,7 +185,11 @@ func (request FenceRequest) execute(
 		return
 	}
 
-	metadata, err = handle.GetFenceMetadata(request.Coordinates)
+	metadata, err = handle.GetFenceMetadata(
+		request.Coordinates,
+		request.VerticalWindows,
+		request.Lod,
+	)
 	if err != nil {
 		return
 	}
@@ -165,6 +199,8 @@ func (request FenceRequest) execute(
 		request.Coordinates,
 		interpolation,
 		request.FillValue,
+		request.VerticalWindows,
+		request.Lod,
 	)
 	if err != nil {
 		return
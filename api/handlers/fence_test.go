@@ -55,6 +55,15 @@ func TestFenceGivesUniqueHash(t *testing.T) {
 			request1: newFenceRequest([]string{"vds"}, []string{"sas"}, "", "ij", fence1, "linear"),
 			request2: newFenceRequest([]string{"vds"}, []string{"sas"}, "", "ij", fence1, "cubic"),
 		},
+		{
+			name:     "Vertical windows differ",
+			request1: newFenceRequest([]string{"vds"}, []string{"sas"}, "", "ij", fence1, "linear"),
+			request2: func() FenceRequest {
+				request := newFenceRequest([]string{"vds"}, []string{"sas"}, "", "ij", fence1, "linear")
+				request.VerticalWindows = [][]float32{{4, 8}}
+				return request
+			}(),
+		},
 		{
 			name: "Single vds versus double vds",
 			request1: newFenceRequest(
@@ -95,6 +95,18 @@ type SliceRequest struct {
 	// Bounds can be set using both annotation and index. You are free to mix
 	// and match as you see fit.
 	Bounds []core.Bound `json:"bounds" binding:"dive"`
+
+	// Level of detail
+	//
+	// Fetch a decimated preview of the slice. At level of detail n only every
+	// 2^n-th sample is returned in each dimension, i.e. level 1 gives a
+	// quarter of the samples of a full resolution slice. The metadata
+	// describes the decimated axes.
+	//
+	// The VDS must have been written with the requested level of detail.
+	// Level of detail is not supported for binary operations between two
+	// cubes. Defaults to 0, full resolution.
+	Lod int `json:"lod" example:"0"`
 } //@name SliceRequest
 
 /** Compute a hash of the request that uniquely identifies the requested slice
@@ -119,11 +131,12 @@ func (s SliceRequest) toString() (string, error) {
 		return strings.Join(allBounds, ", ")
 	}()
 
-	return fmt.Sprintf("{%s, direction: %s, lineno: %d, bounds: %s}",
+	return fmt.Sprintf("{%s, direction: %s, lineno: %d, bounds: %s, lod: %d}",
 		s.RequestedResource.toString(),
 		s.Direction,
 		*s.Lineno,
-		bounds), nil
+		bounds,
+		s.Lod), nil
 }
 
 func (request SliceRequest) execute(
@@ -138,12 +151,18 @@ func (request SliceRequest) execute(
 		*request.Lineno,
 		axis,
 		request.Bounds,
+		request.Lod,
 	)
 	if err != nil {
 		return
 	}
 
-	res, err := handle.GetSlice(*request.Lineno, axis, request.Bounds)
+	res, err := handle.GetSlice(
+		*request.Lineno,
+		axis,
+		request.Bounds,
+		request.Lod,
+	)
 	if err != nil {
 		return
 	}
@@ -151,3 +170,128 @@ func (request SliceRequest) execute(
 
 	return data, metadata, nil
 }
+
+// SlicesGet godoc
+// @Summary  Fetch many slices from a VDS
+// @description.markdown slices
+// @Tags     slice
+// @Param    query  query  string  True  "Urlencoded/escaped SlicesRequest"
+// @Produce  multipart/mixed
+// @Success  200 {array} core.SliceMetadata "(Example below only for metadata part)"
+// @Failure  400 {object} ErrorResponse "Request is invalid"
+// @Failure  500 {object} ErrorResponse "openvds failed to process the request"
+// @Router   /slices  [get]
+func (e *Endpoint) SlicesGet(ctx *gin.Context) {
+	var request SlicesRequest
+	err := parseGetRequest(ctx, &request)
+	if abortOnError(ctx, err) {
+		return
+	}
+
+	e.makeDataRequest(ctx, request)
+}
+
+// SlicesPost godoc
+// @Summary  Fetch many slices from a VDS
+// @description.markdown slices
+// @Tags     slice
+// @Param    body  body  SlicesRequest  True  "Query Parameters"
+// @Accept   application/json
+// @Produce  multipart/mixed
+// @Success  200 {array} core.SliceMetadata "(Example below only for metadata part)"
+// @Failure  400 {object} ErrorResponse "Request is invalid"
+// @Failure  500 {object} ErrorResponse "openvds failed to process the request"
+// @Router   /slices  [post]
+func (e *Endpoint) SlicesPost(ctx *gin.Context) {
+	var request SlicesRequest
+	err := parsePostRequest(ctx, &request)
+	if abortOnError(ctx, err) {
+		return
+	}
+
+	e.makeDataRequest(ctx, request)
+}
+
+// Query for slices endpoints
+// @Description Query payload for slices endpoint /slices.
+type SlicesRequest struct {
+	RequestedResource
+
+	// Direction of the slices. See SliceRequest.
+	Direction string `json:"direction" binding:"required" example:"inline"`
+
+	// Line numbers of the slices
+	//
+	// The slices are returned in the same order as the line numbers. Line
+	// numbers may be repeated. At most 100 slices can be requested at once,
+	// and their total size must stay below 2 GiB.
+	Linenos []int `json:"linenos" binding:"required,min=1,max=100" example:"10000,10001,10002"`
+
+	// Restrict the slices in the other dimensions (sub-slicing). The same
+	// bounds apply to all slices. See SliceRequest.
+	Bounds []core.Bound `json:"bounds" binding:"dive"`
+
+	// Level of detail. See SliceRequest.
+	Lod int `json:"lod" example:"0"`
+} //@name SlicesRequest
+
+/** Compute a hash of the request that uniquely identifies the requested slices
+ *
+ * The hash is computed based on all fields that contribute toward a unique response.
+ * I.e. every field except the sas token.
+ */
+func (s SlicesRequest) hash() (string, error) {
+	// Strip the sas tokens before computing hash
+	s.Sas = nil
+	return cache.Hash(s)
+}
+
+func (s SlicesRequest) toString() (string, error) {
+
+	bounds := func() string {
+		var allBounds []string
+		for _, bound := range s.Bounds {
+			allBounds = append(allBounds,
+				fmt.Sprintf("%s: [%d, %d]", *bound.Direction, *bound.Lower, *bound.Upper))
+		}
+		return strings.Join(allBounds, ", ")
+	}()
+
+	return fmt.Sprintf("{%s, direction: %s, linenos: %v, bounds: %s, lod: %d}",
+		s.RequestedResource.toString(),
+		s.Direction,
+		s.Linenos,
+		bounds,
+		s.Lod), nil
+}
+
+func (request SlicesRequest) execute(
+	handle core.DSHandle,
+) (data [][]byte, metadata []byte, err error) {
+	axis, err := core.GetAxis(strings.ToLower(request.Direction))
+	if err != nil {
+		return
+	}
+
+	metadata, err = handle.GetSlicesMetadata(
+		request.Linenos,
+		axis,
+		request.Bounds,
+		request.Lod,
+	)
+	if err != nil {
+		return
+	}
+
+	data, err = handle.GetSlices(
+		request.Linenos,
+		axis,
+		request.Bounds,
+		request.Lod,
+	)
+	if err != nil {
+		return
+	}
+
+	return data, metadata, nil
+}
@@ -155,6 +155,19 @@ func TestSliceGivesUniqueHash(t *testing.T) {
 				[]string{"vds", "vds1"},
 				[]string{"sas", "sas"}, "subtraction", "inline", 10),
 		},
+		{
+			name: "Lod differ",
+			request1: newSliceRequest(
+				[]string{"vds"},
+				[]string{"sas"}, "", "inline", 10),
+			request2: func() SliceRequest {
+				request := newSliceRequest(
+					[]string{"vds"},
+					[]string{"sas"}, "", "inline", 10)
+				request.Lod = 1
+				return request
+			}(),
+		},
 	}
 
 	for _, testCase := range testCases {
@@ -174,3 +187,27 @@ func TestSliceGivesUniqueHash(t *testing.T) {
 		)
 	}
 }
+
+func newSlicesRequest(sas string, linenos []int) SlicesRequest {
+	return SlicesRequest{
+		RequestedResource: RequestedResource{
+			Vds: []string{"vds"},
+			Sas: []string{sas},
+		},
+		Direction: "inline",
+		Linenos:   linenos,
+	}
+}
+
+func TestSlicesHash(t *testing.T) {
+	hash1, err := newSlicesRequest("some-sas", []int{1, 2, 3}).hash()
+	require.NoError(t, err)
+
+	hash2, err := newSlicesRequest("different-sas", []int{1, 2, 3}).hash()
+	require.NoError(t, err)
+	require.Equal(t, hash1, hash2, "Expected sas to be omitted from hash")
+
+	hash3, err := newSlicesRequest("some-sas", []int{3, 2, 1}).hash()
+	require.NoError(t, err)
+	require.NotEqual(t, hash1, hash3, "Expected order of linenos to matter")
+}
@@ -24,6 +24,14 @@ type opts struct {
 	storageAccounts   string
 	port              uint32
 	cacheSize         uint64
+	brickCacheSize    uint32
+	sliceCacheSize    uint32
+	handlePoolIdle    uint32
+	handlePoolSize    uint32
+	prefetchDepth     uint32
+	prefetchSize      uint32
+	attributeMemory   uint32
+	threads           uint32
 	metrics           bool
 	metricsPort       uint32
 	trustedProxies    []string
@@ -91,6 +99,14 @@ func parseopts() opts {
 		storageAccounts:   parseAsString("", os.Getenv("ONESEISMIC_API_STORAGE_ACCOUNTS")),
 		port:              parseAsUint32(8080, os.Getenv("ONESEISMIC_API_PORT")),
 		cacheSize:         parseAsUint64(0, os.Getenv("ONESEISMIC_API_CACHE_SIZE")),
+		brickCacheSize:    parseAsUint32(0, os.Getenv("ONESEISMIC_API_BRICK_CACHE_SIZE")),
+		sliceCacheSize:    parseAsUint32(0, os.Getenv("ONESEISMIC_API_SLICE_CACHE_SIZE")),
+		handlePoolIdle:    parseAsUint32(0, os.Getenv("ONESEISMIC_API_HANDLE_POOL_IDLE")),
+		handlePoolSize:    parseAsUint32(64, os.Getenv("ONESEISMIC_API_HANDLE_POOL_SIZE")),
+		prefetchDepth:     parseAsUint32(0, os.Getenv("ONESEISMIC_API_PREFETCH_DEPTH")),
+		prefetchSize:      parseAsUint32(256, os.Getenv("ONESEISMIC_API_PREFETCH_SIZE")),
+		attributeMemory:   parseAsUint32(0, os.Getenv("ONESEISMIC_API_ATTRIBUTE_MEMORY")),
+		threads:           parseAsUint32(0, os.Getenv("ONESEISMIC_API_THREADS")),
 		metrics:           parseAsBool(false, os.Getenv("ONESEISMIC_API_METRICS")),
 		metricsPort:       parseAsUint32(8081, os.Getenv("ONESEISMIC_API_METRICS_PORT")),
 		trustedProxies:    parseAsListOfStrings(nil, os.Getenv("ONESEISMIC_API_TRUSTED_PROXIES")),
@@ -127,6 +143,96 @@ func parseopts() opts {
 		"int",
 	)
 
+	getopt.FlagLong(
+		&opts.brickCacheSize,
+		"brick-cache-size",
+		0,
+		"Max size of the cache of decoded data. In megabytes. Unlike the\n"+
+			"response cache, cached data is shared between requests that only\n"+
+			"partially overlap. A value of zero disables the cache. Defaults to 0.\n"+
+			"Must hold at least 16 bricks, i.e. 16 megabytes for the default\n"+
+			"64^3 bricks, for any data to be cached.\n"+
+			"Can also be set by environment variable 'ONESEISMIC_API_BRICK_CACHE_SIZE'",
+		"int",
+	)
+
+	getopt.FlagLong(
+		&opts.sliceCacheSize,
+		"slice-cache-size",
+		0,
+		"Max size of the cache of full slices. In megabytes. Slices with bounds\n"+
+			"are cut out of a cached full slice of the same line. A value of zero\n"+
+			"disables the cache. Defaults to 0.\n"+
+			"Can also be set by environment variable 'ONESEISMIC_API_SLICE_CACHE_SIZE'",
+		"int",
+	)
+
+	getopt.FlagLong(
+		&opts.handlePoolIdle,
+		"handle-pool-idle",
+		0,
+		"Number of seconds an opened VDS is kept open after it was last used,\n"+
+			"so that following requests to the same VDS can reuse it. A value of\n"+
+			"zero disables the handle pool. Defaults to 0.\n"+
+			"Can also be set by environment variable 'ONESEISMIC_API_HANDLE_POOL_IDLE'",
+		"int",
+	)
+
+	getopt.FlagLong(
+		&opts.handlePoolSize,
+		"handle-pool-size",
+		0,
+		"Max number of opened VDS kept in the handle pool. Defaults to 64.\n"+
+			"Ignored if the handle pool is disabled (see --handle-pool-idle)\n"+
+			"Can also be set by environment variable 'ONESEISMIC_API_HANDLE_POOL_SIZE'",
+		"int",
+	)
+
+	getopt.FlagLong(
+		&opts.prefetchDepth,
+		"prefetch-depth",
+		0,
+		"Number of slices to read ahead when slices of a VDS are requested in\n"+
+			"sequence, e.g. when scrolling through inlines. Only effective when\n"+
+			"the handle pool is enabled (see --handle-pool-idle). A value of zero\n"+
+			"disables prefetching. Defaults to 0.\n"+
+			"Can also be set by environment variable 'ONESEISMIC_API_PREFETCH_DEPTH'",
+		"int",
+	)
+
+	getopt.FlagLong(
+		&opts.prefetchSize,
+		"prefetch-size",
+		0,
+		"Max size of the prefetched slices kept per VDS. In megabytes.\n"+
+			"Defaults to 256.\n"+
+			"Ignored if prefetching is disabled (see --prefetch-depth)\n"+
+			"Can also be set by environment variable 'ONESEISMIC_API_PREFETCH_SIZE'",
+		"int",
+	)
+
+	getopt.FlagLong(
+		&opts.attributeMemory,
+		"attribute-memory",
+		0,
+		"Max size of the seismic data held by a single attribute request. In\n"+
+			"megabytes. The data is then fetched and computed in tiles, each\n"+
+			"released when done, instead of all at once. A value of zero\n"+
+			"disables tiling. Defaults to 0.\n"+
+			"Can also be set by environment variable 'ONESEISMIC_API_ATTRIBUTE_MEMORY'",
+		"int",
+	)
+
+	getopt.FlagLong(
+		&opts.threads,
+		"threads",
+		0,
+		"Number of threads attributes are computed on, shared by all requests.\n"+
+			"A value of zero gives one thread per CPU core. Defaults to 0.\n"+
+			"Can also be set by environment variable 'ONESEISMIC_API_THREADS'",
+		"int",
+	)
+
 	getopt.FlagLong(
 		&opts.metrics,
 		"metrics",
@@ -208,6 +314,9 @@ func setupApp(app *gin.Engine, endpoint *handlers.Endpoint, metric *metrics.Metr
 	seismic.GET("slice", endpoint.SliceGet)
 	seismic.POST("slice", endpoint.SlicePost)
 
+	seismic.GET("slices", endpoint.SlicesGet)
+	seismic.POST("slices", endpoint.SlicesPost)
+
 	seismic.GET("fence", endpoint.FenceGet)
 	seismic.POST("fence", endpoint.FencePost)
 
@@ -234,6 +343,33 @@ func main() {
 
 	storageAccounts := strings.Split(opts.storageAccounts, ",")
 
+	err := core.ConfigureHandlePool(opts.handlePoolIdle, opts.handlePoolSize)
+	if err != nil {
+		panic(err)
+	}
+
+	err = core.ConfigureBrickCache(opts.brickCacheSize)
+	if err != nil {
+		panic(err)
+	}
+
+	err = core.ConfigureSliceCache(opts.sliceCacheSize)
+	if err != nil {
+		panic(err)
+	}
+
+	err = core.ConfigurePrefetch(opts.prefetchDepth, opts.prefetchSize)
+	if err != nil {
+		panic(err)
+	}
+
+	core.ConfigureAttributeMemory(opts.attributeMemory)
+
+	err = core.ConfigureThreadPool(opts.threads)
+	if err != nil {
+		panic(err)
+	}
+
 	endpoint := handlers.Endpoint{
 		MakeVdsConnection: core.MakeAzureConnection(storageAccounts),
 		Cache:             cache.NewCache(opts.cacheSize),
@@ -241,7 +377,7 @@ func main() {
 
 	app := gin.New()
 
-	err := app.SetTrustedProxies(opts.trustedProxies)
+	err = app.SetTrustedProxies(opts.trustedProxies)
 
 	if err != nil {
 		panic(err)
@@ -250,6 +386,7 @@ func main() {
 	var metric *metrics.Metrics
 	if opts.metrics {
 		metric = metrics.NewMetrics()
+		metric.RegisterPrefetchStatistics(core.PrefetchStatistics)
 		/*
 		 * Host the /metrics endpoint on a different app instance. This is needed
 		 * in order to serve it on a different port, while also giving some benefits
@@ -1,17 +1,265 @@
 #include <algorithm>
 #include <cmath>
-#include <cstring>
-#include <functional>
-#include <numeric>
-#include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
 #include "attribute.hpp"
 #include "regularsurface.hpp"
 
-float Value::compute(
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+namespace {
+
+/*
+ * Running statistics of a segment, with one accumulator per statistic. The
+ * groups are template arguments so that every combination gets its own
+ * loop, with only the accumulators it needs.
+ */
+template< unsigned Groups >
+struct Accumulators {
+    static constexpr bool moments = Groups & SegmentStatistics::MOMENTS;
+    static constexpr bool sign    = Groups & SegmentStatistics::SIGNED;
+    static constexpr bool extrema = Groups & SegmentStatistics::EXTREMA;
+
+    double sum = 0, sumsq = 0, shifted_sum = 0, shifted_sumsq = 0;
+    double sumabs = 0, sumpos = 0, sumneg = 0;
+    std::size_t npos = 0, nneg = 0;
+    double min, max, maxabs;
+    std::size_t min_index = 0, max_index = 0, maxabs_index = 0;
+    double shift;
+
+    explicit Accumulators(double first) noexcept (true)
+        : min(first), max(first), maxabs(std::abs(first)), shift(first)
+    {}
+
+    void add(double x, std::size_t i) noexcept (true) {
+        if constexpr (moments) {
+            sum   += x;
+            sumsq += x * x;
+            double const shifted = x - shift;
+            shifted_sum   += shifted;
+            shifted_sumsq += shifted * shifted;
+        }
+        if constexpr (sign) {
+            sumabs += std::abs(x);
+            if (x > 0) { sumpos += x; ++npos; }
+            if (x < 0) { sumneg += x; ++nneg; }
+        }
+        if constexpr (extrema) {
+            /* Strict comparisons, so that the first occurrence is kept */
+            if (x < min) { min = x; min_index = i; }
+            if (x > max) { max = x; max_index = i; }
+            if (std::abs(x) > maxabs) { maxabs = std::abs(x); maxabs_index = i; }
+        }
+    }
+};
+
+#ifdef __SSE2__
+
+double horizontal_sum(__m128d v) noexcept (true) {
+    return _mm_cvtsd_f64(v) + _mm_cvtsd_f64(_mm_unpackhi_pd(v, v));
+}
+
+/* Lanes of b where mask is set, and of a elsewhere */
+__m128d select(__m128d mask, __m128d a, __m128d b) noexcept (true) {
+    return _mm_or_pd(_mm_and_pd(mask, b), _mm_andnot_pd(mask, a));
+}
+
+/*
+ * Fold the extremum of two lanes and their indices into a single value and
+ * index, keeping the first occurrence. A lane only holds nan when the first
+ * sample is nan, and then both lanes do.
+ */
+template< typename Better >
+void fold_extremum(
+    __m128d values,
+    __m128d indices,
+    double& value,
+    std::size_t& index,
+    Better better
+) noexcept (true) {
+    double v[2], i[2];
+    _mm_storeu_pd(v, values);
+    _mm_storeu_pd(i, indices);
+    value = v[0];
+    index = std::size_t(i[0]);
+    if (better(v[1], value) or (v[1] == value and i[1] < i[0])) {
+        value = v[1];
+        index = std::size_t(i[1]);
+    }
+}
+
+/*
+ * Without -ffast-math the compiler may not reorder floating point
+ * reductions, so the scalar loop is never vectorized. This loop keeps two
+ * lanes per statistic instead, which are only combined at the end. That
+ * changes the order of the additions, but not the precision.
+ *
+ * The min and max instructions return their second operand when the
+ * comparison fails, which makes them match the strict comparisons of the
+ * scalar loop, also for nan. Every lane tracks the index of its own
+ * extrema, as a double, which is exact for any segment that fits in memory.
+ *
+ * @return Number of samples added, which is size rounded down to even
+ */
+template< unsigned Groups >
+std::size_t add_sse2(
+    Accumulators< Groups >& acc,
+    double const* data,
+    std::size_t size
+) noexcept (true) {
+    using A = Accumulators< Groups >;
+
+    __m128d const zero  = _mm_setzero_pd();
+    __m128d const one   = _mm_set1_pd(1.0);
+    __m128d const signs = _mm_set1_pd(-0.0);
+    __m128d const shift = _mm_set1_pd(acc.shift);
+
+    __m128d sum = zero, sumsq = zero, shifted_sum = zero, shifted_sumsq = zero;
+    __m128d sumabs = zero, sumpos = zero, sumneg = zero;
+    __m128d npos = zero, nneg = zero;
+    __m128d min    = _mm_set1_pd(acc.min);
+    __m128d max    = _mm_set1_pd(acc.max);
+    __m128d maxabs = _mm_set1_pd(acc.maxabs);
+    __m128d min_index = zero, max_index = zero, maxabs_index = zero;
+
+    __m128d const two = _mm_set1_pd(2.0);
+    __m128d index = _mm_set_pd(1.0, 0.0);
+
+    std::size_t i = 0;
+    for (; i + 2 <= size; i += 2, index = _mm_add_pd(index, two)) {
+        __m128d const x = _mm_loadu_pd(data + i);
+        if constexpr (A::moments) {
+            __m128d const shifted = _mm_sub_pd(x, shift);
+            sum           = _mm_add_pd(sum, x);
+            sumsq         = _mm_add_pd(sumsq, _mm_mul_pd(x, x));
+            shifted_sum   = _mm_add_pd(shifted_sum, shifted);
+            shifted_sumsq = _mm_add_pd(shifted_sumsq, _mm_mul_pd(shifted, shifted));
+        }
+        if constexpr (A::sign) {
+            sumabs = _mm_add_pd(sumabs, _mm_andnot_pd(signs, x));
+            sumpos = _mm_add_pd(sumpos, _mm_max_pd(x, zero));
+            sumneg = _mm_add_pd(sumneg, _mm_min_pd(x, zero));
+            npos   = _mm_add_pd(npos, _mm_and_pd(_mm_cmpgt_pd(x, zero), one));
+            nneg   = _mm_add_pd(nneg, _mm_and_pd(_mm_cmplt_pd(x, zero), one));
+        }
+        if constexpr (A::extrema) {
+            __m128d const abs = _mm_andnot_pd(signs, x);
+            min_index    = select(_mm_cmplt_pd(x, min),      min_index,    index);
+            max_index    = select(_mm_cmpgt_pd(x, max),      max_index,    index);
+            maxabs_index = select(_mm_cmpgt_pd(abs, maxabs), maxabs_index, index);
+            min    = _mm_min_pd(x, min);
+            max    = _mm_max_pd(x, max);
+            maxabs = _mm_max_pd(abs, maxabs);
+        }
+    }
+
+    acc.sum           += horizontal_sum(sum);
+    acc.sumsq         += horizontal_sum(sumsq);
+    acc.shifted_sum   += horizontal_sum(shifted_sum);
+    acc.shifted_sumsq += horizontal_sum(shifted_sumsq);
+    acc.sumabs        += horizontal_sum(sumabs);
+    acc.sumpos        += horizontal_sum(sumpos);
+    acc.sumneg        += horizontal_sum(sumneg);
+    acc.npos          += std::size_t(horizontal_sum(npos));
+    acc.nneg          += std::size_t(horizontal_sum(nneg));
+
+    /* Both lanes start out at the first sample, so they replace acc */
+    if constexpr (A::extrema) {
+        auto const less    = [](double a, double b) { return a < b; };
+        auto const greater = [](double a, double b) { return a > b; };
+        fold_extremum(min,    min_index,    acc.min,    acc.min_index,    less);
+        fold_extremum(max,    max_index,    acc.max,    acc.max_index,    greater);
+        fold_extremum(maxabs, maxabs_index, acc.maxabs, acc.maxabs_index, greater);
+    }
+
+    return i;
+}
+
+#endif // __SSE2__
+
+template< unsigned Groups >
+void gather_statistics(
+    SegmentStatistics & statistics,
     ResampledSegment const & segment
+) noexcept (true) {
+    double const* data = &*segment.begin();
+    std::size_t const size = segment.size();
+    statistics.size = size;
+
+    Accumulators< Groups > acc(*data);
+
+    std::size_t i = 0;
+#ifdef __SSE2__
+    i = add_sse2(acc, data, size);
+#endif
+    for (; i < size; ++i) {
+        acc.add(data[i], i);
+    }
+
+    statistics.sum           = acc.sum;
+    statistics.sumsq         = acc.sumsq;
+    statistics.shifted_sum   = acc.shifted_sum;
+    statistics.shifted_sumsq = acc.shifted_sumsq;
+    statistics.sumabs        = acc.sumabs;
+    statistics.sumpos        = acc.sumpos;
+    statistics.sumneg        = acc.sumneg;
+    statistics.npos          = acc.npos;
+    statistics.nneg          = acc.nneg;
+    statistics.min           = acc.min;
+    statistics.max           = acc.max;
+    statistics.maxabs        = acc.maxabs;
+    statistics.min_index     = acc.min_index;
+    statistics.max_index     = acc.max_index;
+    statistics.maxabs_index  = acc.maxabs_index;
+}
+
+/*
+ * Call fn with the groups as an integral constant, for all combinations of
+ * the statistics groups
+ */
+template< typename Fn >
+void dispatch_groups(unsigned groups, Fn&& fn) {
+    using S = SegmentStatistics;
+    switch (groups) {
+        case S::NONE:                              return fn(std::integral_constant< unsigned, S::NONE >());
+        case S::MOMENTS:                           return fn(std::integral_constant< unsigned, S::MOMENTS >());
+        case S::SIGNED:                            return fn(std::integral_constant< unsigned, S::SIGNED >());
+        case S::EXTREMA:                           return fn(std::integral_constant< unsigned, S::EXTREMA >());
+        case S::MOMENTS | S::SIGNED:               return fn(std::integral_constant< unsigned, S::MOMENTS | S::SIGNED >());
+        case S::MOMENTS | S::EXTREMA:              return fn(std::integral_constant< unsigned, S::MOMENTS | S::EXTREMA >());
+        case S::SIGNED  | S::EXTREMA:              return fn(std::integral_constant< unsigned, S::SIGNED | S::EXTREMA >());
+        case S::MOMENTS | S::SIGNED | S::EXTREMA:  return fn(std::integral_constant< unsigned, S::MOMENTS | S::SIGNED | S::EXTREMA >());
+        default:
+            throw std::invalid_argument("Unknown statistics groups");
+    }
+}
+
+} // namespace
+
+void SegmentStatistics::gather(
+    ResampledSegment const & segment,
+    unsigned groups
+) noexcept (false) {
+    dispatch_groups(groups, [&](auto groups) {
+        gather_statistics< decltype(groups)::value >(*this, segment);
+    });
+}
+
+double SegmentStatistics::variance() const noexcept (true) {
+    double const n = this->size;
+    double const variance =
+        (this->shifted_sumsq - this->shifted_sum * this->shifted_sum / n) / n;
+    return std::max(variance, 0.0);
+}
+
+float Value::compute(
+    ResampledSegment const & segment,
+    SegmentStatistics const &
 ) noexcept (false) {
     auto ptr = segment.begin();
     std::advance(ptr, segment.reference_index());
@@ -19,138 +267,143 @@ float Value::compute(
 }
 
 float Min::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    return *std::min_element(segment.begin(), segment.end());
+    return statistics.min;
 }
 
 float MinAt::compute(
-    ResampledSegment const & segment) noexcept(false) {
-    auto min_index = std::distance(
-            segment.begin(),
-            std::min_element(segment.begin(), segment.end())
-        );
-    return segment.sample_position_at(min_index);
+    ResampledSegment const & segment,
+    SegmentStatistics const & statistics
+) noexcept (false) {
+    return segment.sample_position_at(statistics.min_index);
 }
 
 float Max::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    return *std::max_element(segment.begin(), segment.end());
+    return statistics.max;
 }
 
 float MaxAt::compute(
-    ResampledSegment const & segment
+    ResampledSegment const & segment,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    auto max_index = std::distance(
-        segment.begin(),
-        std::max_element(segment.begin(), segment.end())
-    );
-    return segment.sample_position_at(max_index);
+    return segment.sample_position_at(statistics.max_index);
 }
 
-namespace {
-
-double max_abs(
-    ResampledSegment const & segment
-){
-    auto max = *std::max_element(segment.begin(), segment.end(),
-    [](const double& a, const double& b) { 
-            return std::abs(a) < std::abs(b); 
-        }
-    );
-    return std::abs(max);
-}
-
-} // namespace
-
 float MaxAbs::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    return max_abs(segment);
+    return statistics.maxabs;
 }
 
 float MaxAbsAt::compute(
-    ResampledSegment const & segment
+    ResampledSegment const & segment,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-
-    auto max_abs_val = max_abs(segment);
-    auto max_abs_index = std::distance(
-        segment.begin(),
-        std::find_if(segment.begin(), segment.end(),
-        [&](const double& val) {
-                return std::abs(val) == max_abs_val;
-            }
-        )
-    );
-
-    return segment.sample_position_at(max_abs_index);
+    return segment.sample_position_at(statistics.maxabs_index);
 }
 
 float Mean::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    double sum = std::accumulate(segment.begin(), segment.end(), 0.0);
-    return sum / segment.size();
+    return statistics.mean();
 }
 
 float MeanAbs::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    double sum = std::accumulate(segment.begin(), segment.end(), 0.0,
-        [](double acc, double x) { return acc + std::abs(x); });
-    return sum / segment.size();
+    return statistics.sumabs / statistics.size;
 }
 
 float MeanPos::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    int count = 0;
-    double sum = std::accumulate(segment.begin(), segment.end(), 0.0,
-        [&](double acc, double x) {
-            if (x > 0) {
-                count ++;
-                return acc + x;
-            }
-            return acc;
-        }
-    );
-    return count > 0 ? sum / count : 0;
+    return statistics.npos > 0 ? statistics.sumpos / statistics.npos : 0;
 }
 
 float MeanNeg::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    int count = 0;
-    double sum = std::accumulate(segment.begin(), segment.end(), 0.0,
-        [&](double acc, double x) {
-            if (x < 0) {
-                count ++;
-                return acc + x;
-            }
-            return acc;
+    return statistics.nneg > 0 ? statistics.sumneg / statistics.nneg : 0;
+}
+
+namespace {
+
+/*
+ * Segments of at most this many samples are insertion sorted, which for so
+ * few samples beats selection
+ */
+constexpr std::size_t small_median_size = 8;
+
+double small_median(
+    ResampledSegment const & segment,
+    std::vector<double>& buffer
+) noexcept (true) {
+    std::size_t const size = segment.size();
+
+    /* Sorted while copied into the buffer */
+    std::size_t n = 0;
+    for (double x : segment) {
+        std::size_t i = n++;
+        for (; i > 0 and buffer[i - 1] > x; --i) {
+            buffer[i] = buffer[i - 1];
         }
-    );
-    return count > 0 ? sum / count : 0;
+        buffer[i] = x;
+    }
+
+    if (size % 2 == 0) {
+        return (buffer[size / 2 - 1] + buffer[size / 2]) / 2;
+    }
+    return buffer[size / 2];
 }
 
+} // namespace
+
 float Median::compute(
-    ResampledSegment const & segment
+    ResampledSegment const & segment,
+    SegmentStatistics const &
 ) noexcept (false) {
+    /*
+     * Segments are bounded by the window, so a buffer per thread soon grows
+     * large enough for every segment and is then reused without allocating.
+     */
+    thread_local std::vector<double> buffer;
+    std::size_t const size = segment.size();
+    if (buffer.size() < size) {
+        buffer.resize(size);
+    }
+
+    if (size <= small_median_size) {
+        return small_median(segment, buffer);
+    }
+
     /*
     The std::nth_element function sets the middle element of a vector in such a
     manner that all values on the right side of the middle element are greater
     than or equal to it, and all elements preceding the middle are less than or
     equal to the middle. With this approach, we don't need to sort the entire
-    vector. In the case of even number of elements in the vector, we use
-    std::max_element to obtain the largest element before the middle element to
-    compute the average.
+    vector. In the case of even number of elements in the vector, the largest
+    element before the middle is the other middle element, found by scanning
+    the left half. A selection that tracks that element while partitioning
+    was measured to be slower than this for the segment sizes we see.
     */
-    auto temp = std::vector<double>(segment.begin(), segment.end());
-    const auto middle_right = temp.begin() + segment.size() / 2;
-    std::nth_element(temp.begin(), middle_right, temp.end());
-    if (segment.size() % 2 == 0) {
-        const auto max_left = std::max_element(temp.begin(), middle_right);
+    auto const begin = buffer.begin();
+    auto const end = begin + size;
+    std::copy(segment.begin(), segment.end(), begin);
+
+    auto const middle_right = begin + size / 2;
+    std::nth_element(begin, middle_right, end);
+    if (size % 2 == 0) {
+        const auto max_left = std::max_element(begin, middle_right);
         return (*max_left + *middle_right) / 2;
     }
     else {
@@ -159,67 +412,47 @@ float Median::compute(
 }
 
 float Rms::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    float sum = std::accumulate(segment.begin(), segment.end(), 0.0,
-        [](double a, double b) {
-            return a + std::pow(b, 2);
-        }
-    );
-    return std::sqrt(sum / segment.size());
+    return std::sqrt(statistics.sumsq / statistics.size);
 }
 
-namespace {
-
-double variance(
-    ResampledSegment const & segment
-){
-    double sum = std::accumulate(segment.begin(), segment.end(), 0.0);
-    double mean = sum / segment.size();
-    double stdSum = std::accumulate(segment.begin(), segment.end(), 0.0,
-        [&](double a, double b){ return a + std::pow(b - mean, 2); }
-    );
-    return stdSum / segment.size();
-}
-
-} // namespace
-
 float Var::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    return variance(segment);
+    return statistics.variance();
 }
 
 float Sd::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    return std::sqrt(variance(segment));
+    return std::sqrt(statistics.variance());
 }
 
 float SumPos::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    double sum = 0.0;
-    std::for_each(segment.begin(), segment.end(), [&](double x) {
-         if (x > 0) { sum += x; }
-    });
-    return sum; 
+    return statistics.sumpos;
 }
 
 float SumNeg::compute(
-    ResampledSegment const & segment
+    ResampledSegment const &,
+    SegmentStatistics const & statistics
 ) noexcept (false) {
-    double sum = 0.0;
-    std::for_each(segment.begin(), segment.end(), [&](double x) {
-         if (x < 0) { sum += x; }
-    });
-    return sum;
+    return statistics.sumneg;
 }
 
-void calc_attributes(
+namespace {
+
+template< unsigned Groups >
+void compute_attributes(
     SurfaceBoundedSubVolume const& src_subvolume,
     ResampledSegmentBlueprint const* dst_segment_blueprint,
-    std::vector< std::unique_ptr< AttributeMap > >& attrs,
+    std::vector< AttributeMap >& attrs,
     std::size_t from,
     std::size_t to
 ) noexcept (false) {
@@ -227,22 +460,56 @@ void calc_attributes(
 
     RawSegment src_segment = src_subvolume.vertical_segment(from);
     ResampledSegment dst_segment =  ResampledSegment(0, 0, 0, dst_segment_blueprint);
+    ResampleScratch scratch;
+    SegmentStatistics statistics;
 
     for (std::size_t i = from; i < to; ++i) {
         if (src_subvolume.is_empty(i)) {
             for (auto& attr : attrs) {
-                attr->write(fill, i);
+                attr.data()[i] = fill;
             }
             continue;
         }
 
         src_subvolume.reinitialize(i, src_segment);
         src_subvolume.reinitialize(i, dst_segment);
-        resample(src_segment, dst_segment);
+        resample(src_segment, dst_segment, scratch);
+
+        if constexpr (Groups != SegmentStatistics::NONE) {
+            gather_statistics< Groups >(statistics, dst_segment);
+        }
 
         for (auto& attr : attrs) {
-            auto value = attr->compute(dst_segment);
-            attr->write(value, i);
+            attr.data()[i] = std::visit(
+                [&](auto const& attribute) {
+                    return attribute.compute(dst_segment, statistics);
+                },
+                attr.attribute()
+            );
+        }
+    }
+}
+
+} // namespace
+
+void calc_attributes(
+    SurfaceBoundedSubVolume const& src_subvolume,
+    ResampledSegmentBlueprint const* dst_segment_blueprint,
+    std::vector< AttributeMap >& attrs,
+    std::size_t from,
+    std::size_t to
+) noexcept (false) {
+    unsigned groups = SegmentStatistics::NONE;
+    for (auto const& attr : attrs) {
+        if (to * sizeof(float) > attr.size()) {
+            throw std::out_of_range("Attempting write outside attribute buffer");
         }
+        groups |= attr.statistics();
     }
+
+    dispatch_groups(groups, [&](auto groups) {
+        compute_attributes< decltype(groups)::value >(
+            src_subvolume, dst_segment_blueprint, attrs, from, to
+        );
+    });
 }
@@ -3,166 +3,284 @@
 
 #include "regularsurface.hpp"
 #include "subvolume.hpp"
-#include <memory>
 #include <stdexcept>
+#include <variant>
+#include <vector>
 
-/* Base class for attribute calculations
+/* Statistics of a segment that attributes are derived from
  *
- * The base class main role is to centralize buffer writes such that
- * implementations of new attributes, in the form of derived classes, don't
- * have to deal with pointer arithmetic.
+ * All statistics needed by the requested attributes are gathered in a single
+ * pass over the segment, rather than every attribute walking the segment on
+ * its own. Requesting many attributes then costs about as much as requesting
+ * one. Only the groups of statistics that are asked for are gathered.
  */
-class AttributeMap {
-public:
-    AttributeMap(void* dst, std::size_t size) : dst(dst), size(size) {};
+struct SegmentStatistics {
+    enum group : unsigned {
+        NONE    = 0,
+        /* sum, sum of squares and the shifted sums used for variance */
+        MOMENTS = 1 << 0,
+        /* sums and counts of the positive, negative and absolute values */
+        SIGNED  = 1 << 1,
+        /* min, max and max absolute value, and where they first occur */
+        EXTREMA = 1 << 2,
+    };
 
-    virtual float compute(ResampledSegment const & segment) noexcept (false) = 0;
+    void gather(ResampledSegment const & segment, unsigned groups) noexcept (false);
 
-    void write(float value, std::size_t index) {
-        std::size_t offset = index * sizeof(float);
+    double mean() const noexcept (true) { return this->sum / this->size; }
 
-        if (offset >= this->size) {
-            throw std::out_of_range("Attempting write outside attribute buffer");
-        }
+    /* Population variance */
+    double variance() const noexcept (true);
 
-        memcpy((char*)this->dst + offset, &value, sizeof(float));
-    }
-
-    virtual ~AttributeMap() {};
-private:
-    void*       dst;
     std::size_t size;
+
+    double sum;
+    double sumsq;
+    /*
+     * Sums of the values shifted by the first value. The variance is computed
+     * from these in a single pass without the cancellation that plain sums of
+     * squares suffer from.
+     */
+    double shifted_sum;
+    double shifted_sumsq;
+
+    double sumabs;
+    double sumpos;
+    double sumneg;
+    std::size_t npos;
+    std::size_t nneg;
+
+    double min;
+    double max;
+    double maxabs;
+    std::size_t min_index;
+    std::size_t max_index;
+    std::size_t maxabs_index;
 };
 
-struct Value final : public AttributeMap {
-    Value(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+/* Attribute kernels
+ *
+ * Every attribute is a stateless kernel that derives its value for a single
+ * segment from the segment and its statistics. Kernels are not virtual, but
+ * alternatives of the Attribute variant, so that the per-segment loop in
+ * calc_attributes can inline them. The statistics groups a kernel reads are
+ * given by its static member groups, see SegmentStatistics.
+ */
+struct Value final {
+    static constexpr unsigned groups = SegmentStatistics::NONE;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
+struct Min final {
+    static constexpr unsigned groups = SegmentStatistics::EXTREMA;
 
-class Min final : public AttributeMap {
-public:
-    Min(void* dst, std::size_t size) : AttributeMap(dst, size) {}
-
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class MinAt final : public AttributeMap {
-public:
-    MinAt(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct MinAt final {
+    static constexpr unsigned groups = SegmentStatistics::EXTREMA;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class Max final : public AttributeMap {
-public:
-    Max(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct Max final {
+    static constexpr unsigned groups = SegmentStatistics::EXTREMA;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class MaxAt final : public AttributeMap {
-public:
-    MaxAt(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct MaxAt final {
+    static constexpr unsigned groups = SegmentStatistics::EXTREMA;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class MaxAbs final : public AttributeMap {
-public:
-    MaxAbs(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct MaxAbs final {
+    static constexpr unsigned groups = SegmentStatistics::EXTREMA;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class MaxAbsAt final : public AttributeMap {
-public:
-    MaxAbsAt(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct MaxAbsAt final {
+    static constexpr unsigned groups = SegmentStatistics::EXTREMA;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class Mean final : public AttributeMap {
-public:
-    Mean(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct Mean final {
+    static constexpr unsigned groups = SegmentStatistics::MOMENTS;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class MeanAbs final : public AttributeMap {
-public:
-    MeanAbs(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct MeanAbs final {
+    static constexpr unsigned groups = SegmentStatistics::SIGNED;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class MeanPos final : public AttributeMap {
-public:
-    MeanPos(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct MeanPos final {
+    static constexpr unsigned groups = SegmentStatistics::SIGNED;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class MeanNeg final : public AttributeMap {
-public:
-    MeanNeg(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct MeanNeg final {
+    static constexpr unsigned groups = SegmentStatistics::SIGNED;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class Median final : public AttributeMap {
-public:
-    Median(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct Median final {
+    static constexpr unsigned groups = SegmentStatistics::NONE;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class Rms final : public AttributeMap {
-public:
-    Rms(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct Rms final {
+    static constexpr unsigned groups = SegmentStatistics::MOMENTS;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
 /* Calculated the population variance as we are interested in variance strictly
  * for the data defined by each window.
  */
-class Var final : public AttributeMap {
-public:
-    Var(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct Var final {
+    static constexpr unsigned groups = SegmentStatistics::MOMENTS;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
 /* Calculated the population standard deviation as we are interested in
  * standard deviation strictly for the data defined by each window.
  */
-class Sd final : public AttributeMap {
-public:
-    Sd(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct Sd final {
+    static constexpr unsigned groups = SegmentStatistics::MOMENTS;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class SumPos final : public AttributeMap {
-public:
-    SumPos(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+struct SumPos final {
+    static constexpr unsigned groups = SegmentStatistics::SIGNED;
+
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
+};
+
+struct SumNeg final {
+    static constexpr unsigned groups = SegmentStatistics::SIGNED;
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    static float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) noexcept (false);
 };
 
-class SumNeg final : public AttributeMap {
+using Attribute = std::variant<
+    Value,
+    Min,
+    MinAt,
+    Max,
+    MaxAt,
+    MaxAbs,
+    MaxAbsAt,
+    Mean,
+    MeanAbs,
+    MeanPos,
+    MeanNeg,
+    Median,
+    Rms,
+    Var,
+    Sd,
+    SumPos,
+    SumNeg
+>;
+
+/* An attribute and the buffer its values are written to
+ *
+ * The buffer holds one float per position in the horizontal plane. Writes are
+ * checked against the buffer size once per call to calc_attributes, rather
+ * than for every value.
+ */
+class AttributeMap {
 public:
-    SumNeg(void* dst, std::size_t size) : AttributeMap(dst, size) {}
+    AttributeMap(Attribute attribute, void* dst, std::size_t size)
+        : m_attribute(attribute), m_dst(static_cast< float* >(dst)), m_size(size)
+    {}
 
-    float compute(ResampledSegment const & segment) noexcept (false) override;
+    Attribute const& attribute() const noexcept (true) { return this->m_attribute; }
+
+    unsigned statistics() const noexcept (true) {
+        return std::visit(
+            [](auto const& attribute) { return attribute.groups; },
+            this->m_attribute
+        );
+    }
+
+    float* data() noexcept (true) { return this->m_dst; }
+
+    /* Size of the buffer in bytes */
+    std::size_t size() const noexcept (true) { return this->m_size; }
+
+private:
+    Attribute   m_attribute;
+    float*      m_dst;
+    std::size_t m_size;
 };
 
 void calc_attributes(
     SurfaceBoundedSubVolume const& src_subvolume,
     ResampledSegmentBlueprint const* dst_segment_blueprint,
-    std::vector< std::unique_ptr< AttributeMap > >& attrs,
+    std::vector< AttributeMap >& attrs,
     std::size_t from,
     std::size_t to
 ) noexcept (false);
@@ -65,3 +65,17 @@ float Axis::to_sample_position(float coordinate) noexcept(false) {
     return this->m_axis_descriptor.CoordinateToSamplePosition(coordinate);
 }
 
+void Axis::to_sample_positions(
+    double* coordinates,
+    std::size_t npoints
+) const noexcept(true) {
+    /*
+     * Go through OpenVDS in float, exactly like to_sample_position, so that
+     * nearest interpolation picks the same sample on x.5 boundaries
+     */
+    for (std::size_t i = 0; i < npoints; ++i) {
+        coordinates[i] = this->m_axis_descriptor.CoordinateToSamplePosition(
+            float(coordinates[i])
+        );
+    }
+}
@@ -1,6 +1,7 @@
 #ifndef ONESEISMIC_API_AXIS_HPP
 #define ONESEISMIC_API_AXIS_HPP
 
+#include <cstddef>
 #include <memory>
 #include <string>
 
@@ -43,6 +44,12 @@ public:
     bool inrange_with_margin(float coordinate) const noexcept(true);
     float to_sample_position(float coordinate) noexcept(false);
 
+    /**
+     * Same as to_sample_position, for npoints coordinates at a time,
+     * converted in place. The results are identical to to_sample_position.
+     */
+    void to_sample_positions(double* coordinates, std::size_t npoints) const noexcept(true);
+
 private:
     const float m_min;
     const float m_max;
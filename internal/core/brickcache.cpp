@@ -0,0 +1,103 @@
+#include "brickcache.hpp"
+
+#include <functional>
+#include <mutex>
+
+BrickCache& BrickCache::instance() noexcept (true) {
+    static BrickCache cache;
+    return cache;
+}
+
+std::size_t BrickCache::KeyHash::operator()(
+    Key const& key
+) const noexcept (true) {
+    std::size_t hash = std::hash< std::string >()(key.vds);
+    auto combine = [&hash](int value) {
+        hash ^= std::hash< int >()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    combine(key.lod);
+    for (int index : key.index) combine(index);
+    return hash;
+}
+
+void BrickCache::configure(std::size_t max_bytes) noexcept (true) {
+    this->m_max_bytes = max_bytes;
+    for (auto& shard : this->m_shards) {
+        std::lock_guard< std::mutex > lock(shard.mutex);
+        evict(shard, max_bytes / nshards);
+    }
+}
+
+bool BrickCache::enabled() const noexcept (true) {
+    return this->m_max_bytes != 0;
+}
+
+bool BrickCache::fits(std::size_t bytes) const noexcept (true) {
+    std::size_t const max_bytes = this->m_max_bytes;
+    return max_bytes != 0 and bytes <= max_bytes / nshards;
+}
+
+BrickCache::Brick BrickCache::find(Key const& key) noexcept (true) {
+    Shard& shard = this->shard(key);
+    std::lock_guard< std::mutex > lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) return nullptr;
+
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    return it->second->second;
+}
+
+void BrickCache::insert(Key const& key, Brick brick) noexcept (false) {
+    std::size_t const max_bytes = this->m_max_bytes / nshards;
+    std::size_t const bytes = brick->size() * sizeof(float);
+    if (bytes > max_bytes) return;
+
+    Shard& shard = this->shard(key);
+    std::lock_guard< std::mutex > lock(shard.mutex);
+
+    /*
+     * Concurrent requests missing the same brick both read it. The brick that
+     * is already in the cache is kept, as other requests may be using it.
+     */
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+
+    shard.entries.emplace_front(key, std::move(brick));
+    shard.index.emplace(key, shard.entries.begin());
+    shard.bytes += bytes;
+
+    evict(shard, max_bytes);
+}
+
+void BrickCache::clear() noexcept (true) {
+    for (auto& shard : this->m_shards) {
+        std::lock_guard< std::mutex > lock(shard.mutex);
+        evict(shard, 0);
+    }
+}
+
+std::size_t BrickCache::size() const noexcept (true) {
+    std::size_t size = 0;
+    for (auto const& shard : this->m_shards) {
+        std::lock_guard< std::mutex > lock(shard.mutex);
+        size += shard.bytes;
+    }
+    return size;
+}
+
+BrickCache::Shard& BrickCache::shard(Key const& key) noexcept (true) {
+    return this->m_shards[KeyHash()(key) % nshards];
+}
+
+void BrickCache::evict(Shard& shard, std::size_t max_bytes) noexcept (true) {
+    while (shard.bytes > max_bytes) {
+        auto const& last = shard.entries.back();
+        shard.bytes -= last.second->size() * sizeof(float);
+        shard.index.erase(last.first);
+        shard.entries.pop_back();
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef ONESEISMIC_API_BRICKCACHE_HPP
+#define ONESEISMIC_API_BRICKCACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Process-wide cache of decoded bricks.
+ *
+ * A brick is one of the blocks of float samples the VDS is stored in, on a
+ * fixed grid over the three first dimensions of a VDS, at a given level of
+ * detail. The brick size is taken from the layout of the VDS. Bricks on the
+ * edge of the volume are cut to fit. Samples are stored with dimension 0 as
+ * the fastest varying, the same layout as the buffers OpenVDS returns.
+ *
+ * Unlike a cache of whole responses, requests that only partially overlap
+ * share whatever bricks they have in common, e.g. neighbouring slices, or a
+ * fence crossing a slice.
+ *
+ * Bricks are keyed on the url of the VDS. Callers must only look up bricks
+ * of a VDS they have already successfully opened, i.e. one their credentials
+ * give access to.
+ *
+ * The cache is split in shards with a lock each, and each shard evicts its
+ * least recently used bricks when it grows past its share of the byte
+ * budget. The cache is disabled (budget of 0) by default.
+ */
+class BrickCache {
+public:
+    struct Key {
+        std::string vds;
+        int lod;
+        std::array< int, 3 > index;
+
+        bool operator==(Key const& other) const noexcept (true) {
+            return this->lod   == other.lod
+                and this->index == other.index
+                and this->vds   == other.vds;
+        }
+    };
+
+    using Brick = std::shared_ptr< std::vector< float > const >;
+
+    static BrickCache& instance() noexcept (true);
+
+    /**
+     * Configure the cache.
+     *
+     * @param max_bytes Max total size of the cached bricks. Zero disables the
+     * cache and drops all bricks.
+     */
+    void configure(std::size_t max_bytes) noexcept (true);
+
+    bool enabled() const noexcept (true);
+
+    /**
+     * Whether bricks of bytes can be cached at all, i.e. fit in a shard's
+     * share of the budget. Reads of VDSs with bricks that do not fit should
+     * go straight to OpenVDS.
+     */
+    bool fits(std::size_t bytes) const noexcept (true);
+
+    /** Get brick, or nullptr if it is not in the cache */
+    Brick find(Key const& key) noexcept (true);
+
+    void insert(Key const& key, Brick brick) noexcept (false);
+
+    /** Drop all bricks */
+    void clear() noexcept (true);
+
+    /** Total size of the cached bricks in bytes */
+    std::size_t size() const noexcept (true);
+
+private:
+    BrickCache() = default;
+
+    struct KeyHash {
+        std::size_t operator()(Key const& key) const noexcept (true);
+    };
+
+    using Entries = std::list< std::pair< Key, Brick > >;
+
+    /* Most recently used bricks first */
+    struct Shard {
+        mutable std::mutex mutex;
+        Entries entries;
+        std::unordered_map< Key, Entries::iterator, KeyHash > index;
+        std::size_t bytes = 0;
+    };
+
+    static constexpr std::size_t nshards = 16;
+
+    Shard& shard(Key const& key) noexcept (true);
+    static void evict(Shard& shard, std::size_t max_bytes) noexcept (true);
+
+    std::array< Shard, nshards > m_shards;
+    std::atomic< std::size_t > m_max_bytes{0};
+};
+
+#endif /* ONESEISMIC_API_BRICKCACHE_HPP */
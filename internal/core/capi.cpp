@@ -1,10 +1,17 @@
 #include "ctypes.h"
 #include "capi.h"
 
+#include <atomic>
+
 #include "cppapi.hpp"
 
+#include "brickcache.hpp"
+#include "datahandlepool.hpp"
 #include "exceptions.hpp"
+#include "prefetcher.hpp"
+#include "slicecache.hpp"
 #include "subvolume.hpp"
+#include "threadpool.hpp"
 
 response response_create() {
     return response{nullptr, 0};
@@ -64,7 +71,9 @@ int single_datahandle_new(
     try {
         if (not ds_out) throw detail::nullptr_error("Invalid out pointer");
 
-        *ds_out = new SingleDataHandle(make_single_datahandle(url, credentials));
+        *ds_out = new SingleDataHandle(
+            DataHandlePool::instance().acquire(url, credentials)
+        );
         return STATUS_OK;
     } catch (...) {
         return handle_exception(ctx, std::current_exception());
@@ -84,7 +93,100 @@ int double_datahandle_new(
         if (not datahandle)
             throw detail::nullptr_error("Invalid datahandle pointer");
 
-        *datahandle = new DoubleDataHandle(make_double_datahandle(url_A, credentials_A, url_B, credentials_B, bin_operator));
+        auto& pool = DataHandlePool::instance();
+        *datahandle = new DoubleDataHandle(
+            pool.acquire(url_A, credentials_A),
+            pool.acquire(url_B, credentials_B),
+            bin_operator
+        );
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int datahandle_pool_configure(
+    Context* ctx,
+    size_t max_idle,
+    size_t max_size
+) {
+    try {
+        DataHandlePool::instance().configure(
+            std::chrono::seconds(max_idle),
+            max_size
+        );
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int brick_cache_configure(Context* ctx, size_t max_size) {
+    try {
+        BrickCache::instance().configure(max_size * 1024 * 1024);
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int slice_cache_configure(Context* ctx, size_t max_size) {
+    try {
+        SliceCache::instance().configure(max_size * 1024 * 1024);
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int thread_pool_configure(Context* ctx, size_t nthreads) {
+    try {
+        ThreadPool::instance().configure(nthreads);
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int thread_pool_size(Context* ctx, size_t* nthreads) {
+    try {
+        if (not nthreads) throw detail::nullptr_error("Invalid out pointer");
+
+        *nthreads = ThreadPool::instance().size();
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int prefetch_configure(
+    Context* ctx,
+    size_t depth,
+    size_t max_size
+) {
+    try {
+        SlicePrefetcher::configure(depth, max_size * 1024 * 1024);
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int prefetch_statistics(
+    Context* ctx,
+    size_t* hits,
+    size_t* misses,
+    size_t* waste
+) {
+    try {
+        if (not hits)   throw detail::nullptr_error("Invalid out pointer");
+        if (not misses) throw detail::nullptr_error("Invalid out pointer");
+        if (not waste)  throw detail::nullptr_error("Invalid out pointer");
+
+        auto const statistics = SlicePrefetcher::statistics();
+        *hits   = statistics.hits;
+        *misses = statistics.misses;
+        *waste  = statistics.waste;
         return STATUS_OK;
     } catch (...) {
         return handle_exception(ctx, std::current_exception());
@@ -132,6 +234,23 @@ int regular_surface_new(
     }
 }
 
+int regular_surface_shifted(
+    Context* ctx,
+    RegularSurface* surface,
+    float offset,
+    RegularSurface** out
+) {
+    try {
+        if (not surface) throw detail::nullptr_error("Invalid surface");
+        if (not out) throw detail::nullptr_error("Invalid out pointer");
+
+        *out = new RegularSurface(surface->shifted(offset));
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
 int regular_surface_free(Context* ctx, RegularSurface* surface) {
     try {
         if (not surface) return STATUS_OK;
@@ -199,6 +318,7 @@ int slice(
     axis_name ax,
     struct Bound* bounds,
     size_t nbounds,
+    int lod,
     response* out
 ) {
     try {
@@ -215,7 +335,45 @@ int slice(
             bounds++;
         }
 
-        cppapi::slice(*datahandle, direction, lineno, slice_bounds, out);
+        cppapi::slice(*datahandle, direction, lineno, slice_bounds, lod, out);
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int slices(
+    Context* ctx,
+    DataHandle* datahandle,
+    const int* linenos,
+    size_t nlinenos,
+    axis_name ax,
+    struct Bound* bounds,
+    size_t nbounds,
+    int lod,
+    response* out
+) {
+    try {
+        if (not out)
+            throw detail::nullptr_error("Invalid out pointer");
+        if (not datahandle)
+            throw detail::nullptr_error("Invalid datahandle");
+        if (not linenos and nlinenos > 0)
+            throw detail::nullptr_error("Invalid linenos");
+
+        Direction const direction(ax);
+
+        std::vector< int > slice_linenos(linenos, linenos + nlinenos);
+        std::vector< Bound > slice_bounds(bounds, bounds + nbounds);
+
+        cppapi::slices(
+            *datahandle,
+            direction,
+            slice_linenos,
+            slice_bounds,
+            lod,
+            out
+        );
         return STATUS_OK;
     } catch (...) {
         return handle_exception(ctx, std::current_exception());
@@ -229,6 +387,7 @@ int slice_metadata(
     axis_name ax,
     struct Bound* bounds,
     size_t nbounds,
+    int lod,
     response* out
 ) {
     try {
@@ -245,7 +404,45 @@ int slice_metadata(
             bounds++;
         }
 
-        cppapi::slice_metadata(*datahandle, direction, lineno, slice_bounds, out);
+        cppapi::slice_metadata(*datahandle, direction, lineno, slice_bounds, lod, out);
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int slices_metadata(
+    Context* ctx,
+    DataHandle* datahandle,
+    const int* linenos,
+    size_t nlinenos,
+    axis_name ax,
+    struct Bound* bounds,
+    size_t nbounds,
+    int lod,
+    response* out
+) {
+    try {
+        if (not out)
+            throw detail::nullptr_error("Invalid out pointer");
+        if (not datahandle)
+            throw detail::nullptr_error("Invalid datahandle");
+        if (not linenos and nlinenos > 0)
+            throw detail::nullptr_error("Invalid linenos");
+
+        Direction const direction(ax);
+
+        std::vector< int > slice_linenos(linenos, linenos + nlinenos);
+        std::vector< Bound > slice_bounds(bounds, bounds + nbounds);
+
+        cppapi::slices_metadata(
+            *datahandle,
+            direction,
+            slice_linenos,
+            slice_bounds,
+            lod,
+            out
+        );
         return STATUS_OK;
     } catch (...) {
         return handle_exception(ctx, std::current_exception());
@@ -260,6 +457,9 @@ int fence(
     size_t npoints,
     enum interpolation_method interpolation_method,
     const float* fillValue,
+    const float* windows,
+    size_t nwindows,
+    int lod,
     response* out
 ) {
     try {
@@ -267,6 +467,8 @@ int fence(
             throw detail::nullptr_error("Invalid out pointer");
         if (not datahandle)
             throw detail::nullptr_error("Invalid datahandle");
+        if (nwindows > 0 and not windows)
+            throw detail::nullptr_error("Invalid windows pointer");
 
         cppapi::fence(
             *datahandle,
@@ -275,6 +477,9 @@ int fence(
             npoints,
             interpolation_method,
             fillValue,
+            windows,
+            nwindows,
+            lod,
             out
         );
         return STATUS_OK;
@@ -287,6 +492,9 @@ int fence_metadata(
     Context* ctx,
     DataHandle* datahandle,
     size_t npoints,
+    const float* windows,
+    size_t nwindows,
+    int lod,
     response* out
 ) {
     try {
@@ -294,8 +502,10 @@ int fence_metadata(
             throw detail::nullptr_error("Invalid out pointer");
         if (not datahandle)
             throw detail::nullptr_error("Invalid datahandle");
+        if (nwindows > 0 and not windows)
+            throw detail::nullptr_error("Invalid windows pointer");
 
-        cppapi::fence_metadata(*datahandle, npoints, out);
+        cppapi::fence_metadata(*datahandle, npoints, windows, nwindows, lod, out);
         return STATUS_OK;
     } catch (...) {
         return handle_exception(ctx, std::current_exception());
@@ -340,6 +550,47 @@ int attribute_metadata(
     }
 }
 
+int subvolume_tile(
+    Context* ctx,
+    SurfaceBoundedSubVolume* subvolume,
+    size_t max_bytes,
+    size_t* ntiles
+) {
+    try {
+        if (not ntiles)
+            throw detail::nullptr_error("Invalid out pointer");
+        if (not subvolume)
+            throw detail::nullptr_error("Invalid subvolume");
+
+        *ntiles = subvolume->tile(max_bytes);
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
+int subvolume_tile_bounds(
+    Context* ctx,
+    SurfaceBoundedSubVolume* subvolume,
+    size_t tile,
+    size_t* from,
+    size_t* to
+) {
+    try {
+        if (not from or not to)
+            throw detail::nullptr_error("Invalid out pointer");
+        if (not subvolume)
+            throw detail::nullptr_error("Invalid subvolume");
+
+        auto const bounds = subvolume->tile_bounds(tile);
+        *from = bounds.first;
+        *to   = bounds.second;
+        return STATUS_OK;
+    } catch (...) {
+        return handle_exception(ctx, std::current_exception());
+    }
+}
+
 int attribute(
     Context* ctx,
     DataHandle* datahandle,
@@ -371,29 +622,74 @@ int attribute(
 
         ResampledSegmentBlueprint dst_segment_blueprint = ResampledSegmentBlueprint(stepsize);
 
-        void* outs[nattributes];
+        std::vector< void* > outs(nattributes);
         for (int i = 0; i < nattributes; ++i) {
             auto offset = src_subvolume->horizontal_grid().size() * sizeof(float) * i;
             outs[i] = static_cast< char* >(out) + offset;
         }
 
-        cppapi::fetch_subvolume(
-            *datahandle,
-            *src_subvolume,
-            interpolation_method,
-            from,
-            to
-        );
+        /*
+         * Split [from, to) into chunks that are computed in parallel. A tiled
+         * subvolume is split on its tiles, so that every tile is fetched,
+         * computed and dropped by a single task. Otherwise a few chunks per
+         * thread leaves room for the pool to even out the load.
+         */
+        std::vector< std::pair< std::size_t, std::size_t > > chunks;
+        if (src_subvolume->ntiles() > 1) {
+            for (std::size_t tile = 0; tile < src_subvolume->ntiles(); ++tile) {
+                auto const bounds = src_subvolume->tile_bounds(tile);
+                std::size_t const begin = std::max(bounds.first, from);
+                std::size_t const end   = std::min(bounds.second, to);
+                if (begin < end) chunks.emplace_back(begin, end);
+            }
+        } else {
+            /*
+             * All chunks share the single tile, so it is allocated here once
+             * rather than by whichever lanes get to read it first
+             */
+            src_subvolume->allocate(0, src_subvolume->horizontal_grid().size());
+
+            std::size_t const nthreads = ThreadPool::instance().size() + 1;
+            chunks = cppapi::partition_subvolume(
+                *src_subvolume,
+                from,
+                to,
+                4 * nthreads,
+                metadata.brick_size()
+            );
+        }
+
+        /*
+         * Every lane pulls chunks off the shared list and reads ahead of the
+         * chunk it computes. Tiles of a tiled subvolume are allocated when
+         * they are read, so only one tile ahead is read per lane.
+         */
+        std::size_t const nlanes =
+            std::min(chunks.size(), ThreadPool::instance().size() + 1);
+        std::size_t const max_depth = src_subvolume->ntiles() > 1 ? 1 : 4;
+
+        std::atomic< std::size_t > next{ 0 };
+        auto next_chunk = [&](std::pair< std::size_t, std::size_t >& chunk) {
+            std::size_t const i = next++;
+            if (i >= chunks.size()) return false;
+            chunk = chunks[i];
+            return true;
+        };
+
+        ThreadPool::instance().parallel_for(nlanes, [&](std::size_t) {
+            cppapi::pipeline_attributes(
+                *datahandle,
+                *src_subvolume,
+                interpolation_method,
+                &dst_segment_blueprint,
+                attributes,
+                nattributes,
+                next_chunk,
+                max_depth,
+                outs.data()
+            );
+        });
 
-        cppapi::attributes(
-            *src_subvolume,
-            &dst_segment_blueprint,
-            attributes,
-            nattributes,
-            from,
-            to,
-            outs
-        );
         return STATUS_OK;
     } catch (...) {
         return handle_exception(ctx, std::current_exception());
@@ -62,6 +62,84 @@ int double_datahandle_new(
     DataHandle** ds_out
 );
 
+/** Configure the pool of opened VDS handles
+ *
+ * single_datahandle_new() and double_datahandle_new() get their VDS handles
+ * from a process-wide pool, keyed on url and credentials. Pooled handles are
+ * shared between all datahandles to the same VDS, and the VDS is only closed
+ * once it is evicted from the pool and every datahandle referring to it is
+ * free'd.
+ *
+ * A handle is evicted from the pool when it has not been requested for
+ * max_idle seconds, or when the pool holds more than max_size handles. The
+ * pool is disabled by default. Setting max_idle to 0 disables it again.
+ */
+int datahandle_pool_configure(
+    Context* ctx,
+    size_t max_idle,
+    size_t max_size
+);
+
+/** Configure the cache of decoded bricks
+ *
+ * Data read from any VDS is cached as decoded bricks of 64^3 samples, shared
+ * by all datahandles and all kinds of requests. Slices are always served
+ * from the cache, fences and attributes only when read with nearest
+ * interpolation. At most max_size megabytes are cached. The cache is
+ * disabled by default. Setting max_size to 0 disables it again.
+ */
+int brick_cache_configure(Context* ctx, size_t max_size);
+
+/** Configure the cache of full slices
+ *
+ * Slices spanning the whole VDS are kept, so that later slices of the same
+ * line, e.g. zooming in on part of an inline, are copied out of them without
+ * reading the VDS again. At most max_size megabytes are cached. The cache is
+ * disabled by default. Setting max_size to 0 disables it again.
+ */
+int slice_cache_configure(Context* ctx, size_t max_size);
+
+/** Configure the thread pool
+ *
+ * Attributes are computed in parallel on a process-wide pool of nthreads
+ * threads, shared by all requests. A value of 0 gives one thread per
+ * hardware thread, which is the default. Waits for running computations to
+ * finish before the threads are replaced.
+ */
+int thread_pool_configure(Context* ctx, size_t nthreads);
+
+/** Number of threads in the thread pool */
+int thread_pool_size(Context* ctx, size_t* nthreads);
+
+/** Configure speculative reads of slices
+ *
+ * When a VDS is sliced at lines with a constant stride, e.g. when scrolling
+ * through a cube, the next depth slices along that stride are read before
+ * they are requested. At most max_size megabytes are buffered per VDS.
+ * Prefetching is disabled by default. Setting depth to 0 disables it again.
+ *
+ * Prefetching is only useful together with the datahandle pool, see
+ * datahandle_pool_configure().
+ */
+int prefetch_configure(
+    Context* ctx,
+    size_t depth,
+    size_t max_size
+);
+
+/** Counters of the speculative reads, accumulated over all VDSs
+ *
+ * hits:   Slices served by a speculative read
+ * misses: Slices not served by a speculative read
+ * waste:  Speculative reads that were never used
+ */
+int prefetch_statistics(
+    Context* ctx,
+    size_t* hits,
+    size_t* misses,
+    size_t* waste
+);
+
 int datahandle_free(Context* ctx, DataHandle* f);
 
 struct RegularSurface;
@@ -81,6 +159,18 @@ int regular_surface_new(
     RegularSurface** out
 );
 
+/*
+* Surface with the values of surface, except the fill values, offset by
+* offset. It shares the data of surface, which must outlive it, and is
+* free'd with regular_surface_free().
+*/
+int regular_surface_shifted(
+    Context* ctx,
+    RegularSurface* surface,
+    float offset,
+    RegularSurface** out
+);
+
 int regular_surface_free(
     Context* ctx,
     RegularSurface* surface
@@ -103,6 +193,32 @@ int subvolume_free(
     SurfaceBoundedSubVolume* subvolume
 );
 
+/*
+* Split the subvolume into tiles of at most max_bytes of data each, so that
+* the attributes can be computed tile by tile with bounded memory. A tile
+* is fetched when an attribute call first touches it and released when it is
+* done. Every tile is computed by a single thread of the thread pool, which
+* reads at most one tile ahead, so at most max_bytes times twice the number
+* of threads computing is held at once.
+*/
+int subvolume_tile(
+    Context* ctx,
+    SurfaceBoundedSubVolume* subvolume,
+    size_t max_bytes,
+    size_t* ntiles
+);
+
+/*
+* Segments [from, to) of the tile
+*/
+int subvolume_tile_bounds(
+    Context* ctx,
+    SurfaceBoundedSubVolume* subvolume,
+    size_t tile,
+    size_t* from,
+    size_t* to
+);
+
 int metadata(
     Context* ctx,
     DataHandle* datahandle,
@@ -116,6 +232,24 @@ int slice(
     enum axis_name direction,
     struct Bound* bounds,
     size_t nbounds,
+    int lod,
+    response* out
+);
+
+/** Fetch many slices in the same direction
+ *
+ * The slices are written back to back to out, in the order of linenos. All
+ * slices have the same size, out->size / nlinenos bytes.
+ */
+int slices(
+    Context* ctx,
+    DataHandle* datahandle,
+    const int* linenos,
+    size_t nlinenos,
+    enum axis_name direction,
+    struct Bound* bounds,
+    size_t nbounds,
+    int lod,
     response* out
 );
 
@@ -126,6 +260,22 @@ int slice_metadata(
     enum axis_name direction,
     struct Bound* bounds,
     size_t nbounds,
+    int lod,
+    response* out
+);
+
+/**
+ * Metadata of the slices of slices(), as a json array in the order of linenos
+ */
+int slices_metadata(
+    Context* ctx,
+    DataHandle* datahandle,
+    const int* linenos,
+    size_t nlinenos,
+    enum axis_name direction,
+    struct Bound* bounds,
+    size_t nbounds,
+    int lod,
     response* out
 );
 
@@ -137,6 +287,9 @@ int fence(
     size_t npoints,
     enum interpolation_method interpolation_method,
     const float* fillValue,
+    const float* windows,
+    size_t nwindows,
+    int lod,
     response* out
 );
 
@@ -144,6 +297,9 @@ int fence_metadata(
     Context* ctx,
     DataHandle* datahandle,
     size_t npoints,
+    const float* windows,
+    size_t nwindows,
+    int lod,
     response* out
 );
 
@@ -157,6 +313,11 @@ int attribute_metadata(
 
 /** Attribute calculation
 *
+* Attributes are computed for the segments [from, to) of the subvolume. The
+* range is split into chunks that are computed in parallel on the thread
+* pool, see thread_pool_configure(), and the call returns when all of them
+* are done. The data of the next chunks is read while a chunk is computed.
+*
 * Output buffer
 * -------------
 *
@@ -5,6 +5,8 @@
 
 #include <OpenVDS/IJKCoordinateTransformer.h>
 
+#include "regularsurface.hpp"
+
 class CoordinateTransformer {
 public:
     virtual OpenVDS::IntVector3 VoxelIndexToIJKIndex(const OpenVDS::IntVector3& voxelIndex) const = 0;
@@ -14,6 +16,44 @@ public:
     virtual OpenVDS::DoubleVector3 IJKIndexToAnnotation(const OpenVDS::IntVector3& ijkIndex) const = 0;
     virtual OpenVDS::DoubleVector3 IJKPositionToAnnotation(const OpenVDS::DoubleVector3& ijkPosition) const = 0;
     virtual OpenVDS::DoubleVector3 WorldToAnnotation(OpenVDS::DoubleVector3 worldPosition) const = 0;
+
+    /**
+     * WorldToAnnotation in the horizontal plane as a single affine
+     * transformation. Build it once and use it to transform many points,
+     * rather than calling WorldToAnnotation for every point.
+     */
+    AffineTransformation WorldToAnnotationTransformation() const {
+        return horizontal_transformation([this](double x, double y) {
+            return this->WorldToAnnotation({x, y, 0});
+        });
+    }
+
+    /**
+     * IJKPositionToAnnotation in the horizontal plane as a single affine
+     * transformation.
+     */
+    AffineTransformation IJKPositionToAnnotationTransformation() const {
+        return horizontal_transformation([this](double x, double y) {
+            return this->IJKPositionToAnnotation({x, y, 0});
+        });
+    }
+
+private:
+    /*
+     * The transformations are affine, so evaluating them at the origin and
+     * the two unit vectors is enough to recover the matrix.
+     */
+    template< typename Transform >
+    static AffineTransformation horizontal_transformation(Transform transform) {
+        auto const origin = transform(0, 0);
+        auto const x      = transform(1, 0);
+        auto const y      = transform(0, 1);
+
+        return AffineTransformation(AffineTransformation::base_type({{
+            { x[0] - origin[0], y[0] - origin[0], origin[0] },
+            { x[1] - origin[1], y[1] - origin[1], origin[1] },
+        }}));
+    }
 };
 
 class SingleCoordinateTransformer : public CoordinateTransformer {
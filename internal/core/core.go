@@ -418,6 +418,23 @@ func (surface *RegularSurface) toCRegularSurface(cdata []C.float) (cRegularSurfa
 	return cRegularSurface{cSurface: cSurface, cData: cdata}, nil
 }
 
+/** A view of the surface with all values but the fill values offset by shift
+ *
+ * The view shares the data of the surface, and must be closed on its own.
+ */
+func (r *cRegularSurface) shifted(shift float32) (cRegularSurface, error) {
+	var cCtx = C.context_new()
+	defer C.context_free(cCtx)
+
+	var cSurface *C.struct_RegularSurface
+	cErr := C.regular_surface_shifted(cCtx, r.cSurface, C.float(shift), &cSurface)
+	if err := toError(cErr, cCtx); err != nil {
+		return cRegularSurface{}, err
+	}
+
+	return cRegularSurface{cSurface: cSurface, cData: r.cData}, nil
+}
+
 type DSHandle struct {
 	dataHandle *C.struct_DataHandle
 	ctx        *C.struct_Context
@@ -442,6 +459,102 @@ func (v DSHandle) Close() error {
 	return toError(cerr, v.ctx)
 }
 
+/** Keep opened VDS handles around between requests
+ *
+ * Opening a VDS is expensive, so handles can be kept in a process-wide pool
+ * and shared between all requests to the same VDS (with the same
+ * credentials). A handle is evicted when it has not been requested for
+ * maxIdle seconds or when the pool holds more than maxSize handles.
+ *
+ * A maxIdle of zero disables the pool, which is the default.
+ */
+func ConfigureHandlePool(maxIdle uint32, maxSize uint32) error {
+	var cctx = C.context_new()
+	defer C.context_free(cctx)
+
+	cerr := C.datahandle_pool_configure(cctx, C.size_t(maxIdle), C.size_t(maxSize))
+	return toError(cerr, cctx)
+}
+
+/** Cache decoded data in the core library
+ *
+ * Data is cached as decoded bricks that are shared between all requests that
+ * touch them, e.g. overlapping slices, or a fence crossing a slice. At most
+ * maxSize megabytes are cached. A maxSize of zero disables the cache, which
+ * is the default.
+ */
+func ConfigureBrickCache(maxSize uint32) error {
+	var cctx = C.context_new()
+	defer C.context_free(cctx)
+
+	cerr := C.brick_cache_configure(cctx, C.size_t(maxSize))
+	return toError(cerr, cctx)
+}
+
+/** Keep full slices for later requests to part of the same slice
+ *
+ * Slices spanning the whole VDS are cached, and later requests to the same
+ * line, with or without bounds, are served from them. At most maxSize
+ * megabytes are cached. A maxSize of zero disables the cache, which is the
+ * default.
+ */
+func ConfigureSliceCache(maxSize uint32) error {
+	var cctx = C.context_new()
+	defer C.context_free(cctx)
+
+	cerr := C.slice_cache_configure(cctx, C.size_t(maxSize))
+	return toError(cerr, cctx)
+}
+
+/** Size the thread pool that attributes are computed on
+ *
+ * All attribute requests share a single pool of nthreads threads in the core
+ * library, so concurrent requests split the cores between them. A nthreads
+ * of zero gives one thread per hardware thread, which is the default.
+ */
+func ConfigureThreadPool(nthreads uint32) error {
+	var cctx = C.context_new()
+	defer C.context_free(cctx)
+
+	cerr := C.thread_pool_configure(cctx, C.size_t(nthreads))
+	return toError(cerr, cctx)
+}
+
+/** Read slices ahead of time when they are requested in sequence
+ *
+ * When a VDS is sliced at lines with a constant stride, the next depth
+ * slices along that stride are read before they are requested. At most
+ * maxSize megabytes are buffered per VDS. A depth of zero disables
+ * prefetching, which is the default.
+ *
+ * Prefetching only pays off when the handle pool is enabled, see
+ * ConfigureHandlePool.
+ */
+func ConfigurePrefetch(depth uint32, maxSize uint32) error {
+	var cctx = C.context_new()
+	defer C.context_free(cctx)
+
+	cerr := C.prefetch_configure(cctx, C.size_t(depth), C.size_t(maxSize))
+	return toError(cerr, cctx)
+}
+
+/** Hit, miss and waste counts of the prefetched slices
+ *
+ * Hits and misses count slice reads that were, or were not, served by a
+ * prefetched slice. Waste counts prefetched slices that were never used.
+ */
+func PrefetchStatistics() (hits uint64, misses uint64, waste uint64, err error) {
+	var cctx = C.context_new()
+	defer C.context_free(cctx)
+
+	var chits, cmisses, cwaste C.size_t
+	cerr := C.prefetch_statistics(cctx, &chits, &cmisses, &cwaste)
+	if err := toError(cerr, cctx); err != nil {
+		return 0, 0, 0, err
+	}
+	return uint64(chits), uint64(cmisses), uint64(cwaste), nil
+}
+
 func NewDSHandle(connection Connection) (DSHandle, error) {
 	return CreateDSHandle([]Connection{connection}, BinaryOperatorNoOperator)
 }
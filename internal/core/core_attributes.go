@@ -11,6 +11,22 @@ import (
 	"unsafe"
 )
 
+/** Max size, in bytes, of the fetched data of a single attribute request */
+var attributeMemory uint64
+
+/** Compute attributes with bounded memory
+ *
+ * By default the data of the whole subvolume between the top and bottom
+ * surfaces is fetched before attributes are computed, and held until the
+ * request is done. With a maxSize the subvolume is split into tiles instead,
+ * and every tile is fetched, computed and dropped on its own, so that at most
+ * maxSize megabytes of data are held by a single request. A maxSize of zero
+ * disables tiling, which is the default.
+ */
+func ConfigureAttributeMemory(maxSize uint32) {
+	attributeMemory = uint64(maxSize) * 1024 * 1024
+}
+
 func (v DSHandle) GetAttributeMetadata(data [][]float32) ([]byte, error) {
 	var result C.struct_response = C.response_create()
 	cerr := C.attribute_metadata(
@@ -67,22 +83,14 @@ func (v DSHandle) GetAttributesAlongSurface(
 	}
 	defer cReferenceSurface.Close()
 
-	cTopSurfaceData, err := referenceSurface.toCdata(-above)
-	if err != nil {
-		return nil, err
-	}
-
-	cTopSurface, err := referenceSurface.toCRegularSurface(cTopSurfaceData)
+	// top and bottom are views of the reference surface, not copies
+	cTopSurface, err := cReferenceSurface.shifted(-above)
 	if err != nil {
 		return nil, err
 	}
 	defer cTopSurface.Close()
 
-	cBottomSurfaceData, err := referenceSurface.toCdata(below)
-	if err != nil {
-		return nil, err
-	}
-	cBottomSurface, err := referenceSurface.toCRegularSurface(cBottomSurfaceData)
+	cBottomSurface, err := cReferenceSurface.shifted(below)
 	if err != nil {
 		return nil, err
 	}
@@ -194,18 +202,33 @@ func (v DSHandle) normalizeAttributes(
 	return targetAttributes, nil
 }
 
-func min(a, b int) int {
-	if a < b {
-		return a
+/** Tile the subvolume such that all tiles computed at once by the thread
+ * pool together stay within the memory limit
+ */
+func tileSubVolume(
+	cCtx *C.Context,
+	cSubVolume *C.struct_SurfaceBoundedSubVolume,
+) error {
+	if attributeMemory == 0 {
+		return nil
 	}
-	return b
-}
 
-func max(a, b int) int {
-	if a > b {
-		return a
+	var nthreads C.size_t
+	cerr := C.thread_pool_size(cCtx, &nthreads)
+	if err := toError(cerr, cCtx); err != nil {
+		return err
 	}
-	return b
+
+	// the calling thread computes tiles too, and every thread reads one
+	// tile ahead of the one it computes
+	var ntiles C.size_t
+	cerr = C.subvolume_tile(
+		cCtx,
+		cSubVolume,
+		C.size_t(attributeMemory/uint64(2*(nthreads+1))),
+		&ntiles,
+	)
+	return toError(cerr, cCtx)
 }
 
 func (v DSHandle) getAttributes(
@@ -246,67 +269,24 @@ func (v DSHandle) getAttributes(
 	var mapsize = hsize * 4
 	buffer := make([]byte, mapsize*nAttributes)
 
-	// note that it is possible to hit go's own goroutines limit
-	// but we do not deal with it here
-
-	// max number of goroutines running at the same time
-	// too low number doesn't utilize all CPU, too high overuses it
-	// value should be experimented with
-	maxConcurrentGoroutines := max(nrows/2, 1)
-	guard := make(chan struct{}, maxConcurrentGoroutines)
-
-	// the size of the data processed in one goroutine
-	// decides how many parts data is split into
-	// value should be experimented with
-	chunkSize := max(nrows, 1)
-
-	from := 0
-	to := from + chunkSize
-
-	errs := make(chan error, hsize/chunkSize+1)
-	nRoutines := 0
-
-	for from < hsize {
-		guard <- struct{}{} // block if guard channel is filled
-		go func(from, to int) {
-			var cCtx = C.context_new()
-			defer C.context_free(cCtx)
-
-			cerr_attributes := C.attribute(
-				cCtx,
-				v.DataHandle(),
-				cSubVolume,
-				C.enum_interpolation_method(interpolation),
-				&cAttributes[0],
-				C.size_t(nAttributes),
-				C.float(stepsize),
-				C.size_t(from),
-				C.size_t(to),
-				unsafe.Pointer(&buffer[0]),
-			)
-
-			errs <- toError(cerr_attributes, cCtx)
-			<-guard
-
-		}(from, to)
-
-		nRoutines += 1
-
-		from += chunkSize
-		to = min(to+chunkSize, hsize)
-	}
-
-	// Wait for all gorutines to finish and collect any errors
-	var computeErrors []error
-	for i := 0; i < nRoutines; i++ {
-		err := <-errs
-		if err != nil {
-			computeErrors = append(computeErrors, err)
-		}
+	if err := tileSubVolume(cCtx, cSubVolume); err != nil {
+		return nil, err
 	}
 
-	if len(computeErrors) > 0 {
-		return nil, computeErrors[0]
+	cerr = C.attribute(
+		cCtx,
+		v.DataHandle(),
+		cSubVolume,
+		C.enum_interpolation_method(interpolation),
+		&cAttributes[0],
+		C.size_t(nAttributes),
+		C.float(stepsize),
+		C.size_t(0),
+		C.size_t(hsize),
+		unsafe.Pointer(&buffer[0]),
+	)
+	if err := toError(cerr, cCtx); err != nil {
+		return nil, err
 	}
 
 	out := make([][]byte, nAttributes)
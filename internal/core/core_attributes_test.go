@@ -1156,6 +1156,45 @@ func TestAttributeBetweenSurfaces(t *testing.T) {
 	}
 }
 
+func TestAttributesWithBoundedMemory(t *testing.T) {
+	topSurface := samples10Surface([][]float32{
+		{16, 20},
+		{20, 18},
+		{14, 12},
+		{12, 12},
+	})
+	bottomSurface := samples10Surface([][]float32{
+		{32, 24},
+		{20, 18},
+		{fillValue, 28},
+		{28, 28},
+	})
+	targetAttributes := []string{"samplevalue", "min", "max_at", "mean", "sd"}
+	interpolationMethod, _ := GetInterpolationMethod("nearest")
+
+	handle, _ := NewDSHandle(samples10)
+	defer handle.Close()
+
+	attributes := func() [][]byte {
+		buf, err := handle.GetAttributesBetweenSurfaces(
+			topSurface,
+			bottomSurface,
+			4,
+			targetAttributes,
+			interpolationMethod,
+		)
+		require.NoErrorf(t, err, "Failed to calculate attributes, err %v", err)
+		return buf
+	}
+
+	expected := attributes()
+
+	ConfigureAttributeMemory(1)
+	defer ConfigureAttributeMemory(0)
+
+	require.Equal(t, expected, attributes())
+}
+
 func TestAttributesInconsistentLength(t *testing.T) {
 	const above = float32(0)
 	const below = float32(0)
@@ -11,11 +11,44 @@ import (
 	"unsafe"
 )
 
+/** Flatten (top, bottom) vertical windows into a C array
+ *
+ * Returns nil for no windows, i.e. whole traces.
+ */
+func toCWindows(windows [][]float32) ([]C.float, error) {
+	if len(windows) == 0 {
+		return nil, nil
+	}
+
+	cwindows := make([]C.float, 0, len(windows)*2)
+	for i, window := range windows {
+		if len(window) != 2 {
+			msg := fmt.Sprintf(
+				"invalid vertical window %v at position %d, expected [top bottom] pair",
+				window,
+				i,
+			)
+			return nil, NewInvalidArgument(msg)
+		}
+		cwindows = append(cwindows, C.float(window[0]), C.float(window[1]))
+	}
+	return cwindows, nil
+}
+
+func windowsPointer(cwindows []C.float) *C.float {
+	if len(cwindows) == 0 {
+		return nil
+	}
+	return &cwindows[0]
+}
+
 func (v DSHandle) GetFence(
 	coordinateSystem int,
 	coordinates [][]float32,
 	interpolation int,
 	fillValue *float32,
+	windows [][]float32,
+	lod int,
 ) ([]byte, error) {
 	coordinate_len := 2
 	ccoordinates := make([]C.float, len(coordinates)*coordinate_len)
@@ -35,6 +68,11 @@ func (v DSHandle) GetFence(
 		}
 	}
 
+	cwindows, err := toCWindows(windows)
+	if err != nil {
+		return nil, err
+	}
+
 	var result C.struct_response = C.response_create()
 	cerr := C.fence(
 		v.context(),
@@ -44,6 +82,9 @@ func (v DSHandle) GetFence(
 		C.size_t(len(coordinates)),
 		C.enum_interpolation_method(interpolation),
 		(*C.float)(fillValue),
+		windowsPointer(cwindows),
+		C.size_t(len(windows)),
+		C.int(lod),
 		&result,
 	)
 
@@ -57,12 +98,24 @@ func (v DSHandle) GetFence(
 	return buf, nil
 }
 
-func (v DSHandle) GetFenceMetadata(coordinates [][]float32) ([]byte, error) {
+func (v DSHandle) GetFenceMetadata(
+	coordinates [][]float32,
+	windows [][]float32,
+	lod int,
+) ([]byte, error) {
+	cwindows, err := toCWindows(windows)
+	if err != nil {
+		return nil, err
+	}
+
 	var result C.struct_response = C.response_create()
 	cerr := C.fence_metadata(
 		v.context(),
 		v.DataHandle(),
 		C.size_t(len(coordinates)),
+		windowsPointer(cwindows),
+		C.size_t(len(windows)),
+		C.int(lod),
 		&result,
 	)
 
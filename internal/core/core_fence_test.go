@@ -46,6 +46,8 @@ func TestFence(t *testing.T) {
 			testcase.coordinates,
 			interpolationMethod,
 			&fillValue,
+			nil,
+			0,
 		)
 		require.NoErrorf(t, err,
 			"[coordinate_system: %v] Failed to fetch fence, err: %v",
@@ -105,7 +107,7 @@ func TestFenceBorders(t *testing.T) {
 		interpolationMethod, _ := GetInterpolationMethod("linear")
 		handle, _ := NewDSHandle(well_known)
 		defer handle.Close()
-		_, err := handle.GetFence(testcase.coordinate_system, testcase.coordinates, interpolationMethod, nil)
+		_, err := handle.GetFence(testcase.coordinate_system, testcase.coordinates, interpolationMethod, nil, nil, 0)
 
 		require.ErrorContainsf(t, err, testcase.err, "[case: %v]", testcase.name)
 	}
@@ -161,6 +163,8 @@ func TestFenceBordersWithFillValue(t *testing.T) {
 			testcase.coordinates,
 			interpolationMethod,
 			&fillValue,
+			nil,
+			0,
 		)
 		require.NoError(t, err)
 
@@ -240,6 +244,8 @@ func TestFenceNearestInterpolationSnap(t *testing.T) {
 			testcase.coordinates,
 			interpolationMethod,
 			&fillValue,
+			nil,
+			0,
 		)
 		require.NoErrorf(t, err,
 			"[coordinate_system: %v] Failed to fetch fence, err: %v",
@@ -263,7 +269,7 @@ func TestInvalidFence(t *testing.T) {
 	interpolationMethod, _ := GetInterpolationMethod("nearest")
 	handle, _ := NewDSHandle(well_known)
 	defer handle.Close()
-	_, err := handle.GetFence(CoordinateSystemIndex, fence, interpolationMethod, &fillValue)
+	_, err := handle.GetFence(CoordinateSystemIndex, fence, interpolationMethod, &fillValue, nil, 0)
 
 	require.ErrorContains(t, err,
 		"invalid coordinate [1 1 0] at position 1, expected [x y] pair",
@@ -300,6 +306,8 @@ func TestFenceInterpolationSameAtDataPoints(t *testing.T) {
 			coordinates,
 			interpolationMethod,
 			&fillValue,
+			nil,
+			0,
 		)
 		require.NoErrorf(t, err, "Failed to fetch fence in [interpolation: %v]", interpolation)
 		result, err := toFloat32(buf)
@@ -318,10 +326,10 @@ func TestFenceInterpolationDifferentBeyondDatapoints(t *testing.T) {
 		interpolationMethod, _ := GetInterpolationMethod(v1)
 		handle, _ := NewDSHandle(well_known)
 		defer handle.Close()
-		buf1, _ := handle.GetFence(CoordinateSystemCdp, fence, interpolationMethod, &fillValue)
+		buf1, _ := handle.GetFence(CoordinateSystemCdp, fence, interpolationMethod, &fillValue, nil, 0)
 		for _, v2 := range interpolationMethods[i+1:] {
 			interpolationMethod, _ := GetInterpolationMethod(v2)
-			buf2, _ := handle.GetFence(CoordinateSystemCdp, fence, interpolationMethod, &fillValue)
+			buf2, _ := handle.GetFence(CoordinateSystemCdp, fence, interpolationMethod, &fillValue, nil, 0)
 
 			require.NotEqual(t, buf1, buf2)
 		}
@@ -366,7 +374,7 @@ func TestFenceMetadata(t *testing.T) {
 
 	handle, _ := NewDSHandle(well_known)
 	defer handle.Close()
-	buf, err := handle.GetFenceMetadata(coordinates)
+	buf, err := handle.GetFenceMetadata(coordinates, nil, 0)
 	require.NoErrorf(t, err, "Failed to retrieve fence metadata, err %v", err)
 
 	var meta FenceMetadata
@@ -377,3 +385,107 @@ func TestFenceMetadata(t *testing.T) {
 
 	require.Equal(t, expected, meta)
 }
+
+func TestFenceVerticalWindows(t *testing.T) {
+	testcases := []struct {
+		name     string
+		windows  [][]float32
+		expected []float32
+	}{
+		{
+			name:    "Same window for all points",
+			windows: [][]float32{{8, 12}},
+			expected: []float32{
+				109, 110, // il: 3, xl: 10, samples: 8-12
+				113, 114, // il: 3, xl: 11, samples: 8-12
+				101, 102, // il: 1, xl: 10, samples: 8-12
+			},
+		},
+		{
+			name:    "Window per point",
+			windows: [][]float32{{4, 8}, {12, 16}, {7, 11}},
+			expected: []float32{
+				108, 109, // il: 3, xl: 10, samples: 4-8
+				114, 115, // il: 3, xl: 11, samples: 12-16
+				101, 102, // il: 1, xl: 10, samples: 8-12
+			},
+		},
+	}
+
+	coordinates := [][]float32{{3, 10}, {3, 11}, {1, 10}}
+	interpolationMethod, _ := GetInterpolationMethod("nearest")
+
+	for _, testcase := range testcases {
+		handle, _ := NewDSHandle(well_known)
+		defer handle.Close()
+
+		buf, err := handle.GetFence(
+			CoordinateSystemAnnotation,
+			coordinates,
+			interpolationMethod,
+			nil,
+			testcase.windows,
+			0,
+		)
+		require.NoErrorf(t, err, "[case: %v] Failed to fetch fence", testcase.name)
+
+		fence, err := toFloat32(buf)
+		require.NoErrorf(t, err, "[case: %v] Err: %v", testcase.name, err)
+		require.Equalf(t, testcase.expected, *fence, "[case: %v]", testcase.name)
+
+		buf, err = handle.GetFenceMetadata(coordinates, testcase.windows, 0)
+		require.NoErrorf(t, err, "[case: %v] Failed to fetch metadata", testcase.name)
+
+		var meta FenceMetadata
+		err = json.Unmarshal(buf, &meta)
+		require.NoError(t, err)
+		require.Equalf(t, []int{3, 2}, meta.Shape, "[case: %v]", testcase.name)
+	}
+}
+
+func TestFenceInvalidVerticalWindows(t *testing.T) {
+	testcases := []struct {
+		name    string
+		windows [][]float32
+		err     string
+	}{
+		{
+			name:    "Windows of different length",
+			windows: [][]float32{{4, 8}, {4, 12}, {4, 8}},
+			err:     "must all cover the same number of samples",
+		},
+		{
+			name:    "Window out of bounds",
+			windows: [][]float32{{12, 20}},
+			err:     "out of vertical bounds",
+		},
+		{
+			name:    "Wrong number of windows",
+			windows: [][]float32{{4, 8}, {4, 8}},
+			err:     "Expected 1 or 3 vertical windows, got 2",
+		},
+		{
+			name:    "Window is not a pair",
+			windows: [][]float32{{4, 8, 12}},
+			err:     "expected [top bottom] pair",
+		},
+	}
+
+	coordinates := [][]float32{{3, 10}, {3, 11}, {1, 10}}
+	interpolationMethod, _ := GetInterpolationMethod("nearest")
+
+	for _, testcase := range testcases {
+		handle, _ := NewDSHandle(well_known)
+		defer handle.Close()
+
+		_, err := handle.GetFence(
+			CoordinateSystemAnnotation,
+			coordinates,
+			interpolationMethod,
+			nil,
+			testcase.windows,
+			0,
+		)
+		require.ErrorContainsf(t, err, testcase.err, "[case: %v]", testcase.name)
+	}
+}
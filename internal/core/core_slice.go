@@ -7,6 +7,7 @@ package core
 */
 import "C"
 import (
+	"math"
 	"unsafe"
 )
 
@@ -36,7 +37,12 @@ func newCSliceBounds(bounds []Bound) ([]C.struct_Bound, error) {
 	return cBounds, nil
 }
 
-func (v DSHandle) GetSlice(lineno, direction int, bounds []Bound) ([]byte, error) {
+func (v DSHandle) GetSlice(
+	lineno int,
+	direction int,
+	bounds []Bound,
+	lod int,
+) ([]byte, error) {
 	var result C.struct_response = C.response_create()
 
 	cBounds, err := newCSliceBounds(bounds)
@@ -56,6 +62,7 @@ func (v DSHandle) GetSlice(lineno, direction int, bounds []Bound) ([]byte, error
 		C.enum_axis_name(direction),
 		bound,
 		C.size_t(len(cBounds)),
+		C.int(lod),
 		&result,
 	)
 
@@ -68,10 +75,73 @@ func (v DSHandle) GetSlice(lineno, direction int, bounds []Bound) ([]byte, error
 	return buf, nil
 }
 
+/** Fetch many slices in the same direction
+ *
+ * All slices are read in one call to the core library, which merges reads of
+ * nearby lines. The returned slices are in the order of linenos.
+ */
+func (v DSHandle) GetSlices(
+	linenos []int,
+	direction int,
+	bounds []Bound,
+	lod int,
+) ([][]byte, error) {
+	if len(linenos) == 0 {
+		return nil, NewInvalidArgument("No linenos given")
+	}
+
+	var result C.struct_response = C.response_create()
+
+	cBounds, err := newCSliceBounds(bounds)
+	if err != nil {
+		return nil, err
+	}
+
+	var bound *C.struct_Bound
+	if len(cBounds) > 0 {
+		bound = &cBounds[0]
+	}
+
+	cLinenos := make([]C.int, len(linenos))
+	for i, lineno := range linenos {
+		cLinenos[i] = C.int(lineno)
+	}
+
+	cerr := C.slices(
+		v.context(),
+		v.DataHandle(),
+		&cLinenos[0],
+		C.size_t(len(cLinenos)),
+		C.enum_axis_name(direction),
+		bound,
+		C.size_t(len(cBounds)),
+		C.int(lod),
+		&result,
+	)
+
+	defer C.response_delete(&result)
+	if err := v.Error(cerr); err != nil {
+		return nil, err
+	}
+
+	if result.size > math.MaxInt32 {
+		return nil, NewInternalError("Slices response too large")
+	}
+	buf := C.GoBytes(unsafe.Pointer(result.data), C.int(result.size))
+
+	sliceSize := len(buf) / len(linenos)
+	slices := make([][]byte, len(linenos))
+	for i := range slices {
+		slices[i] = buf[i*sliceSize : (i+1)*sliceSize]
+	}
+	return slices, nil
+}
+
 func (v DSHandle) GetSliceMetadata(
 	lineno int,
 	direction int,
 	bounds []Bound,
+	lod int,
 ) ([]byte, error) {
 	var result C.struct_response = C.response_create()
 
@@ -92,6 +162,61 @@ func (v DSHandle) GetSliceMetadata(
 		C.enum_axis_name(direction),
 		bound,
 		C.size_t(len(cBounds)),
+		C.int(lod),
+		&result,
+	)
+
+	defer C.response_delete(&result)
+
+	if err := v.Error(cerr); err != nil {
+		return nil, err
+	}
+
+	buf := C.GoBytes(unsafe.Pointer(result.data), C.int(result.size))
+	return buf, nil
+}
+
+/** Metadata of many slices in the same direction
+ *
+ * Returns a json array with the metadata of every slice returned by
+ * GetSlices, in the order of linenos.
+ */
+func (v DSHandle) GetSlicesMetadata(
+	linenos []int,
+	direction int,
+	bounds []Bound,
+	lod int,
+) ([]byte, error) {
+	if len(linenos) == 0 {
+		return nil, NewInvalidArgument("No linenos given")
+	}
+
+	var result C.struct_response = C.response_create()
+
+	cBounds, err := newCSliceBounds(bounds)
+	if err != nil {
+		return nil, err
+	}
+
+	var bound *C.struct_Bound
+	if len(cBounds) > 0 {
+		bound = &cBounds[0]
+	}
+
+	cLinenos := make([]C.int, len(linenos))
+	for i, lineno := range linenos {
+		cLinenos[i] = C.int(lineno)
+	}
+
+	cerr := C.slices_metadata(
+		v.context(),
+		v.DataHandle(),
+		&cLinenos[0],
+		C.size_t(len(cLinenos)),
+		C.enum_axis_name(direction),
+		bound,
+		C.size_t(len(cBounds)),
+		C.int(lod),
 		&result,
 	)
 
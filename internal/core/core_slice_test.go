@@ -48,6 +48,7 @@ func TestSliceData(t *testing.T) {
 			testcase.lineno,
 			testcase.direction,
 			[]Bound{},
+			0,
 		)
 		require.NoErrorf(t, err,
 			"[case: %v] Failed to fetch slice, err: %v",
@@ -62,6 +63,76 @@ func TestSliceData(t *testing.T) {
 	}
 }
 
+func TestSlicesMatchSlice(t *testing.T) {
+	testcases := []struct {
+		name      string
+		linenos   []int
+		direction int
+	}{
+		{name: "inline", linenos: []int{5, 1, 3, 3}, direction: AxisInline},
+		{name: "crossline", linenos: []int{10, 11}, direction: AxisCrossline},
+		{name: "k", linenos: []int{3, 0, 2}, direction: AxisK},
+	}
+
+	for _, testcase := range testcases {
+		handle, _ := NewDSHandle(well_known)
+		defer handle.Close()
+		slices, err := handle.GetSlices(
+			testcase.linenos,
+			testcase.direction,
+			[]Bound{},
+			0,
+		)
+		require.NoErrorf(t, err, "[case: %v] Err: %v", testcase.name, err)
+		require.Lenf(t, slices, len(testcase.linenos), "[case: %v]", testcase.name)
+
+		for i, lineno := range testcase.linenos {
+			expected, err := handle.GetSlice(
+				lineno,
+				testcase.direction,
+				[]Bound{},
+				0,
+			)
+			require.NoErrorf(t, err, "[case: %v] Err: %v", testcase.name, err)
+			require.Equalf(t, expected, slices[i],
+				"[case: %v] Slice %d differs", testcase.name, lineno)
+		}
+	}
+}
+
+func TestSlicesMetadataMatchSliceMetadata(t *testing.T) {
+	handle, _ := NewDSHandle(well_known)
+	defer handle.Close()
+
+	linenos := []int{5, 1, 3, 3}
+	buf, err := handle.GetSlicesMetadata(linenos, AxisInline, []Bound{}, 0)
+	require.NoError(t, err)
+
+	var metadata []json.RawMessage
+	require.NoError(t, json.Unmarshal(buf, &metadata))
+	require.Len(t, metadata, len(linenos))
+
+	for i, lineno := range linenos {
+		expected, err := handle.GetSliceMetadata(lineno, AxisInline, []Bound{}, 0)
+		require.NoError(t, err)
+		require.JSONEqf(t, string(expected), string(metadata[i]),
+			"Metadata of slice %d differs", lineno)
+	}
+
+	_, err = handle.GetSlicesMetadata([]int{1, 6}, AxisInline, []Bound{}, 0)
+	require.ErrorContains(t, err, "Invalid lineno")
+}
+
+func TestSlicesInvalidLineno(t *testing.T) {
+	handle, _ := NewDSHandle(well_known)
+	defer handle.Close()
+	_, err := handle.GetSlices([]int{1, 6}, AxisInline, []Bound{}, 0)
+	require.ErrorContains(t, err, "Invalid lineno")
+
+	_, err = handle.GetSlices([]int{}, AxisInline, []Bound{}, 0)
+	require.ErrorContains(t, err, "No linenos given")
+}
+
 func TestSliceOutOfBounds(t *testing.T) {
 	testcases := []struct {
 		name      string
@@ -89,6 +160,7 @@ func TestSliceOutOfBounds(t *testing.T) {
 			testcase.lineno,
 			testcase.direction,
 			[]Bound{},
+			0,
 		)
 
 		require.ErrorContains(t, err, "Invalid lineno")
@@ -113,6 +185,7 @@ func TestSliceStepSizedLineno(t *testing.T) {
 			testcase.lineno,
 			testcase.direction,
 			[]Bound{},
+			0,
 		)
 
 		require.ErrorContains(t, err, "Invalid lineno")
@@ -131,7 +204,7 @@ func TestSliceInvalidAxis(t *testing.T) {
 	for _, testcase := range testcases {
 		handle, _ := NewDSHandle(well_known)
 		defer handle.Close()
-		_, err := handle.GetSlice(0, testcase.direction, []Bound{})
+		_, err := handle.GetSlice(0, testcase.direction, []Bound{}, 0)
 
 		require.ErrorContains(t, err, "Unhandled axis")
 	}
@@ -375,6 +448,7 @@ func TestSliceBounds(t *testing.T) {
 			testCase.lineno,
 			direction,
 			testCase.bounds,
+			0,
 		)
 
 		require.IsTypef(t, testCase.expectedErr, err,
@@ -395,6 +469,7 @@ func TestSliceBounds(t *testing.T) {
 			testCase.lineno,
 			direction,
 			testCase.bounds,
+			0,
 		)
 		require.NoError(t, err,
 			"[case: %v] Failed to get slice metadata, err: %v",
@@ -450,7 +525,7 @@ func TestDepthAxis(t *testing.T) {
 	for _, testcase := range testcases {
 		handle, _ := NewDSHandle(well_known)
 		defer handle.Close()
-		_, err := handle.GetSlice(0, testcase.direction, []Bound{})
+		_, err := handle.GetSlice(0, testcase.direction, []Bound{}, 0)
 
 		require.Equal(t, err, testcase.err)
 	}
@@ -470,7 +545,7 @@ func TestSliceMetadata(t *testing.T) {
 	}
 	handle, _ := NewDSHandle(well_known)
 	defer handle.Close()
-	buf, err := handle.GetSliceMetadata(lineno, direction, []Bound{})
+	buf, err := handle.GetSliceMetadata(lineno, direction, []Bound{}, 0)
 	require.NoErrorf(t, err, "Failed to retrieve slice metadata, err %v", err)
 
 	var meta SliceMetadata
@@ -535,6 +610,7 @@ func TestSliceMetadataAxisOrdering(t *testing.T) {
 			testcase.lineno,
 			testcase.direction,
 			[]Bound{},
+			0,
 		)
 		require.NoErrorf(t, err,
 			"[case: %v] Failed to get slice metadata, err: %v",
@@ -608,6 +684,7 @@ func TestSliceGeospatial(t *testing.T) {
 			testcase.lineno,
 			testcase.direction,
 			[]Bound{},
+			0,
 		)
 		require.NoError(t, err,
 			"[case: %v] Failed to get slice metadata, err: %v",
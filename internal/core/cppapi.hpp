@@ -1,6 +1,9 @@
 #ifndef ONESEISMIC_API_CPPAPI_HPP
 #define ONESEISMIC_API_CPPAPI_HPP
 
+#include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "ctypes.h"
@@ -13,14 +16,48 @@
 
 namespace cppapi {
 
+/**
+ * Fetch a slice at level of detail lod. At lod n only every 2^n-th sample is
+ * returned in each dimension, and the slice itself snaps to the closest line
+ * at or before lineno that is present at that level of detail. Use
+ * slice_metadata with the same arguments to get the decimated axes.
+ */
 void slice(
     DataHandle& datahandle,
     Direction const direction,
     int lineno,
     std::vector< Bound > const& bounds,
+    int lod,
+    response* out
+) noexcept (false);
+
+/**
+ * Fetch many slices in the same direction in one call.
+ *
+ * The slices are returned back to back in a single buffer, in the order of
+ * linenos. All slices have the same size, so slice i starts at byte
+ * i * (out->size / linenos.size()). Other arguments are as for slice.
+ *
+ * Lines that are close together are read as one subcube and cut apart
+ * afterwards, and all reads are issued before waiting on any of them.
+ */
+void slices(
+    DataHandle& datahandle,
+    Direction const direction,
+    std::vector< int > const& linenos,
+    std::vector< Bound > const& bounds,
+    int lod,
     response* out
 ) noexcept (false);
 
+/**
+ * Fetch traces along a path of npoints (x, y) coordinates.
+ *
+ * When nwindows is 0 the whole traces are returned. Otherwise windows are
+ * (top, bottom) pairs in the unit of the sample axis, either one pair for all
+ * points or one per point, and only the samples within the windows are read
+ * and returned. See VerticalWindows.
+ */
 void fence(
     DataHandle& datahandle,
     enum coordinate_system coordinate_system,
@@ -28,15 +65,100 @@ void fence(
     size_t npoints,
     enum interpolation_method interpolation_method,
     const float* fillValue,
+    const float* windows,
+    size_t nwindows,
+    int lod,
     response* out
 ) noexcept (false);
 
+/**
+ * How fetch_subvolume reads the segments.
+ *
+ * SAMPLES reads every sample by its own coordinate. TRACES reads whole
+ * traces and copies the segments out of them, which requires the segments to
+ * be aligned with the samples. AUTOMATIC picks one per call, see
+ * prefer_trace_windows.
+ */
+enum class SubvolumeFetch { AUTOMATIC, SAMPLES, TRACES };
+
+/**
+ * Reads of subvolume segments in progress, see request_subvolume.
+ *
+ * The DataHandle and subvolume must outlive the read. Destroying a read that
+ * has not been waited for cancels it.
+ */
+class SubvolumeRead {
+public:
+    virtual ~SubvolumeRead() {};
+
+    /**
+     * Block until all segments are written to the subvolume. Throws if the
+     * read failed.
+     */
+    virtual void wait() noexcept (false) = 0;
+};
+
+/**
+ * Issue the reads of segments [from, to) without waiting for them, so that
+ * other work can be done while they are in flight.
+ */
+std::unique_ptr< SubvolumeRead > request_subvolume(
+    DataHandle& datahandle,
+    SurfaceBoundedSubVolume& subvolume,
+    enum interpolation_method interpolation,
+    std::size_t from,
+    std::size_t to,
+    SubvolumeFetch strategy = SubvolumeFetch::AUTOMATIC
+) noexcept (false);
+
 void fetch_subvolume(
     DataHandle& datahandle,
     SurfaceBoundedSubVolume& subvolume,
     enum interpolation_method interpolation,
     std::size_t from,
-    std::size_t to
+    std::size_t to,
+    SubvolumeFetch strategy = SubvolumeFetch::AUTOMATIC
+) noexcept (false);
+
+/**
+ * Fetch and compute the attributes of a stream of chunks of segments, with
+ * the reads of the next chunks in flight while a chunk is computed.
+ *
+ * next_chunk sets the next chunk [from, to) and returns true, or returns
+ * false when there are no more chunks. The number of chunks read ahead
+ * adapts to how long the reads are waited for compared to how long the
+ * computation takes, from one up to max_depth. The data of every chunk is
+ * released once its attributes are computed.
+ */
+void pipeline_attributes(
+    DataHandle& datahandle,
+    SurfaceBoundedSubVolume& subvolume,
+    enum interpolation_method interpolation,
+    ResampledSegmentBlueprint const* dst_segment_blueprint,
+    enum attribute* attributes,
+    std::size_t nattributes,
+    std::function< bool(std::pair< std::size_t, std::size_t >&) > const& next_chunk,
+    std::size_t max_depth,
+    void** out
+) noexcept (false);
+
+/**
+ * Split segments [from, to) of the subvolume into about nparts consecutive
+ * ranges that are fetched and computed independently.
+ *
+ * The ranges hold close to the same number of samples, using the segment
+ * offsets of the subvolume rather than the number of segments. Ranges are
+ * cut between rows of the horizontal grid, preferably between rows that
+ * touch no VDS bricks in common, so that bricks are not decompressed by more
+ * than one range. brick_size is the brick size of the VDS, see
+ * MetadataHandle::brick_size().
+ */
+std::vector< std::pair< std::size_t, std::size_t > > partition_subvolume(
+    SurfaceBoundedSubVolume const& subvolume,
+    std::size_t from,
+    std::size_t to,
+    std::size_t nparts,
+    int brick_size
 ) noexcept (false);
 
 void attributes(
@@ -81,6 +203,20 @@ void slice_metadata(
     Direction const direction,
     int lineno,
     std::vector< Bound > const& bounds,
+    int lod,
+    response* out
+) noexcept (false);
+
+/**
+ * Metadata of every slice of slices(), as a json array in the order of
+ * linenos
+ */
+void slices_metadata(
+    DataHandle& datahandle,
+    Direction const direction,
+    std::vector< int > const& linenos,
+    std::vector< Bound > const& bounds,
+    int lod,
     response* out
 ) noexcept (false);
 
@@ -88,6 +224,9 @@ void slice_metadata(
 void fence_metadata(
     DataHandle& datahandle,
     size_t npoints,
+    const float* windows,
+    size_t nwindows,
+    int lod,
     response* out
 ) noexcept (false);
 
@@ -1,6 +1,14 @@
 #include "ctypes.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <numeric>
 #include <string>
 #include <memory>
 
@@ -10,6 +18,7 @@
 
 #include "attribute.hpp"
 #include "axis.hpp"
+#include "cppapi.hpp"
 #include "datahandle.hpp"
 #include "direction.hpp"
 #include "exceptions.hpp"
@@ -120,9 +129,472 @@ void write_fillvalue(
     });
 }
 
-template< typename T >
-void append(std::vector< std::unique_ptr< AttributeMap > >& vec, T obj) {
-    vec.push_back( std::unique_ptr< T >( new T( std::move(obj) ) ) );
+void validate_slice_request(
+    MetadataHandle const& metadata,
+    Direction const& direction,
+    std::vector< Bound > const& slicebounds,
+    int lod
+) noexcept (false) {
+    metadata.validate_lod(lod);
+
+    if (direction.is_sample()) {
+        validate_vertical_axis(metadata.sample(), direction);
+    }
+
+    for (auto const& bound : slicebounds) {
+        auto bound_dir = Direction(bound.name);
+        validate_vertical_axis(metadata.sample(), bound_dir);
+    }
+}
+
+/**
+ * A single subcube read serving one or more slices. The subcube spans the
+ * lines [lower, upper) in the slice dimension.
+ */
+struct SliceBlock {
+    int lower;
+    int upper;
+    /* Positions in the request of the slices served by this block */
+    std::vector< std::size_t > slices;
+};
+
+/**
+ * Group the requested (voxel) lines into blocks.
+ *
+ * Lines that fall in the same brick are read as one subcube, as the storage
+ * backend reads and decodes whole bricks anyway. To bound the memory spent on
+ * lines that are not asked for, the lines in a brick are only merged when at
+ * least half of the lines in the merged subcube are requested.
+ *
+ * @param brick_size Number of (full resolution) lines covered by a brick
+ */
+std::vector< SliceBlock > plan_slice_reads(
+    std::vector< int > const& lines,
+    int brick_size
+) {
+    std::vector< std::size_t > order(lines.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return lines[a] < lines[b];
+    });
+
+    std::vector< SliceBlock > blocks;
+    auto first = order.begin();
+    while (first != order.end()) {
+        int const brick = lines[*first] / brick_size;
+        auto last = std::find_if(first, order.end(), [&](std::size_t i) {
+            return lines[i] / brick_size != brick;
+        });
+
+        std::vector< int > unique;
+        for (auto it = first; it != last; ++it) {
+            if (unique.empty() or unique.back() != lines[*it]) {
+                unique.push_back(lines[*it]);
+            }
+        }
+
+        int const span = unique.back() - unique.front() + 1;
+        if (span <= 2 * int(unique.size())) {
+            blocks.push_back({ unique.front(), unique.back() + 1, { first, last } });
+        } else {
+            for (auto it = first; it != last; ++it) {
+                if (blocks.empty() or blocks.back().lower != lines[*it]) {
+                    blocks.push_back({ lines[*it], lines[*it] + 1, {} });
+                }
+                blocks.back().slices.push_back(*it);
+            }
+        }
+        first = last;
+    }
+    return blocks;
+}
+
+/**
+ * The traces to read for a fence, and where each point of the fence gets its
+ * trace from.
+ */
+struct FencePlan {
+    /* Points to read, one per unique trace, in the order to read them */
+    std::vector< std::size_t > reads;
+    /* For every point, its position in reads, or npos if it is not read */
+    std::vector< std::size_t > sources;
+
+    static constexpr std::size_t npos = std::size_t(-1);
+};
+
+/**
+ * Plan the reads of a fence.
+ *
+ * Points that are out of range are not read at all, as they are overwritten
+ * by the fill value anyway. Points at the exact same position are only read
+ * once.
+ *
+ * The unique traces are read in brick order, rather than in the order of the
+ * fence, so that zig-zag and random fences read every brick in one go.
+ *
+ * @param positions  Voxel position of every point, in the two horizontal
+ *                   dimensions, and the first sample of its vertical window
+ *                   (0 when whole traces are read)
+ * @param in_range   Whether every point is within the cube
+ * @param brick_size Number of (full resolution) samples covered by a brick
+ */
+FencePlan plan_fence_reads(
+    std::vector< std::array< float, 3 > > const& positions,
+    std::vector< bool > const& in_range,
+    int brick_size
+) {
+    std::size_t const npoints = positions.size();
+
+    auto brick = [&](std::size_t i) {
+        return std::array< int, 2 >{
+            int(std::floor(positions[i][0] / brick_size)),
+            int(std::floor(positions[i][1] / brick_size)),
+        };
+    };
+
+    std::vector< std::size_t > order;
+    order.reserve(npoints);
+    for (std::size_t i = 0; i < npoints; ++i) {
+        if (in_range[i]) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        auto const lhs = brick(a);
+        auto const rhs = brick(b);
+        if (lhs != rhs) return lhs < rhs;
+        return positions[a] < positions[b];
+    });
+
+    FencePlan plan;
+    plan.sources.assign(npoints, FencePlan::npos);
+    for (std::size_t i : order) {
+        if (plan.reads.empty() or positions[plan.reads.back()] != positions[i]) {
+            plan.reads.push_back(i);
+        }
+        plan.sources[i] = plan.reads.size() - 1;
+    }
+    return plan;
+}
+
+/**
+ * A non-empty vertical segment of a subvolume, positioned in the volume
+ */
+struct SegmentWindow {
+    /* Index of the segment in the subvolume */
+    std::size_t index;
+    /* Horizontal sample position (inline, crossline) */
+    std::array< float, 2 > position;
+    /* Sample position of the first sample in the segment */
+    double top;
+    std::size_t size;
+};
+
+/**
+ * Max number of samples to read in a single request when fetching subvolume
+ * data. Bounds the memory used for voxel coordinates and trace buffers,
+ * independent of the size of the subvolume.
+ */
+constexpr std::size_t max_fetch_samples = 1 << 20;
+
+void set_voxel(
+    voxel& v,
+    MetadataHandle const& metadata,
+    std::array< float, 2 > const& position,
+    double sample_position
+) {
+    v[metadata.iline().dimension()]  = position[0];
+    v[metadata.xline().dimension()]  = position[1];
+    v[metadata.sample().dimension()] = sample_position;
+}
+
+/**
+ * Whether to fetch the segments as windows cut out of whole traces, rather
+ * than sample by sample.
+ *
+ * Reading samples takes a voxel (6 floats) of coordinates per sample, but
+ * only touches the bricks the segments intersect. Reading traces needs a
+ * single coordinate per segment, but reads the trace top to bottom. Traces
+ * win when the segments are aligned with the samples, which is what
+ * RawSegmentBlueprint produces, and on average cover at least half of the
+ * trace.
+ */
+bool is_sample_aligned(SegmentWindow const& window) {
+    /* Sample centers are at x.5 */
+    double const offset = window.top - std::floor(window.top);
+    return std::abs(offset - 0.5) <= 1e-3;
+}
+
+bool prefer_trace_windows(
+    std::vector< SegmentWindow > const& windows,
+    std::size_t trace_length
+) {
+    if (windows.empty()) return false;
+
+    std::size_t nsamples = 0;
+    for (auto const& window : windows) {
+        if (not is_sample_aligned(window)) return false;
+        nsamples += window.size;
+    }
+    return 2 * nsamples >= windows.size() * trace_length;
+}
+
+/**
+ * Read of subvolume segments in batches, with the next batch in flight while
+ * the current one is waited for and copied out. At most two batches are held
+ * at once, which bounds the memory used for coordinates and read buffers.
+ */
+class BatchedSubvolumeRead : public cppapi::SubvolumeRead {
+public:
+    void start() noexcept (false) {
+        if (this->nbatches() > 0) this->issue(0);
+    }
+
+    void wait() noexcept (false) override {
+        for (std::size_t batch = 0; batch < this->nbatches(); ++batch) {
+            if (batch + 1 < this->nbatches()) this->issue(batch + 1);
+            this->finish(batch);
+        }
+    }
+
+protected:
+    virtual std::size_t nbatches() const noexcept (true) = 0;
+    virtual void issue(std::size_t batch) noexcept (false) = 0;
+    /* Wait for the batch and release its buffers */
+    virtual void finish(std::size_t batch) noexcept (false) = 0;
+};
+
+/**
+ * Read the segments sample by sample, in batches of at most
+ * max_fetch_samples samples.
+ */
+class SampleWindowsRead : public BatchedSubvolumeRead {
+public:
+    SampleWindowsRead(
+        DataHandle& datahandle,
+        SurfaceBoundedSubVolume& subvolume,
+        std::vector< SegmentWindow > windows,
+        enum interpolation_method interpolation
+    ) : m_datahandle(datahandle),
+        m_subvolume(subvolume),
+        m_windows(std::move(windows)),
+        m_interpolation(interpolation)
+    {
+        std::size_t first = 0;
+        while (first < this->m_windows.size()) {
+            std::size_t last = first;
+            std::size_t nsamples = 0;
+            do {
+                nsamples += this->m_windows[last].size;
+                ++last;
+            } while (
+                last < this->m_windows.size() and
+                nsamples + this->m_windows[last].size <= max_fetch_samples
+            );
+            this->m_bounds.push_back(first);
+            first = last;
+        }
+        this->m_bounds.push_back(this->m_windows.size());
+        this->m_batches.resize(this->nbatches());
+    }
+
+protected:
+    std::size_t nbatches() const noexcept (true) override {
+        return this->m_bounds.size() - 1;
+    }
+
+    void issue(std::size_t batch) noexcept (false) override {
+        MetadataHandle const& metadata = this->m_datahandle.get_metadata();
+
+        auto const first = this->m_windows.begin() + this->m_bounds[batch];
+        auto const last  = this->m_windows.begin() + this->m_bounds[batch + 1];
+
+        std::size_t nsamples = 0;
+        for (auto window = first; window != last; ++window) {
+            nsamples += window->size;
+        }
+
+        auto& pending = this->m_batches[batch];
+        pending.samples.reset(new voxel[nsamples]{{0}});
+        std::size_t cur = 0;
+        for (auto window = first; window != last; ++window) {
+            for (std::size_t k = 0; k < window->size; ++k) {
+                set_voxel(pending.samples[cur++], metadata, window->position, window->top + k);
+            }
+        }
+
+        /* Segments are stored back to back, so the batch is contiguous */
+        pending.request = this->m_datahandle.request_samples(
+            this->m_subvolume.data(first->index),
+            this->m_datahandle.samples_buffer_size(nsamples),
+            pending.samples.get(),
+            nsamples,
+            this->m_interpolation
+        );
+    }
+
+    void finish(std::size_t batch) noexcept (false) override {
+        auto& pending = this->m_batches[batch];
+        pending.request->wait();
+        pending = Batch();
+    }
+
+private:
+    struct Batch {
+        /* Declared first, so that a pending request is cancelled first */
+        std::unique_ptr< voxel[] > samples;
+        std::unique_ptr< ReadRequest > request;
+    };
+
+    DataHandle& m_datahandle;
+    SurfaceBoundedSubVolume& m_subvolume;
+    std::vector< SegmentWindow > m_windows;
+    enum interpolation_method m_interpolation;
+    /* First window of every batch, followed by the number of windows */
+    std::vector< std::size_t > m_bounds;
+    std::vector< Batch > m_batches;
+};
+
+/**
+ * Read whole traces, in batches of at most max_fetch_samples samples, and
+ * copy the segments out of them. Trace reads only interpolate horizontally,
+ * which gives the same result as reading the samples when the segments are
+ * aligned with the samples.
+ */
+class TraceWindowsRead : public BatchedSubvolumeRead {
+public:
+    TraceWindowsRead(
+        DataHandle& datahandle,
+        SurfaceBoundedSubVolume& subvolume,
+        std::vector< SegmentWindow > windows,
+        enum interpolation_method interpolation
+    ) : m_datahandle(datahandle),
+        m_subvolume(subvolume),
+        m_windows(std::move(windows)),
+        m_interpolation(interpolation),
+        m_trace_length(datahandle.traces_buffer_size(1, 0) / sizeof(float)),
+        m_batch_size(std::max< std::size_t >(1, max_fetch_samples / m_trace_length))
+    {
+        for (auto const& window : this->m_windows) {
+            if (not is_sample_aligned(window)) {
+                throw std::invalid_argument("Segment is not aligned with the samples");
+            }
+            std::size_t const top = std::floor(window.top);
+            if (top + window.size > this->m_trace_length) {
+                throw std::runtime_error("Segment exceeds trace length");
+            }
+        }
+        this->m_batches.resize(this->nbatches());
+    }
+
+protected:
+    std::size_t nbatches() const noexcept (true) override {
+        return (this->m_windows.size() + this->m_batch_size - 1) / this->m_batch_size;
+    }
+
+    void issue(std::size_t batch) noexcept (false) override {
+        MetadataHandle const& metadata = this->m_datahandle.get_metadata();
+
+        std::size_t const first   = batch * this->m_batch_size;
+        std::size_t const ntraces = this->ntraces(batch);
+
+        auto& pending = this->m_batches[batch];
+        pending.coordinates.reset(new voxel[ntraces]{{0}});
+        for (std::size_t t = 0; t < ntraces; ++t) {
+            set_voxel(pending.coordinates[t], metadata, this->m_windows[first + t].position, 0);
+        }
+
+        std::int64_t const size = this->m_datahandle.traces_buffer_size(ntraces, 0);
+        pending.traces.resize(size / sizeof(float));
+        pending.request = this->m_datahandle.request_traces(
+            pending.traces.data(),
+            size,
+            pending.coordinates.get(),
+            ntraces,
+            this->m_interpolation,
+            0
+        );
+    }
+
+    void finish(std::size_t batch) noexcept (false) override {
+        auto& pending = this->m_batches[batch];
+        pending.request->wait();
+
+        std::size_t const first = batch * this->m_batch_size;
+        for (std::size_t t = 0; t < this->ntraces(batch); ++t) {
+            auto const& window = this->m_windows[first + t];
+            std::size_t const top = std::floor(window.top);
+            std::memcpy(
+                this->m_subvolume.data(window.index),
+                pending.traces.data() + t * this->m_trace_length + top,
+                window.size * sizeof(float)
+            );
+        }
+        pending = Batch();
+    }
+
+private:
+    std::size_t ntraces(std::size_t batch) const noexcept (true) {
+        return std::min(
+            this->m_batch_size,
+            this->m_windows.size() - batch * this->m_batch_size
+        );
+    }
+
+    struct Batch {
+        /* Declared first, so that a pending request is cancelled first */
+        std::unique_ptr< voxel[] > coordinates;
+        std::vector< float > traces;
+        std::unique_ptr< ReadRequest > request;
+    };
+
+    DataHandle& m_datahandle;
+    SurfaceBoundedSubVolume& m_subvolume;
+    std::vector< SegmentWindow > m_windows;
+    enum interpolation_method m_interpolation;
+    std::size_t m_trace_length;
+    std::size_t m_batch_size;
+    std::vector< Batch > m_batches;
+};
+
+Attribute make_attribute(enum attribute attribute) {
+    switch (attribute) {
+        case VALUE:    return Value();
+        case MIN:      return Min();
+        case MINAT:    return MinAt();
+        case MAX:      return Max();
+        case MAXAT:    return MaxAt();
+        case MAXABS:   return MaxAbs();
+        case MAXABSAT: return MaxAbsAt();
+        case MEAN:     return Mean();
+        case MEANABS:  return MeanAbs();
+        case MEANPOS:  return MeanPos();
+        case MEANNEG:  return MeanNeg();
+        case MEDIAN:   return Median();
+        case RMS:      return Rms();
+        case VAR:      return Var();
+        case SD:       return Sd();
+        case SUMPOS:   return SumPos();
+        case SUMNEG:   return SumNeg();
+
+        default:
+            throw std::runtime_error("Attribute not implemented");
+    }
+}
+
+/**
+ * Whether two sorted lists of bricks have no brick in common
+ */
+bool disjoint(
+    std::vector< std::array< int, 2 > > const& lhs,
+    std::vector< std::array< int, 2 > > const& rhs
+) noexcept (true) {
+    auto l = lhs.begin();
+    auto r = rhs.begin();
+    while (l != lhs.end() and r != rhs.end()) {
+        if      (*l < *r) ++l;
+        else if (*r < *l) ++r;
+        else return false;
+    }
+    return true;
 }
 
 } // namespace
@@ -134,23 +606,17 @@ void slice(
     Direction const direction,
     int lineno,
     std::vector< Bound > const& slicebounds,
+    int lod,
     response* out
 ) {
     MetadataHandle const& metadata = datahandle.get_metadata();
     Axis const& axis = metadata.get_axis(direction);
-
-    if (direction.is_sample()) {
-        validate_vertical_axis(metadata.sample(), direction);
-    }
-
-    for (auto const& bound : slicebounds) {
-        auto bound_dir = Direction(bound.name);
-        validate_vertical_axis(metadata.sample(), bound_dir);
-    }
+    validate_slice_request(metadata, direction, slicebounds, lod);
 
     SubCube bounds(metadata);
     bounds.constrain(metadata, slicebounds);
     bounds.set_slice(axis, lineno, direction.coordinate_system());
+    bounds.lod = lod;
 
     std::int64_t const size = datahandle.subcube_buffer_size(bounds);
 
@@ -160,6 +626,129 @@ void slice(
     return to_response(std::move(data), size, out);
 }
 
+void slices(
+    DataHandle& datahandle,
+    Direction const direction,
+    std::vector< int > const& linenos,
+    std::vector< Bound > const& slicebounds,
+    int lod,
+    response* out
+) {
+    MetadataHandle const& metadata = datahandle.get_metadata();
+    Axis const& axis = metadata.get_axis(direction);
+    validate_slice_request(metadata, direction, slicebounds, lod);
+
+    if (linenos.empty()) {
+        throw detail::bad_request("No linenos given");
+    }
+
+    SubCube bounds(metadata);
+    bounds.constrain(metadata, slicebounds);
+    bounds.lod = lod;
+
+    int const dimension = axis.dimension();
+    std::vector< int > lines;
+    for (int lineno : linenos) {
+        SubCube slice(bounds);
+        slice.set_slice(axis, lineno, direction.coordinate_system());
+        lines.push_back(slice.bounds.lower[dimension]);
+    }
+
+    SubCube slice(bounds);
+    slice.set_slice(axis, linenos.front(), direction.coordinate_system());
+    std::int64_t const slice_size = datahandle.subcube_buffer_size(slice);
+    std::int64_t const size = slice_size * linenos.size();
+    if (size > std::numeric_limits< std::int32_t >::max()) {
+        throw detail::bad_request(
+            "Requested slices add up to " + std::to_string(size) + " bytes, "
+            "more than the 2 GiB a single response can hold. Request fewer "
+            "slices at a time."
+        );
+    }
+
+    std::unique_ptr< char[] > data(new char[size]);
+
+    /*
+     * Single line blocks are read straight into the response. Merged blocks
+     * are read into a separate buffer, which the slices are cut out of.
+     */
+    struct Read {
+        SliceBlock block;
+        SubCube subcube;
+        std::vector< char > buffer;
+        std::unique_ptr< ReadRequest > request;
+    };
+    std::vector< Read > reads;
+    /* At lower levels of detail every brick covers 2^lod times the lines */
+    int const brick_size = metadata.brick_size() << lod;
+    for (auto& block : plan_slice_reads(lines, brick_size)) {
+        SubCube subcube(bounds);
+        subcube.bounds.lower[dimension] = block.lower;
+        subcube.bounds.upper[dimension] = block.upper;
+        reads.push_back({ std::move(block), subcube, {}, nullptr });
+    }
+
+    for (auto& read : reads) {
+        if (read.block.upper - read.block.lower == 1) {
+            char* dst = data.get() + read.block.slices.front() * slice_size;
+            read.request = datahandle.request_subcube(dst, slice_size, read.subcube);
+        } else {
+            std::int64_t const block_size = datahandle.subcube_buffer_size(read.subcube);
+            read.buffer.resize(block_size);
+            read.request = datahandle.request_subcube(
+                read.buffer.data(), block_size, read.subcube
+            );
+        }
+    }
+
+    std::array< std::size_t, 3 > shape;
+    for (int dim = 0; dim < 3; ++dim) shape[dim] = slice.nsamples(dim);
+    std::size_t const row = shape[0] * sizeof(float);
+
+    for (auto& read : reads) {
+        read.request->wait();
+        read.request.reset();
+
+        if (read.buffer.empty()) {
+            /* Repeated linenos get a copy of the slice that was read */
+            char const* src = data.get() + read.block.slices.front() * slice_size;
+            for (std::size_t i = 1; i < read.block.slices.size(); ++i) {
+                std::memcpy(data.get() + read.block.slices[i] * slice_size, src, slice_size);
+            }
+            continue;
+        }
+
+        std::array< std::size_t, 3 > block_shape;
+        for (int dim = 0; dim < 3; ++dim) {
+            block_shape[dim] = read.subcube.nsamples(dim);
+        }
+        int const first = read.block.lower >> lod;
+
+        for (std::size_t i : read.block.slices) {
+            char* dst = data.get() + i * slice_size;
+            std::size_t const line = (lines[i] >> lod) - first;
+
+            for (std::size_t k = 0; k < shape[2]; ++k)
+            for (std::size_t j = 0; j < shape[1]; ++j) {
+                std::array< std::size_t, 3 > position{ 0, j, k };
+                position[dimension] += line;
+
+                std::size_t const src = position[0]
+                                      + block_shape[0] * (position[1]
+                                      + block_shape[1] *  position[2]);
+                std::size_t const offset = shape[0] * (j + shape[1] * k);
+                std::memcpy(
+                    dst + offset * sizeof(float),
+                    read.buffer.data() + src * sizeof(float),
+                    row
+                );
+            }
+        }
+    }
+
+    return to_response(std::move(data), size, out);
+}
+
 void fence(
     DataHandle& datahandle,
     enum coordinate_system coordinate_system,
@@ -167,42 +756,79 @@ void fence(
     size_t npoints,
     enum interpolation_method interpolation_method,
     const float* fillValue,
+    const float* windows,
+    size_t nwindows,
+    int lod,
     response* out
 ) {
     MetadataHandle const& metadata = datahandle.get_metadata();
+    metadata.validate_lod(lod);
 
     std::vector< std::size_t > noval_indicies;
 
-    std::unique_ptr< voxel[] > coords(new voxel[npoints]{{0}});
+    std::vector< std::array< float, 3 > > positions(npoints);
+    std::vector< bool > in_range(npoints, true);
 
-    CoordinateTransformer const& coordinate_transformer = metadata.coordinate_transformer();
-    auto transform_coordinate = [&] (const float x, const float y) {
-        switch (coordinate_system) {
-            case INDEX:
-                return coordinate_transformer.IJKPositionToAnnotation({x, y, 0});
-            case ANNOTATION:
-                return OpenVDS::Vector<double, 3> {x, y, 0};
-            case CDP:
-                return coordinate_transformer.WorldToAnnotation({x, y, 0});
-            default: {
-                throw std::runtime_error("Unhandled coordinate system");
-            }
-        }
-    };
     Axis inline_axis    = metadata.iline();
     Axis crossline_axis = metadata.xline();
     Axis samples_axis   = metadata.sample();
-    auto nsamples       = samples_axis.nsamples();
 
+    std::unique_ptr< VerticalWindows > vertical_windows;
+    if (nwindows > 0) {
+        if (lod != 0) {
+            throw detail::bad_request(
+                "Vertical windows are not supported with level of detail"
+            );
+        }
+        vertical_windows.reset(
+            new VerticalWindows(samples_axis, windows, nwindows, npoints)
+        );
+    }
+
+    SubCube trace(metadata);
+    trace.lod = lod;
+    auto nsamples = vertical_windows
+        ? vertical_windows->nsamples()
+        : trace.nsamples(samples_axis.dimension());
+
+    /*
+     * Transform all the points to annotation in one go. This is a single
+     * affine transformation, built once, instead of a virtual call per point.
+     */
+    std::vector< double > ilines(npoints);
+    std::vector< double > xlines(npoints);
     for (size_t i = 0; i < npoints; i++) {
-        const float x = *(coordinates++);
-        const float y = *(coordinates++);
+        ilines[i] = coordinates[2 * i];
+        xlines[i] = coordinates[2 * i + 1];
+    }
 
-        auto coordinate = transform_coordinate(x, y);
+    CoordinateTransformer const& coordinate_transformer = metadata.coordinate_transformer();
+    switch (coordinate_system) {
+        case INDEX:
+            coordinate_transformer.IJKPositionToAnnotationTransformation()
+                .transform(ilines.data(), xlines.data(), npoints);
+            break;
+        case ANNOTATION:
+            break;
+        case CDP:
+            coordinate_transformer.WorldToAnnotationTransformation()
+                .transform(ilines.data(), xlines.data(), npoints);
+            break;
+        default: {
+            throw std::runtime_error("Unhandled coordinate system");
+        }
+    }
 
-        auto validate_boundary = [&] (const int voxel, Axis const& axis) {
-            if (!axis.inrange_with_margin(coordinate[voxel])) {
+    for (size_t i = 0; i < npoints; i++) {
+        auto validate_boundary = [&] (
+            const int voxel,
+            Axis const& axis,
+            double const coordinate
+        ) {
+            if (!axis.inrange_with_margin(coordinate)) {
                 if (fillValue == nullptr) {
+                    const float x = coordinates[2 * i];
+                    const float y = coordinates[2 * i + 1];
                     const std::string coordinate_str =
                         "(" +utils::to_string_with_precision(x, 6) + "," +
                         utils::to_string_with_precision(y, 6) + ")";
@@ -212,27 +838,94 @@ void fence(
                     );
                 }
                 noval_indicies.push_back(i * nsamples);
+                in_range[i] = false;
             }
         };
 
-        validate_boundary(0, inline_axis);
-        validate_boundary(1, crossline_axis);
+        validate_boundary(0, inline_axis,    ilines[i]);
+        validate_boundary(1, crossline_axis, xlines[i]);
+    }
 
-        coords[i][   inline_axis.dimension()] = inline_axis.to_sample_position(coordinate[0]);
-        coords[i][crossline_axis.dimension()] = crossline_axis.to_sample_position(coordinate[1]);
+    inline_axis.to_sample_positions(ilines.data(), npoints);
+    crossline_axis.to_sample_positions(xlines.data(), npoints);
+    for (size_t i = 0; i < npoints; i++) {
+        positions[i][0] = ilines[i];
+        positions[i][1] = xlines[i];
+        positions[i][2] = vertical_windows ? vertical_windows->top(i) : 0;
     }
 
-    std::int64_t const size = datahandle.traces_buffer_size(npoints);
+    FencePlan const plan = plan_fence_reads(
+        positions,
+        in_range,
+        metadata.brick_size() << lod
+    );
+    std::size_t const nreads = plan.reads.size();
+
+    auto buffer_size = [&](std::size_t ntraces) {
+        if (vertical_windows) return datahandle.samples_buffer_size(ntraces * nsamples);
+        return datahandle.traces_buffer_size(ntraces, lod);
+    };
 
+    std::int64_t const size = buffer_size(npoints);
     std::unique_ptr< char[] > data(new char[size]);
 
-    datahandle.read_traces(
-        data.get(),
-        size,
-        coords.get(),
-        npoints,
-        interpolation_method
-    );
+    if (nreads > 0) {
+        std::int64_t const read_size = buffer_size(nreads);
+        std::unique_ptr< char[] > traces(new char[read_size]);
+
+        if (vertical_windows) {
+            /*
+             * Read only the samples in the windows, which only touches the
+             * bricks the windows intersect.
+             */
+            std::size_t const nvoxels = nreads * nsamples;
+            std::unique_ptr< voxel[] > samples(new voxel[nvoxels]{{0}});
+            for (std::size_t i = 0; i < nreads; ++i) {
+                auto const& position = positions[plan.reads[i]];
+                for (int k = 0; k < nsamples; ++k) {
+                    auto& sample = samples[i * nsamples + k];
+                    sample[   inline_axis.dimension()] = position[0];
+                    sample[crossline_axis.dimension()] = position[1];
+                    sample[  samples_axis.dimension()] = position[2] + k + 0.5f;
+                }
+            }
+
+            datahandle.read_samples(
+                traces.get(),
+                read_size,
+                samples.get(),
+                nvoxels,
+                interpolation_method
+            );
+        } else {
+            std::unique_ptr< voxel[] > coords(new voxel[nreads]{{0}});
+            for (std::size_t i = 0; i < nreads; ++i) {
+                auto const& position = positions[plan.reads[i]];
+                coords[i][   inline_axis.dimension()] = position[0];
+                coords[i][crossline_axis.dimension()] = position[1];
+            }
+
+            datahandle.read_traces(
+                traces.get(),
+                read_size,
+                coords.get(),
+                nreads,
+                interpolation_method,
+                lod
+            );
+        }
+
+        /* Scatter the traces back into the order of the fence */
+        std::size_t const trace_size = nsamples * sizeof(float);
+        for (std::size_t i = 0; i < npoints; ++i) {
+            if (plan.sources[i] == FencePlan::npos) continue;
+            std::memcpy(
+                data.get() + i * trace_size,
+                traces.get() + plan.sources[i] * trace_size,
+                trace_size
+            );
+        }
+    }
     if (!noval_indicies.empty()){
             write_fillvalue(data.get(), noval_indicies, nsamples, *fillValue);
     }
@@ -240,12 +933,13 @@ void fence(
 }
 
 
-void fetch_subvolume(
+std::unique_ptr< SubvolumeRead > request_subvolume(
     DataHandle& datahandle,
     SurfaceBoundedSubVolume& subvolume,
     enum interpolation_method interpolation,
     std::size_t from,
-    std::size_t to
+    std::size_t to,
+    SubvolumeFetch strategy
 ) {
     auto const horizontal_grid = subvolume.horizontal_grid();
     if (to > horizontal_grid.size()){
@@ -253,18 +947,18 @@ void fetch_subvolume(
     }
 
     MetadataHandle const& metadata = datahandle.get_metadata();
-    CoordinateTransformer const& transform = metadata.coordinate_transformer();
-
-    auto iline  = metadata.iline ();
-    auto xline  = metadata.xline();
     auto sample = metadata.sample();
 
     std::size_t const nsamples = subvolume.nsamples(from, to);
     if (nsamples == 0){
-        return;
+        /* Nothing to read */
+        return std::unique_ptr< SubvolumeRead >(
+            new SampleWindowsRead(datahandle, subvolume, {}, interpolation)
+        );
     }
-    std::unique_ptr< voxel[] > samples(new voxel[nsamples]{{0}});
+    subvolume.allocate(from, to);
 
+    std::vector< SegmentWindow > windows;
     std::size_t cur = 0;
     for (int i = from; i < to; ++i) {
         if (subvolume.is_empty(i)) {
@@ -273,19 +967,14 @@ void fetch_subvolume(
 
         auto segment = subvolume.vertical_segment(i);
 
-        auto const cdp = horizontal_grid.to_cdp(i);
-        auto ij = transform.WorldToAnnotation({cdp.x, cdp.y, 0});
-
-        ij[0]  = iline.to_sample_position(ij[0]);
-        ij[1]  = xline.to_sample_position(ij[1]);
-
-        double k = sample.to_sample_position(segment.top_sample_position());
-        for (int idx = 0; idx < segment.size(); ++idx) {
-            samples[cur][  iline.dimension() ] = ij[0];
-            samples[cur][  xline.dimension() ] = ij[1];
-            samples[cur][ sample.dimension() ] = k + idx;
-            ++cur;
-        }
+        /* Horizontal positions are computed once, when planning the subvolume */
+        windows.push_back(SegmentWindow{
+            std::size_t(i),
+            subvolume.position(i),
+            sample.to_sample_position(segment.top_sample_position()),
+            segment.size()
+        });
+        cur += segment.size();
     }
 
     if (cur != nsamples){
@@ -293,15 +982,38 @@ void fetch_subvolume(
                                  " and actual samples " + std::to_string(cur) + " differ");
     }
 
-    auto const size = datahandle.samples_buffer_size(nsamples);
+    std::size_t const trace_length =
+        datahandle.traces_buffer_size(1, 0) / sizeof(float);
 
-    datahandle.read_samples(
-        subvolume.data(from),
-        size,
-        samples.get(),
-        nsamples,
-        interpolation
-    );
+    if (strategy == SubvolumeFetch::AUTOMATIC) {
+        strategy = prefer_trace_windows(windows, trace_length)
+            ? SubvolumeFetch::TRACES
+            : SubvolumeFetch::SAMPLES;
+    }
+
+    std::unique_ptr< BatchedSubvolumeRead > read;
+    if (strategy == SubvolumeFetch::TRACES) {
+        read.reset(new TraceWindowsRead(
+            datahandle, subvolume, std::move(windows), interpolation
+        ));
+    } else {
+        read.reset(new SampleWindowsRead(
+            datahandle, subvolume, std::move(windows), interpolation
+        ));
+    }
+    read->start();
+    return read;
+}
+
+void fetch_subvolume(
+    DataHandle& datahandle,
+    SurfaceBoundedSubVolume& subvolume,
+    enum interpolation_method interpolation,
+    std::size_t from,
+    std::size_t to,
+    SubvolumeFetch strategy
+) {
+    request_subvolume(datahandle, subvolume, interpolation, from, to, strategy)->wait();
 }
 
 
@@ -316,37 +1028,198 @@ void attributes(
 ) {
     std::size_t size = src_subvolume.horizontal_grid().size() * sizeof(float);
 
-    std::vector< std::unique_ptr< AttributeMap > > attrs;
-    for (int i = 0; i < nattributes; ++i) {
-        void* dst = out[i];
-        switch (*attributes) {
-            case VALUE:    { append(attrs,   Value(dst, size)     );   break; }
-            case MIN:      { append(attrs,   Min(dst, size)       );   break; }
-            case MINAT:    { append(attrs,   MinAt(dst, size)     );   break; }
-            case MAX:      { append(attrs,   Max(dst, size)       );   break; }
-            case MAXAT:    { append(attrs,   MaxAt(dst, size)     );   break; }
-            case MAXABS:   { append(attrs,   MaxAbs(dst, size)    );   break; }
-            case MAXABSAT: { append(attrs,   MaxAbsAt(dst, size)  );   break; }
-            case MEAN:     { append(attrs,   Mean(dst, size)      );   break; }
-            case MEANABS:  { append(attrs,   MeanAbs(dst, size)   );   break; }
-            case MEANPOS:  { append(attrs,   MeanPos(dst, size)   );   break; }
-            case MEANNEG:  { append(attrs,   MeanNeg(dst, size)   );   break; }
-            case MEDIAN:   { append(attrs,   Median(dst, size)    );   break; }
-            case RMS:      { append(attrs,   Rms(dst, size)       );   break; }
-            case VAR:      { append(attrs,   Var(dst, size)       );   break; }
-            case SD:       { append(attrs,   Sd(dst, size)        );   break; }
-            case SUMPOS:   { append(attrs,   SumPos(dst, size)    );   break; }
-            case SUMNEG:   { append(attrs,   SumNeg(dst, size)    );   break; }
-
-            default:
-                throw std::runtime_error("Attribute not implemented");
-        }
-        ++attributes;
+    std::vector< AttributeMap > attrs;
+    attrs.reserve(nattributes);
+    for (std::size_t i = 0; i < nattributes; ++i) {
+        attrs.emplace_back(make_attribute(attributes[i]), out[i], size);
     }
 
     calc_attributes(src_subvolume, dst_segment_blueprint, attrs, from, to);
 }
 
+void pipeline_attributes(
+    DataHandle& datahandle,
+    SurfaceBoundedSubVolume& subvolume,
+    enum interpolation_method interpolation,
+    ResampledSegmentBlueprint const* dst_segment_blueprint,
+    enum attribute* attributes,
+    std::size_t nattributes,
+    std::function< bool(std::pair< std::size_t, std::size_t >&) > const& next_chunk,
+    std::size_t max_depth,
+    void** out
+) {
+    using clock = std::chrono::steady_clock;
+
+    struct Pending {
+        std::pair< std::size_t, std::size_t > chunk;
+        std::unique_ptr< SubvolumeRead > read;
+    };
+    std::deque< Pending > pending;
+
+    std::size_t depth = std::min< std::size_t >(1, max_depth);
+    bool more = true;
+    bool first = true;
+    while (true) {
+        while (more and pending.size() <= depth) {
+            std::pair< std::size_t, std::size_t > chunk;
+            more = next_chunk(chunk);
+            if (not more) break;
+
+            auto read = request_subvolume(
+                datahandle,
+                subvolume,
+                interpolation,
+                chunk.first,
+                chunk.second
+            );
+            pending.push_back(Pending{ chunk, std::move(read) });
+        }
+        if (pending.empty()) break;
+
+        auto const start = clock::now();
+        pending.front().read->wait();
+        auto const fetched = clock::now();
+
+        std::size_t const from = pending.front().chunk.first;
+        std::size_t const to   = pending.front().chunk.second;
+        cppapi::attributes(
+            subvolume,
+            dst_segment_blueprint,
+            attributes,
+            nattributes,
+            from,
+            to,
+            out
+        );
+        subvolume.release(from, to);
+        pending.pop_front();
+        auto const computed = clock::now();
+
+        /*
+         * Nothing was read ahead of the first chunk, so its wait says nothing
+         * about the depth. After that, still waiting for a read means that
+         * the reads are not far enough ahead of the computation, and not
+         * waiting at all that fewer reads in flight would do.
+         */
+        auto const waited    = fetched - start;
+        auto const computing = computed - fetched;
+        if (first) {
+            first = false;
+        } else if (waited * 8 > computing) {
+            depth = std::min(depth + 1, max_depth);
+        } else if (waited * 32 < computing and depth > 1) {
+            --depth;
+        }
+    }
+}
+
+std::vector< std::pair< std::size_t, std::size_t > > partition_subvolume(
+    SurfaceBoundedSubVolume const& subvolume,
+    std::size_t from,
+    std::size_t to,
+    std::size_t nparts,
+    int brick_size
+) {
+    auto const& horizontal_grid = subvolume.horizontal_grid();
+    if (to > horizontal_grid.size()){
+        throw std::invalid_argument("'to' must be less than surface size");
+    }
+    if (from >= to) return {};
+
+    std::size_t const total = subvolume.nsamples(from, to);
+    if (nparts <= 1 or total == 0) return { { from, to } };
+
+    /* Horizontal bricks touched by the non-empty segments of every row */
+    std::size_t const ncols = horizontal_grid.ncols();
+    std::size_t const first_row = from / ncols;
+    std::size_t const last_row  = (to - 1) / ncols;
+
+    std::vector< std::vector< std::array< int, 2 > > > bricks(last_row - first_row + 1);
+    for (std::size_t row = first_row; row <= last_row; ++row) {
+        auto& row_bricks = bricks[row - first_row];
+        std::size_t const begin = std::max(row * ncols, from);
+        std::size_t const end   = std::min((row + 1) * ncols, to);
+        for (std::size_t i = begin; i < end; ++i) {
+            if (subvolume.is_empty(i)) continue;
+
+            /* Floored, as positions in the margin below 0 are in brick -1 */
+            auto const position = subvolume.position(i);
+            row_bricks.push_back({
+                int(std::floor(position[0] / brick_size)),
+                int(std::floor(position[1] / brick_size)),
+            });
+        }
+        std::sort(row_bricks.begin(), row_bricks.end());
+        row_bricks.erase(
+            std::unique(row_bricks.begin(), row_bricks.end()),
+            row_bricks.end()
+        );
+    }
+
+    /*
+     * Cut k is placed near k * target samples. Within half a part of that,
+     * a cut between rows that share no bricks is preferred, then a cut
+     * between any two rows, and only then a cut inside a row.
+     */
+    double const target = double(total) / nparts;
+    std::vector< std::size_t > bounds{ from };
+    std::size_t row = first_row + 1;
+    for (std::size_t k = 1; k < nparts; ++k) {
+        double const ideal = k * target;
+        double const lower = ideal - target / 2;
+        double const upper = ideal + target / 2;
+
+        auto offset = [&](std::size_t index) {
+            return double(subvolume.nsamples(from, index));
+        };
+
+        while (row <= last_row and offset(row * ncols) < lower) ++row;
+
+        std::size_t cut = 0;
+        bool clean = false;
+        double distance = 0;
+        for (std::size_t r = row; r <= last_row and offset(r * ncols) <= upper; ++r) {
+            std::size_t const candidate = r * ncols;
+            if (candidate <= bounds.back()) continue;
+
+            bool const candidate_clean = disjoint(
+                bricks[r - first_row - 1],
+                bricks[r - first_row]
+            );
+            double const candidate_distance = std::abs(offset(candidate) - ideal);
+            if (cut == 0 or
+                (candidate_clean and not clean) or
+                (candidate_clean == clean and candidate_distance < distance)
+            ) {
+                cut = candidate;
+                clean = candidate_clean;
+                distance = candidate_distance;
+            }
+        }
+
+        if (cut == 0) {
+            /* First segment at or past the ideal cut */
+            std::size_t lo = bounds.back() + 1;
+            std::size_t hi = to;
+            while (lo < hi) {
+                std::size_t const mid = lo + (hi - lo) / 2;
+                if (offset(mid) < ideal) lo = mid + 1;
+                else                     hi = mid;
+            }
+            cut = lo;
+        }
+
+        if (cut < to) bounds.push_back(cut);
+    }
+    bounds.push_back(to);
+
+    std::vector< std::pair< std::size_t, std::size_t > > parts;
+    for (std::size_t i = 1; i < bounds.size(); ++i) {
+        parts.emplace_back(bounds[i - 1], bounds[i]);
+    }
+    return parts;
+}
+
 namespace {
 
 struct SurfacesCrossoverValidator {
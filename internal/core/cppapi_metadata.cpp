@@ -1,5 +1,7 @@
 #include "ctypes.h"
 
+#include <functional>
+
 #include "nlohmann/json.hpp"
 
 #include <OpenVDS/OpenVDS.h>
@@ -13,6 +15,7 @@
 #include "direction.hpp"
 #include "exceptions.hpp"
 #include "metadatahandle.hpp"
+#include "subcube.hpp"
 
 namespace {
 
@@ -47,14 +50,13 @@ nlohmann::json json_axis(
     Axis const& axis,
     SubCube const& subcube
 ) {
-    auto const& lower = subcube.bounds.lower;
-    auto const& upper = subcube.bounds.upper;
-
     int dim = axis.dimension();
 
-    float min = axis.min() + axis.stepsize() * lower[dim];
-    float max = axis.min() + axis.stepsize() * (upper[dim] - 1); // inclusive
-    std::size_t samples = upper[dim] - lower[dim];
+    /* At lower levels of detail only every 2^lod-th sample is present */
+    float stepsize = axis.stepsize() * (1 << subcube.lod);
+    float min = axis.min() + axis.stepsize() * subcube.first(dim);
+    float max = axis.min() + axis.stepsize() * subcube.last(dim); // inclusive
+    std::size_t samples = subcube.nsamples(dim);
 
     nlohmann::json doc;
     doc = {
@@ -62,7 +64,7 @@ nlohmann::json json_axis(
         { "min",        min             },
         { "max",        max             },
         { "samples",    samples         },
-        { "stepsize",   axis.stepsize() },
+        { "stepsize",   stepsize        },
         { "unit",       axis.unit()     },
     };
     return doc;
@@ -78,16 +80,16 @@ nlohmann::json json_slice_geospatial(
     auto const& transformer = metadata.coordinate_transformer();
 
     auto const lower = transformer.VoxelIndexToIJKIndex({
-        bounds.bounds.lower[0],
-        bounds.bounds.lower[1],
-        bounds.bounds.lower[2]
+        bounds.first(0),
+        bounds.first(1),
+        bounds.first(2)
     });
 
     // The upper bound is exclusive, while we need it to be inclusive
     auto const upper = transformer.VoxelIndexToIJKIndex({
-        bounds.bounds.upper[0] - 1,
-        bounds.bounds.upper[1] - 1,
-        bounds.bounds.upper[2] - 1
+        bounds.last(0),
+        bounds.last(1),
+        bounds.last(2)
     });
 
     /** The slice bounds are given by the lower- and upper-coordinates only:
@@ -138,19 +140,26 @@ nlohmann::json json_slice_geospatial(
     }
 }
 
-} // namespace
-
-namespace cppapi {
-
-void slice_metadata(
+/**
+ * Metadata of the slices of linenos, passed to emit in order. Only the
+ * geospatial extent depends on the line number, the rest is computed once
+ * and shared by all slices.
+ */
+void emit_slices_metadata(
     DataHandle& datahandle,
     Direction const direction,
-    int lineno,
+    std::vector< int > const& linenos,
     std::vector< Bound > const& slicebounds,
-    response* out
+    int lod,
+    std::function< void(nlohmann::json) > const& emit
 ) {
     MetadataHandle const& metadata = datahandle.get_metadata();
     auto const& axis = metadata.get_axis(direction);
+    metadata.validate_lod(lod);
+
+    if (linenos.empty()) {
+        throw detail::bad_request("No linenos given");
+    }
 
     nlohmann::json meta;
     meta["format"] = fmtstr(SingleDataHandle::format());
@@ -161,17 +170,17 @@ void slice_metadata(
 
     SubCube bounds(metadata);
     bounds.constrain(metadata, slicebounds);
-    bounds.set_slice(axis, lineno, direction.coordinate_system());
+    bounds.lod = lod;
 
-    auto const& lower = bounds.bounds.lower;
-    auto const& upper = bounds.bounds.upper;
+    SubCube slice(bounds);
+    slice.set_slice(axis, linenos.front(), direction.coordinate_system());
 
     auto json_shape = [&](Axis const &x, Axis const &y) {
-        meta["x"] = json_axis(x, bounds);
-        meta["y"] = json_axis(y, bounds);
+        meta["x"] = json_axis(x, slice);
+        meta["y"] = json_axis(y, slice);
         meta["shape"] = nlohmann::json::array({
-            upper[y.dimension()] - lower[y.dimension()],
-            upper[x.dimension()] - lower[x.dimension()],
+            slice.nsamples(y.dimension()),
+            slice.nsamples(x.dimension()),
         });
     };
 
@@ -189,26 +198,81 @@ void slice_metadata(
             throw std::runtime_error("Unhandled direction");
     }
 
-    meta["geospatial"] = json_slice_geospatial(
-        metadata,
-        direction,
-        axis,
-        lineno,
-        bounds
-    );
+    for (int lineno : linenos) {
+        SubCube line(bounds);
+        line.set_slice(axis, lineno, direction.coordinate_system());
+
+        meta["geospatial"] = json_slice_geospatial(
+            metadata,
+            direction,
+            axis,
+            lineno,
+            line
+        );
+        emit(meta);
+    }
+}
+
+} // namespace
+
+namespace cppapi {
+
+void slice_metadata(
+    DataHandle& datahandle,
+    Direction const direction,
+    int lineno,
+    std::vector< Bound > const& slicebounds,
+    int lod,
+    response* out
+) {
+    nlohmann::json meta;
+    emit_slices_metadata(datahandle, direction, { lineno }, slicebounds, lod, [&](nlohmann::json doc) {
+        meta = std::move(doc);
+    });
+    return to_response(meta, out);
+}
+
+void slices_metadata(
+    DataHandle& datahandle,
+    Direction const direction,
+    std::vector< int > const& linenos,
+    std::vector< Bound > const& slicebounds,
+    int lod,
+    response* out
+) {
+    nlohmann::json meta = nlohmann::json::array();
+    emit_slices_metadata(datahandle, direction, linenos, slicebounds, lod, [&](nlohmann::json doc) {
+        meta.push_back(std::move(doc));
+    });
     return to_response(meta, out);
 }
 
 void fence_metadata(
     DataHandle& datahandle,
     size_t npoints,
+    const float* windows,
+    size_t nwindows,
+    int lod,
     response* out
 ) {
     MetadataHandle const& metadata = datahandle.get_metadata();
+    metadata.validate_lod(lod);
 
     nlohmann::json meta;
     Axis const& sample_axis = metadata.sample();
-    meta["shape"] = nlohmann::json::array({npoints, sample_axis.nsamples()});
+
+    SubCube trace(metadata);
+    trace.lod = lod;
+
+    int nsamples = trace.nsamples(sample_axis.dimension());
+    if (nwindows > 0) {
+        nsamples = VerticalWindows(sample_axis, windows, nwindows, npoints).nsamples();
+    }
+
+    meta["shape"] = nlohmann::json::array({
+        npoints,
+        nsamples
+    });
     meta["format"] = fmtstr(SingleDataHandle::format());
 
     return to_response(meta, out);
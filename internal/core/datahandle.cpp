@@ -1,12 +1,26 @@
 #include "datahandle.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <OpenVDS/KnownMetadata.h>
 #include <OpenVDS/OpenVDS.h>
 
+#include "brickcache.hpp"
 #include "exceptions.hpp"
 #include "metadatahandle.hpp"
+#include "slicecache.hpp"
 #include "subcube.hpp"
 
 namespace {
@@ -25,8 +39,501 @@ OpenVDS::InterpolationMethod to_interpolation(interpolation_method interpolation
     }
 }
 
+/**
+ * Pending read of a single VDS. Wraps the request object returned by the
+ * OpenVDS access manager.
+ */
+template< typename Request >
+class SingleReadRequest : public ReadRequest {
+public:
+    explicit SingleReadRequest(std::shared_ptr< Request > request)
+        : m_request(std::move(request))
+    {}
+
+    ~SingleReadRequest() override {
+        if (not this->m_request) return;
+        /*
+         * OpenVDS keeps writing into the buffer until the request completes,
+         * so a request cannot be abandoned while in flight. The caller owns
+         * the buffer and frees it right after this returns.
+         */
+        try {
+            this->m_request->Cancel();
+            this->m_request->WaitForCompletion();
+        } catch (...) {}
+    }
+
+    void wait() noexcept(false) override {
+        auto request = std::move(this->m_request);
+        bool const success = request->WaitForCompletion();
+
+        if (!success) {
+            throw std::runtime_error("Failed to read from VDS.");
+        }
+    }
+
+private:
+    std::shared_ptr< Request > m_request;
+};
+
+template< typename Request >
+std::unique_ptr< ReadRequest > make_read_request(
+    std::shared_ptr< Request > request
+) {
+    return std::unique_ptr< ReadRequest >(
+        new SingleReadRequest< Request >(std::move(request))
+    );
+}
+
+/**
+ * Pending read of both cubes of a DoubleDataHandle.
+ *
+ * Owns all intermediate buffers the two reads write into. Once both reads
+ * have completed, combine is run to merge the data into the caller's buffer.
+ *
+ * Note that the buffers are declared before the requests, so that the requests
+ * are cancelled and completed before the buffers are freed.
+ */
+class DoubleReadRequest : public ReadRequest {
+public:
+    void wait() noexcept(false) override {
+        this->request_a->wait();
+        this->request_b->wait();
+        this->combine();
+    }
+
+    std::vector< float > coordinates_a;
+    std::vector< float > coordinates_b;
+    std::vector< float > buffer_a;
+    std::vector< float > buffer_b;
+
+    std::unique_ptr< ReadRequest > request_a;
+    std::unique_ptr< ReadRequest > request_b;
+
+    std::function< void() > combine;
+};
+
+/**
+ * Read that runs then() once the underlying read, if any, has completed.
+ */
+class ContinuedReadRequest : public ReadRequest {
+public:
+    ContinuedReadRequest(
+        std::unique_ptr< ReadRequest > request,
+        std::function< void() > then
+    ) : m_request(std::move(request)),
+        m_then(std::move(then))
+    {}
+
+    void wait() noexcept(false) override {
+        if (this->m_request) this->m_request->wait();
+        this->m_then();
+    }
+
+private:
+    std::unique_ptr< ReadRequest > m_request;
+    std::function< void() > m_then;
+};
+
+std::unique_ptr< ReadRequest > request_volume_subset(
+    OpenVDS::VolumeDataAccessManager& access_manager,
+    void* const buffer,
+    std::int64_t size,
+    SubCube const& subcube,
+    int channel
+) {
+    auto request = access_manager.RequestVolumeSubset(
+        buffer,
+        size,
+        OpenVDS::Dimensions_012,
+        subcube.lod,
+        channel,
+        subcube.bounds.lower,
+        subcube.bounds.upper,
+        SingleDataHandle::format()
+    );
+    return make_read_request(std::move(request));
+}
+
+using BrickIndex = std::array< int, 3 >;
+
+/**
+ * The brick grid of a VDS at a level of detail. Sample indices and extents
+ * are given at the level of detail, unless stated otherwise.
+ */
+class BrickGrid {
+public:
+    /**
+     * @param volume     Bounds of the whole VDS
+     * @param lod        Level of detail
+     * @param brick_size Number of samples along each dimension of a brick
+     */
+    BrickGrid(SubCube const& volume, int lod, int brick_size)
+        : m_volume(volume), m_brick_size(brick_size)
+    {
+        this->m_volume.lod = lod;
+        for (int dim = 0; dim < 3; ++dim) {
+            this->m_size[dim] = this->m_volume.nsamples(dim);
+        }
+    }
+
+    int lod() const noexcept (true) { return this->m_volume.lod; }
+
+    /** Size of a whole brick in bytes */
+    std::size_t brick_bytes() const noexcept (true) {
+        std::size_t const size = this->m_brick_size;
+        return size * size * size * sizeof(float);
+    }
+
+    /** Number of samples in dimension */
+    int size(int dim) const noexcept (true) { return this->m_size[dim]; }
+
+    /** Index of the sample nearest to a sample position (at full resolution) */
+    int nearest(float position, int dim) const noexcept (true) {
+        int const index = static_cast< int >(std::floor(position));
+        return std::min(std::max(index, 0), this->m_size[dim] - 1);
+    }
+
+    /** First sample of the brick */
+    int origin(BrickIndex const& brick, int dim) const noexcept (true) {
+        return brick[dim] * this->m_brick_size;
+    }
+
+    /** Number of samples of the brick */
+    int extent(BrickIndex const& brick, int dim) const noexcept (true) {
+        return std::min(
+            this->m_brick_size,
+            this->m_size[dim] - this->origin(brick, dim)
+        );
+    }
+
+    BrickIndex brick_of(std::array< int, 3 > const& sample) const noexcept (true) {
+        return BrickIndex{
+            sample[0] / this->m_brick_size,
+            sample[1] / this->m_brick_size,
+            sample[2] / this->m_brick_size,
+        };
+    }
+
+    /** Position of a sample in the brick's buffer */
+    std::size_t offset(
+        BrickIndex const& brick,
+        std::array< int, 3 > const& sample
+    ) const noexcept (true) {
+        std::size_t const e0 = this->extent(brick, 0);
+        std::size_t const e1 = this->extent(brick, 1);
+        return (sample[0] - this->origin(brick, 0))
+             + e0 * ((sample[1] - this->origin(brick, 1))
+             + e1 *  (sample[2] - this->origin(brick, 2)));
+    }
+
+    /** The brick as a subcube, with bounds at full resolution */
+    SubCube subcube(BrickIndex const& brick) const noexcept (true) {
+        SubCube subcube(this->m_volume);
+        int const lod = this->lod();
+        for (int dim = 0; dim < 3; ++dim) {
+            int const upper = this->origin(brick, dim) + this->extent(brick, dim);
+            subcube.bounds.lower[dim] = this->origin(brick, dim) << lod;
+            subcube.bounds.upper[dim] = std::min(
+                upper << lod,
+                this->m_volume.bounds.upper[dim]
+            );
+        }
+        return subcube;
+    }
+
+    std::size_t nsamples(BrickIndex const& brick) const noexcept (true) {
+        return std::size_t(this->extent(brick, 0))
+             * std::size_t(this->extent(brick, 1))
+             * std::size_t(this->extent(brick, 2));
+    }
+
+    /** Number of bricks along dimension */
+    int nbricks(int dim) const noexcept (true) {
+        return (this->m_size[dim] + this->m_brick_size - 1) / this->m_brick_size;
+    }
+
+private:
+    SubCube m_volume;
+    int m_brick_size;
+    std::array< int, 3 > m_size;
+};
+
+/** Copies the samples a read needs out of a single brick */
+using BrickCopy = std::function< void(BrickIndex const&, float const*) >;
+
+/**
+ * Read assembled from bricks. Bricks found in the BrickCache are used as-is,
+ * the others are read from the VDS and inserted into the cache once they
+ * arrive. Every brick is handed to copy as soon as it is available and then
+ * released, and only a bounded number of brick reads are in flight at once.
+ * A read that touches many bricks, like a full slice of a large survey, thus
+ * never holds more than max_bytes_in_flight of bricks on top of its result.
+ */
+class BrickReadRequest : public ReadRequest {
+public:
+    /** Max size of the bricks read at once by a single request */
+    static constexpr std::size_t max_bytes_in_flight = 64 * 1024 * 1024;
+
+    BrickReadRequest(
+        OpenVDS::VolumeDataAccessManager& access_manager,
+        std::string const& url,
+        BrickGrid const& grid,
+        std::set< BrickIndex > const& bricks,
+        int channel,
+        BrickCopy copy
+    ) : access_manager(access_manager),
+        url(url),
+        grid(grid),
+        channel(channel),
+        copy(std::move(copy)),
+        max_reads(std::max< std::size_t >(1, max_bytes_in_flight / grid.brick_bytes()))
+    {
+        auto& cache = BrickCache::instance();
+        for (auto const& index : bricks) {
+            BrickCache::Key key{ url, grid.lod(), index };
+            if (cache.find(key)) {
+                this->cached.push_back(index);
+            } else {
+                this->missing.push_back(index);
+            }
+        }
+        this->issue();
+    }
+
+    void wait() noexcept(false) override {
+        auto& cache = BrickCache::instance();
+
+        /*
+         * Cached bricks are looked up again, rather than held on to from
+         * construction. One that has been evicted in the meantime is read
+         * right away.
+         */
+        for (auto const& index : this->cached) {
+            BrickCache::Key key{ this->url, this->grid.lod(), index };
+            auto brick = cache.find(key);
+            if (not brick) {
+                Read read = this->read(index);
+                read.request->wait();
+                cache.insert(read.key, read.brick);
+                brick = std::move(read.brick);
+            }
+            this->copy(index, brick->data());
+        }
+        this->cached.clear();
+
+        while (not this->reads.empty()) {
+            Read& read = this->reads.front();
+            read.request->wait();
+            cache.insert(read.key, read.brick);
+            this->copy(read.key.index, read.brick->data());
+            this->reads.pop_front();
+            this->issue();
+        }
+    }
+
+private:
+    struct Read {
+        BrickCache::Key key;
+        /* Declared before the request, so the request is cancelled first */
+        std::shared_ptr< std::vector< float > > brick;
+        std::unique_ptr< ReadRequest > request;
+    };
+
+    Read read(BrickIndex const& index) noexcept (false) {
+        BrickCache::Key key{ this->url, this->grid.lod(), index };
+        auto buffer = std::make_shared< std::vector< float > >(this->grid.nsamples(index));
+        auto request = request_volume_subset(
+            this->access_manager,
+            buffer->data(),
+            buffer->size() * sizeof(float),
+            this->grid.subcube(index),
+            this->channel
+        );
+        return Read{ std::move(key), std::move(buffer), std::move(request) };
+    }
+
+    /* Start reading missing bricks, up to max_reads at once */
+    void issue() noexcept (false) {
+        while (this->reads.size() < this->max_reads and
+               this->next < this->missing.size()
+        ) {
+            this->reads.push_back(this->read(this->missing[this->next++]));
+        }
+    }
+
+    /* A thin handle to the VDS, kept by value as the read may outlive the caller's */
+    OpenVDS::VolumeDataAccessManager access_manager;
+    std::string url;
+    BrickGrid grid;
+    int channel;
+    BrickCopy copy;
+    std::size_t max_reads;
+
+    /* Bricks that were in the cache when the read was requested */
+    std::vector< BrickIndex > cached;
+    /* Bricks to read from the VDS, of which the first next are issued */
+    std::vector< BrickIndex > missing;
+    std::size_t next = 0;
+    std::deque< Read > reads;
+};
+
+std::unique_ptr< ReadRequest > request_cached_subset(
+    OpenVDS::VolumeDataAccessManager& access_manager,
+    std::string const& url,
+    BrickGrid const& grid,
+    float* const buffer,
+    std::int64_t size,
+    SubCube const& subcube,
+    int channel
+) {
+    std::array< int, 3 > lower;
+    std::array< int, 3 > upper;
+    std::array< std::size_t, 3 > shape;
+    for (int dim = 0; dim < 3; ++dim) {
+        lower[dim] = subcube.first(dim) >> subcube.lod;
+        upper[dim] = (subcube.last(dim) >> subcube.lod) + 1;
+        shape[dim] = upper[dim] - lower[dim];
+    }
+    if (size < std::int64_t(shape[0] * shape[1] * shape[2] * sizeof(float))) {
+        throw std::runtime_error("Buffer too small for subcube");
+    }
+
+    BrickIndex const first = grid.brick_of(lower);
+    BrickIndex const last  = grid.brick_of({ upper[0] - 1, upper[1] - 1, upper[2] - 1 });
+
+    std::set< BrickIndex > bricks;
+    for (int i = first[0]; i <= last[0]; ++i)
+    for (int j = first[1]; j <= last[1]; ++j)
+    for (int k = first[2]; k <= last[2]; ++k) {
+        bricks.insert({ i, j, k });
+    }
+
+    auto copy = [=](BrickIndex const& index, float const* brick) {
+        std::array< int, 3 > from;
+        std::array< int, 3 > to;
+        for (int dim = 0; dim < 3; ++dim) {
+            int const origin = grid.origin(index, dim);
+            from[dim] = std::max(lower[dim], origin);
+            to[dim]   = std::min(upper[dim], origin + grid.extent(index, dim));
+        }
+
+        std::size_t const length = to[0] - from[0];
+        for (int k = from[2]; k < to[2]; ++k)
+        for (int j = from[1]; j < to[1]; ++j) {
+            std::size_t const dst = (from[0] - lower[0])
+                                  + shape[0] * ((j - lower[1])
+                                  + shape[1] *  (k - lower[2]));
+            std::memcpy(
+                buffer + dst,
+                brick + grid.offset(index, { from[0], j, k }),
+                length * sizeof(float)
+            );
+        }
+    };
+    return std::unique_ptr< ReadRequest >(new BrickReadRequest(
+        access_manager, url, grid, bricks, channel, std::move(copy)
+    ));
+}
+
+/**
+ * Whether reads of the grid's bricks go through the BrickCache. When the
+ * cache is disabled, or too small to hold even a single brick per shard,
+ * assembling reads from bricks would only cost memory and copies.
+ */
+bool use_brick_cache(BrickGrid const& grid) noexcept (true) {
+    return BrickCache::instance().fits(grid.brick_bytes());
+}
+
+BrickGrid full_resolution_grid(SingleMetadataHandle const& metadata) noexcept (false) {
+    return BrickGrid(SubCube(metadata), 0, metadata.brick_size());
+}
+
+std::unique_ptr< ReadRequest > request_subset(
+    OpenVDS::VolumeDataAccessManager& access_manager,
+    std::string const& url,
+    SubCube const& volume,
+    int brick_size,
+    void* const buffer,
+    std::int64_t size,
+    SubCube const& subcube,
+    int channel
+) {
+    BrickGrid const grid(volume, subcube.lod, brick_size);
+    if (not use_brick_cache(grid)) {
+        return request_volume_subset(access_manager, buffer, size, subcube, channel);
+    }
+    return request_cached_subset(
+        access_manager, url, grid, (float*)buffer, size, subcube, channel
+    );
+}
+
+/**
+ * Copy subcube out of the cached full slice along the same line. Returns
+ * false if the subcube is not covered by the slice.
+ */
+bool copy_from_slice(
+    SliceCache::Slice const& slice,
+    SubCube const& subcube,
+    int dimension,
+    float* const buffer
+) noexcept (true) {
+    std::array< int, 3 > lower;
+    std::array< int, 3 > shape;
+    for (int dim = 0; dim < 3; ++dim) {
+        /* The slice is a single sample thick in its own dimension */
+        lower[dim] = dim == dimension ? 0 : subcube.first(dim) >> subcube.lod;
+        shape[dim] = subcube.nsamples(dim);
+        if (lower[dim] + shape[dim] > slice.shape[dim]) return false;
+    }
+
+    float const* source = slice.data.data();
+    for (int k = 0; k < shape[2]; ++k)
+    for (int j = 0; j < shape[1]; ++j) {
+        std::size_t const src = lower[0]
+                              + std::size_t(slice.shape[0]) * ((lower[1] + j)
+                              + std::size_t(slice.shape[1]) *  (lower[2] + k));
+        std::size_t const dst = std::size_t(shape[0]) * (j + std::size_t(shape[1]) * k);
+        std::memcpy(buffer + dst, source + src, shape[0] * sizeof(float));
+    }
+    return true;
+}
+
 } /* namespace */
 
+void DataHandle::read_subcube(
+    void* const buffer,
+    std::int64_t size,
+    SubCube const& subcube
+) noexcept(false) {
+    this->request_subcube(buffer, size, subcube)->wait();
+}
+
+void DataHandle::read_traces(
+    void* const buffer,
+    std::int64_t const size,
+    voxel const* coordinates,
+    std::size_t const ntraces,
+    enum interpolation_method const interpolation_method,
+    int const lod
+) noexcept(false) {
+    this->request_traces(
+        buffer, size, coordinates, ntraces, interpolation_method, lod
+    )->wait();
+}
+
+void DataHandle::read_samples(
+    void* const buffer,
+    std::int64_t const size,
+    voxel const* samples,
+    std::size_t const nsamples,
+    enum interpolation_method const interpolation_method
+) noexcept(false) {
+    this->request_samples(
+        buffer, size, samples, nsamples, interpolation_method
+    )->wait();
+}
+
 OpenVDS::VolumeDataFormat DataHandle::format() noexcept(true) {
     /*
      * We always want to request data in OpenVDS::VolumeDataFormat::Format_R32
@@ -45,14 +552,56 @@ SingleDataHandle make_single_datahandle(
     if(error.code != 0) {
         throw std::runtime_error("Could not open VDS: " + error.string);
     }
-    return SingleDataHandle(handle);
+    return SingleDataHandle(handle, url);
 }
 
-SingleDataHandle::SingleDataHandle(OpenVDS::VDSHandle handle)
-    :m_handle(handle), m_access_manager(OpenVDS::GetAccessManager(handle)), m_metadata(SingleMetadataHandle::create(m_access_manager.GetVolumeDataLayout())) {}
+SingleDataHandle::SingleDataHandle(OpenVDS::VDSHandle handle, std::string url)
+    : m_handle(handle, [](OpenVDS::VDSHandle handle) { OpenVDS::Close(handle); }),
+      m_access_manager(OpenVDS::GetAccessManager(handle)),
+      m_metadata(SingleMetadataHandle::create(m_access_manager.GetVolumeDataLayout())),
+      m_url(std::move(url))
+{
+    /*
+     * The prefetcher is shared between copies of this handle, so it must not
+     * refer back to this particular copy. The access manager is only a thin
+     * handle to the VDS and is captured by value.
+     */
+    auto access_manager = this->m_access_manager;
+    auto const volume = SubCube(this->m_metadata);
+    int const brick_size = this->m_metadata.brick_size();
+    this->m_prefetcher = std::make_shared< SlicePrefetcher >(
+        volume,
+        [access_manager, url = this->m_url, volume, brick_size](
+            void* buffer,
+            std::int64_t size,
+            SubCube const& subcube
+        ) mutable {
+            return ::request_subset(
+                access_manager,
+                url,
+                volume,
+                brick_size,
+                buffer,
+                size,
+                subcube,
+                SingleDataHandle::channel
+            );
+        },
+        [access_manager](SubCube const& subcube) mutable {
+            return access_manager.GetVolumeSubsetBufferSize(
+                subcube.bounds.lower,
+                subcube.bounds.upper,
+                SingleDataHandle::format(),
+                subcube.lod,
+                SingleDataHandle::channel
+            );
+        }
+    );
+}
 
 void SingleDataHandle::close() {
-    OpenVDS::Close(m_handle);
+    this->m_prefetcher.reset();
+    this->m_handle.reset();
 }
 
 SingleMetadataHandle const& SingleDataHandle::get_metadata() const noexcept(true) {
@@ -75,65 +624,111 @@ std::int64_t SingleDataHandle::subcube_buffer_size(
         subcube.bounds.lower,
         subcube.bounds.upper,
         SingleDataHandle::format(),
-        SingleDataHandle::lod_level,
+        subcube.lod,
         SingleDataHandle::channel
     );
 
     return size;
 }
 
-void SingleDataHandle::read_subcube(
+std::unique_ptr< ReadRequest > SingleDataHandle::request_subcube(
     void* const buffer,
     std::int64_t size,
     SubCube const& subcube
 ) noexcept (false) {
-    auto request = this->m_access_manager.RequestVolumeSubset(
-        buffer,
-        size,
-        OpenVDS::Dimensions_012,
-        SingleDataHandle::lod_level,
-        SingleDataHandle::channel,
-        subcube.bounds.lower,
-        subcube.bounds.upper,
-        SingleDataHandle::format()
-    );
-    bool const success = request.get()->WaitForCompletion();
+    auto& cache = SliceCache::instance();
+    int const dimension = subcube.slice_dimension();
+    if (not cache.enabled() or dimension < 0) {
+        return this->m_prefetcher->request(buffer, size, subcube);
+    }
+
+    SliceCache::Key key{
+        this->m_url,
+        dimension,
+        subcube.bounds.lower[dimension],
+        subcube.lod
+    };
 
-    if (!success) {
-        throw std::runtime_error("Failed to read from VDS.");
+    auto slice = cache.find(key);
+    if (slice) {
+        if (::copy_from_slice(*slice, subcube, dimension, (float*)buffer)) {
+            return std::unique_ptr< ReadRequest >(
+                new ContinuedReadRequest(nullptr, []() {})
+            );
+        }
+    }
+
+    auto request = this->m_prefetcher->request(buffer, size, subcube);
+
+    SubCube const volume(this->m_metadata);
+    for (int dim = 0; dim < 3; ++dim) {
+        if (dim == dimension) continue;
+        if (subcube.bounds.lower[dim] != volume.bounds.lower[dim] or
+            subcube.bounds.upper[dim] != volume.bounds.upper[dim]
+        ) {
+            return request;
+        }
     }
+
+    /* A full slice, which is kept for later reads of the same line */
+    std::array< int, 3 > const shape{
+        subcube.nsamples(0),
+        subcube.nsamples(1),
+        subcube.nsamples(2),
+    };
+    return std::unique_ptr< ReadRequest >(new ContinuedReadRequest(
+        std::move(request),
+        [key = std::move(key), shape, buffer]() {
+            auto const* data = static_cast< float const* >(buffer);
+            std::size_t const nsamples = std::size_t(shape[0]) * shape[1] * shape[2];
+
+            auto slice = std::make_shared< SliceCache::Slice >();
+            slice->shape = shape;
+            slice->data.assign(data, data + nsamples);
+            SliceCache::instance().insert(key, std::move(slice));
+        }
+    ));
 }
 
-std::int64_t SingleDataHandle::traces_buffer_size(std::size_t const ntraces) noexcept(false) {
+std::int64_t SingleDataHandle::traces_buffer_size(
+    std::size_t const ntraces,
+    int const lod
+) noexcept(false) {
     int const dimension = this->get_metadata().sample().dimension();
-    return this->m_access_manager.GetVolumeTracesBufferSize(ntraces, dimension);
+    return this->m_access_manager.GetVolumeTracesBufferSize(ntraces, dimension, lod);
 }
 
-void SingleDataHandle::read_traces(
+std::unique_ptr< ReadRequest > SingleDataHandle::request_traces(
     void* const buffer,
     std::int64_t const size,
     voxel const* coordinates,
     std::size_t const ntraces,
-    enum interpolation_method const interpolation_method
+    enum interpolation_method const interpolation_method,
+    int const lod
 ) noexcept (false) {
     int const dimension = this->get_metadata().sample().dimension();
 
+    if (::use_brick_cache(::full_resolution_grid(this->m_metadata)) and
+        interpolation_method == NEAREST and
+        lod == 0
+    ) {
+        return this->request_cached_traces(
+            (float*)buffer, size, coordinates, ntraces, dimension
+        );
+    }
+
     auto request = this->m_access_manager.RequestVolumeTraces(
         (float*)buffer,
         size,
         OpenVDS::Dimensions_012,
-        SingleDataHandle::lod_level,
+        lod,
         SingleDataHandle::channel,
         coordinates,
         ntraces,
         ::to_interpolation(interpolation_method),
         dimension
     );
-    bool const success = request.get()->WaitForCompletion();
-
-    if (!success) {
-        throw std::runtime_error("Failed to read from VDS.");
-    }
+    return make_read_request(std::move(request));
 }
 
 std::int64_t SingleDataHandle::samples_buffer_size(
@@ -145,28 +740,153 @@ std::int64_t SingleDataHandle::samples_buffer_size(
     );
 }
 
-void SingleDataHandle::read_samples(
+std::unique_ptr< ReadRequest > SingleDataHandle::request_samples(
     void* const buffer,
     std::int64_t const size,
     voxel const* samples,
     std::size_t const nsamples,
     enum interpolation_method const interpolation_method
 ) noexcept (false) {
+    if (::use_brick_cache(::full_resolution_grid(this->m_metadata)) and
+        interpolation_method == NEAREST
+    ) {
+        return this->request_cached_samples((float*)buffer, size, samples, nsamples);
+    }
+
     auto request = this->m_access_manager.RequestVolumeSamples(
         (float*)buffer,
         size,
         OpenVDS::Dimensions_012,
-        SingleDataHandle::lod_level,
+        0, /* samples are always read at full resolution */
         SingleDataHandle::channel,
         samples,
         nsamples,
         ::to_interpolation(interpolation_method)
     );
+    return make_read_request(std::move(request));
+}
+
+std::unique_ptr< ReadRequest > SingleDataHandle::request_cached_traces(
+    float* const buffer,
+    std::int64_t const size,
+    voxel const* coordinates,
+    std::size_t const ntraces,
+    int const dimension
+) noexcept (false) {
+    BrickGrid const grid = ::full_resolution_grid(this->m_metadata);
+    std::size_t const length = grid.size(dimension);
+    if (size < std::int64_t(ntraces * length * sizeof(float))) {
+        throw std::runtime_error("Buffer too small for traces");
+    }
+
+    /*
+     * The traces in every column of bricks along the trace dimension. The
+     * column is keyed on its first brick, and the trace's sample index is left
+     * at 0 and iterated over when copying.
+     */
+    std::vector< std::array< int, 3 > > traces(ntraces);
+    std::map< BrickIndex, std::vector< std::size_t > > columns;
+    std::set< BrickIndex > bricks;
+    for (std::size_t i = 0; i < ntraces; ++i) {
+        for (int dim = 0; dim < 3; ++dim) {
+            if (dim == dimension) continue;
+            traces[i][dim] = grid.nearest(coordinates[i][dim], dim);
+        }
+        traces[i][dimension] = 0;
 
-    bool const success = request.get()->WaitForCompletion();
-    if (!success) {
-        throw std::runtime_error("Failed to read from VDS.");
+        BrickIndex brick = grid.brick_of(traces[i]);
+        auto& column = columns[brick];
+        if (not column.empty()) {
+            column.push_back(i);
+            continue;
+        }
+        column.push_back(i);
+        for (int k = 0; k < grid.nbricks(dimension); ++k) {
+            brick[dimension] = k;
+            bricks.insert(brick);
+        }
     }
+
+    auto copy = [=, traces = std::move(traces), columns = std::move(columns)](
+        BrickIndex const& brick,
+        float const* data
+    ) {
+        BrickIndex column = brick;
+        column[dimension] = 0;
+
+        std::size_t const stride = dimension == 0 ? 1
+            : dimension == 1 ? grid.extent(brick, 0)
+            : grid.extent(brick, 0) * grid.extent(brick, 1);
+        int const extent = grid.extent(brick, dimension);
+
+        for (std::size_t i : columns.at(column)) {
+            std::array< int, 3 > sample = traces[i];
+            sample[dimension] = grid.origin(brick, dimension);
+
+            float* trace = buffer + i * length + sample[dimension];
+            std::size_t const first = grid.offset(brick, sample);
+            for (int s = 0; s < extent; ++s) {
+                trace[s] = data[first + s * stride];
+            }
+        }
+    };
+    return std::unique_ptr< ReadRequest >(new BrickReadRequest(
+        this->m_access_manager,
+        this->m_url,
+        grid,
+        bricks,
+        SingleDataHandle::channel,
+        std::move(copy)
+    ));
+}
+
+std::unique_ptr< ReadRequest > SingleDataHandle::request_cached_samples(
+    float* const buffer,
+    std::int64_t const size,
+    voxel const* samples,
+    std::size_t const nsamples
+) noexcept (false) {
+    BrickGrid const grid = ::full_resolution_grid(this->m_metadata);
+    if (size < std::int64_t(nsamples * sizeof(float))) {
+        throw std::runtime_error("Buffer too small for samples");
+    }
+
+    /* The samples in every brick, and their positions */
+    std::vector< std::array< int, 3 > > positions(nsamples);
+    std::map< BrickIndex, std::vector< std::size_t > > in_brick;
+    std::set< BrickIndex > bricks;
+    BrickIndex previous{ -1, -1, -1 };
+    std::vector< std::size_t >* current = nullptr;
+    for (std::size_t i = 0; i < nsamples; ++i) {
+        for (int dim = 0; dim < 3; ++dim) {
+            positions[i][dim] = grid.nearest(samples[i][dim], dim);
+        }
+        /* Consecutive samples mostly fall in the same brick */
+        BrickIndex const brick = grid.brick_of(positions[i]);
+        if (brick != previous) {
+            bricks.insert(brick);
+            current = &in_brick[brick];
+            previous = brick;
+        }
+        current->push_back(i);
+    }
+
+    auto copy = [=, positions = std::move(positions), in_brick = std::move(in_brick)](
+        BrickIndex const& brick,
+        float const* data
+    ) {
+        for (std::size_t i : in_brick.at(brick)) {
+            buffer[i] = data[grid.offset(brick, positions[i])];
+        }
+    };
+    return std::unique_ptr< ReadRequest >(new BrickReadRequest(
+        this->m_access_manager,
+        this->m_url,
+        grid,
+        bricks,
+        SingleDataHandle::channel,
+        std::move(copy)
+    ));
 }
 
 DoubleDataHandle make_double_datahandle(
@@ -187,15 +907,9 @@ DoubleDataHandle::DoubleDataHandle(SingleDataHandle datahandle_a, SingleDataHand
 
     if (binary_symbol == NO_OPERATOR)
         throw detail::bad_request("Invalid function");
-    else if (binary_symbol == ADDITION)
-        this->m_binary_operator = &inplace_addition;
-    else if (binary_symbol == SUBTRACTION)
-        this->m_binary_operator = &inplace_subtraction;
-    else if (binary_symbol == MULTIPLICATION)
-        this->m_binary_operator = &inplace_multiplication;
-    else if (binary_symbol == DIVISION)
-        this->m_binary_operator = &inplace_division;
-    else
+
+    this->m_binary_operator = inplace_kernel(binary_symbol);
+    if (not this->m_binary_operator)
         throw detail::bad_request("Invalid binary_operator string");
 }
 
@@ -220,6 +934,8 @@ OpenVDS::VolumeDataFormat DoubleDataHandle::format() noexcept(true) {
 std::int64_t DoubleDataHandle::subcube_buffer_size(
     SubCube const& subcube
 ) noexcept(false) {
+    this->get_metadata().validate_lod(subcube.lod);
+
     std::int64_t size = this->m_datahandle_a.subcube_buffer_size(
         subcube
     );
@@ -227,109 +943,130 @@ std::int64_t DoubleDataHandle::subcube_buffer_size(
     return size;
 }
 
-void DoubleDataHandle::read_subcube(
+std::unique_ptr< ReadRequest > DoubleDataHandle::request_subcube(
     void* const buffer,
     std::int64_t size,
     SubCube const& subcube
 ) noexcept(false) {
+    this->get_metadata().validate_lod(subcube.lod);
 
     auto transformer = this->m_metadata.coordinate_transformer();
     SubCube subcube_a = SubCube(subcube);
     transformer.to_cube_a_voxel_position(subcube_a.bounds.lower, subcube.bounds.lower);
     transformer.to_cube_a_voxel_position(subcube_a.bounds.upper, subcube.bounds.upper);
 
-    std::vector<char> buffer_a(size);
-
-    this->m_datahandle_a.read_subcube(
-        buffer,
-        size,
-        subcube_a
-    );
-
     SubCube subcube_b = SubCube(subcube);
     transformer.to_cube_b_voxel_position(subcube_b.bounds.lower, subcube.bounds.lower);
     transformer.to_cube_b_voxel_position(subcube_b.bounds.upper, subcube.bounds.upper);
 
-    std::vector<char> buffer_b(size);
+    std::unique_ptr< DoubleReadRequest > request(new DoubleReadRequest());
+    request->buffer_b.resize((std::size_t)size / sizeof(float));
 
-    this->m_datahandle_b.read_subcube(
-        buffer_b.data(),
+    request->request_a = this->m_datahandle_a.request_subcube(
+        buffer,
+        size,
+        subcube_a
+    );
+    request->request_b = this->m_datahandle_b.request_subcube(
+        request->buffer_b.data(),
         size,
         subcube_b
     );
 
-    m_binary_operator((float*)buffer, (float* const)buffer_b.data(), (std::size_t)size / sizeof(float));
+    auto* buffer_b = &request->buffer_b;
+    auto op = this->m_binary_operator;
+    request->combine = [=]() {
+        op((float*)buffer, buffer_b->data(), buffer_b->size());
+    };
+    return request;
 }
 
-std::int64_t DoubleDataHandle::traces_buffer_size(std::size_t const ntraces) noexcept(false) {
+std::int64_t DoubleDataHandle::traces_buffer_size(
+    std::size_t const ntraces,
+    int const lod
+) noexcept(false) {
+    this->get_metadata().validate_lod(lod);
     return this->get_metadata().sample().nsamples() * ntraces * sizeof(float);
 }
 
-void DoubleDataHandle::read_traces(
+std::unique_ptr< ReadRequest > DoubleDataHandle::request_traces(
     void* const buffer,
     std::int64_t const size,
     voxel const* coordinates,
     std::size_t const ntraces,
-    enum interpolation_method const interpolation_method
+    enum interpolation_method const interpolation_method,
+    int const lod
 ) noexcept(false) {
+    this->get_metadata().validate_lod(lod);
+
     int const sample_dimension_index = this->get_metadata().sample().dimension();
     auto transformer = this->m_metadata.coordinate_transformer();
 
+    std::unique_ptr< DoubleReadRequest > request(new DoubleReadRequest());
+
     std::size_t coordinates_buffer_size = OpenVDS::Dimensionality_Max * ntraces;
-    std::vector<float> coordinates_a(coordinates_buffer_size);
+    auto& coordinates_a = request->coordinates_a;
+    coordinates_a.resize(coordinates_buffer_size);
     for (int v = 0; v < ntraces; v++) {
         transformer.to_cube_a_voxel_position(coordinates_a.data() + OpenVDS::Dimensionality_Max * v, coordinates[v]);
     }
 
-    std::vector<float> coordinates_b(coordinates_buffer_size);
+    auto& coordinates_b = request->coordinates_b;
+    coordinates_b.resize(coordinates_buffer_size);
     for (int v = 0; v < ntraces; v++) {
         transformer.to_cube_b_voxel_position(coordinates_b.data() + OpenVDS::Dimensionality_Max * v, coordinates[v]);
     }
 
-    std::size_t size_a = this->m_datahandle_a.traces_buffer_size(ntraces);
-    std::vector<float> buffer_a((std::size_t)size_a / sizeof(float));
-    this->m_datahandle_a.read_traces(
-        buffer_a.data(),
+    std::size_t size_a = this->m_datahandle_a.traces_buffer_size(ntraces, lod);
+    request->buffer_a.resize((std::size_t)size_a / sizeof(float));
+    request->request_a = this->m_datahandle_a.request_traces(
+        request->buffer_a.data(),
         size_a,
         (voxel*)coordinates_a.data(),
         ntraces,
-        interpolation_method
+        interpolation_method,
+        lod
     );
 
-    std::size_t size_b = this->m_datahandle_b.traces_buffer_size(ntraces);
-    std::vector<float> buffer_b((std::size_t)size_b / sizeof(float));
-    this->m_datahandle_b.read_traces(
-        buffer_b.data(),
+    std::size_t size_b = this->m_datahandle_b.traces_buffer_size(ntraces, lod);
+    request->buffer_b.resize((std::size_t)size_b / sizeof(float));
+    request->request_b = this->m_datahandle_b.request_traces(
+        request->buffer_b.data(),
         size_b,
         (voxel*)coordinates_b.data(),
         ntraces,
-        interpolation_method
+        interpolation_method,
+        lod
     );
 
-    // Function read_traces extracts whole traces out of corresponding files.
-    // However it could happen that data files are not fully aligned in their sample dimensions.
-    // That creates a need to extract from each trace data that make up the intersection.
-    float* floatBuffer = (float*)buffer;
-    this->extract_continuous_part_of_trace(
-        &buffer_a,
-        m_datahandle_a.get_metadata().sample().nsamples(),
-        (long)(coordinates_a[sample_dimension_index] + 0.5f),
-        this->get_metadata().sample().nsamples(),
-        floatBuffer);
+    auto* pending = request.get();
+    request->combine = [this, pending, buffer, size, ntraces, sample_dimension_index]() {
+        // Function read_traces extracts whole traces out of corresponding files.
+        // However it could happen that data files are not fully aligned in their sample dimensions.
+        // That creates a need to extract from each trace data that make up the intersection.
+        float* floatBuffer = (float*)buffer;
+        this->extract_continuous_part_of_trace(
+            &pending->buffer_a,
+            m_datahandle_a.get_metadata().sample().nsamples(),
+            (long)(pending->coordinates_a[sample_dimension_index] + 0.5f),
+            this->get_metadata().sample().nsamples(),
+            floatBuffer);
 
-    std::vector<float> res_buffer_b(this->get_metadata().sample().nsamples() * ntraces);
-    this->extract_continuous_part_of_trace(
-        &buffer_b,
-        m_datahandle_b.get_metadata().sample().nsamples(),
-        (long)(coordinates_b[sample_dimension_index] + 0.5f),
-        this->get_metadata().sample().nsamples(),
-        res_buffer_b.data());
+        std::vector<float> res_buffer_b(this->get_metadata().sample().nsamples() * ntraces);
+        this->extract_continuous_part_of_trace(
+            &pending->buffer_b,
+            m_datahandle_b.get_metadata().sample().nsamples(),
+            (long)(pending->coordinates_b[sample_dimension_index] + 0.5f),
+            this->get_metadata().sample().nsamples(),
+            res_buffer_b.data());
 
-    m_binary_operator((float*)buffer, (float* const)res_buffer_b.data(), (std::size_t)size / sizeof(float));
+        m_binary_operator((float*)buffer, (float* const)res_buffer_b.data(), (std::size_t)size / sizeof(float));
+    };
+    return request;
 }
 
 void DoubleDataHandle::extract_continuous_part_of_trace(
-    std::vector<float>* source_traces,
+    std::vector<float> const* source_traces,
     int source_trace_length,
     long start_extract_index,
     int nsamples_to_extract,
@@ -337,7 +1074,7 @@ void DoubleDataHandle::extract_continuous_part_of_trace(
 ) {
     int ntraces = source_traces->size() / source_trace_length;
     for (int i = 0; i < ntraces; ++i) {
-        float* src_trace = source_traces->data() + i * source_trace_length;
+        float const* src_trace = source_traces->data() + i * source_trace_length;
         float* dst_trace = target_buffer + i * nsamples_to_extract;
         std::memcpy(dst_trace, src_trace + start_extract_index, nsamples_to_extract * sizeof(float));
     }
@@ -349,7 +1086,7 @@ std::int64_t DoubleDataHandle::samples_buffer_size(
     return this->m_datahandle_a.samples_buffer_size(nsamples);
 }
 
-void DoubleDataHandle::read_samples(
+std::unique_ptr< ReadRequest > DoubleDataHandle::request_samples(
     void* const buffer,
     std::int64_t const size,
     voxel const* samples,
@@ -363,20 +1100,22 @@ void DoubleDataHandle::read_samples(
      * ijk positions. That shouldn't be a problem as sample positions should
      * differ from ijk positions just by half a sample.
      */
+    std::unique_ptr< DoubleReadRequest > request(new DoubleReadRequest());
+    auto transformer = this->m_metadata.coordinate_transformer();
 
-    std::vector<float> samples_a(samples_buffer_size);
-    auto transformer_a = this->m_metadata.coordinate_transformer();
+    auto& samples_a = request->coordinates_a;
+    samples_a.resize(samples_buffer_size);
     for (int v = 0; v < nsamples; v++) {
-        transformer_a.to_cube_a_voxel_position(samples_a.data() + OpenVDS::Dimensionality_Max * v, samples[v]);
+        transformer.to_cube_a_voxel_position(samples_a.data() + OpenVDS::Dimensionality_Max * v, samples[v]);
     }
 
-    std::vector<float> samples_b(samples_buffer_size);
-    auto transformer_b = this->m_metadata.coordinate_transformer();
+    auto& samples_b = request->coordinates_b;
+    samples_b.resize(samples_buffer_size);
     for (int v = 0; v < nsamples; v++) {
-        transformer_b.to_cube_b_voxel_position(samples_b.data() + OpenVDS::Dimensionality_Max * v, samples[v]);
+        transformer.to_cube_b_voxel_position(samples_b.data() + OpenVDS::Dimensionality_Max * v, samples[v]);
     }
 
-    this->m_datahandle_a.read_samples(
+    request->request_a = this->m_datahandle_a.request_samples(
         buffer,
         size,
         (voxel*)samples_a.data(),
@@ -384,39 +1123,19 @@ void DoubleDataHandle::read_samples(
         interpolation_method
     );
 
-    std::vector<float> buffer_b((std::size_t)size / sizeof(float));
-
-    this->m_datahandle_b.read_samples(
-        buffer_b.data(),
+    request->buffer_b.resize((std::size_t)size / sizeof(float));
+    request->request_b = this->m_datahandle_b.request_samples(
+        request->buffer_b.data(),
         size,
         (voxel*)samples_b.data(),
         nsamples,
         interpolation_method
     );
 
-    m_binary_operator((float*)buffer, (float* const)buffer_b.data(), (std::size_t)size / sizeof(float));
-}
-
-void inplace_subtraction(float* buffer_A, const float* buffer_B, std::size_t nsamples) noexcept(true) {
-    for (std::size_t i = 0; i < nsamples; i++) {
-        buffer_A[i] -= buffer_B[i];
-    }
-}
-
-void inplace_addition(float* buffer_A, const float* buffer_B, std::size_t nsamples) noexcept(true) {
-    for (std::size_t i = 0; i < nsamples; i++) {
-        buffer_A[i] += buffer_B[i];
-    }
-}
-
-void inplace_multiplication(float* buffer_A, const float* buffer_B, std::size_t nsamples) noexcept(true) {
-    for (std::size_t i = 0; i < nsamples; i++) {
-        buffer_A[i] *= buffer_B[i];
-    }
-}
-
-void inplace_division(float* buffer_A, const float* buffer_B, std::size_t nsamples) noexcept(true) {
-    for (std::size_t i = 0; i < nsamples; i++) {
-        buffer_A[i] /= buffer_B[i];
-    }
+    auto* buffer_b = &request->buffer_b;
+    auto op = this->m_binary_operator;
+    request->combine = [=]() {
+        op((float*)buffer, buffer_b->data(), buffer_b->size());
+    };
+    return request;
 }
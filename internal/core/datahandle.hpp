@@ -3,15 +3,36 @@
 
 #include <memory>
 #include <string>
+#include <type_traits>
 
 #include <OpenVDS/OpenVDS.h>
-#include <functional>
 
+#include "inplace_operator.hpp"
 #include "metadatahandle.hpp"
+#include "prefetcher.hpp"
 #include "subcube.hpp"
 
 using voxel = float[OpenVDS::Dimensionality_Max];
 
+/**
+ * A read issued through one of the non-blocking DataHandle::request_*
+ * functions.
+ *
+ * The buffer the data is read into, and the DataHandle the request was issued
+ * through, must outlive the request. Destroying a request that has not been
+ * waited for cancels it.
+ */
+class ReadRequest {
+public:
+    virtual ~ReadRequest() {};
+
+    /**
+     * Block until all data is written to the buffer. Throws if the read
+     * failed.
+     */
+    virtual void wait() noexcept(false) = 0;
+};
+
 class DataHandle {
 
 public:
@@ -22,7 +43,12 @@ public:
 
     virtual std::int64_t samples_buffer_size(std::size_t const nsamples) noexcept(false) = 0;
 
-    virtual void read_samples(
+    /**
+     * Issue a read of the samples without waiting for it to complete. Multiple
+     * reads can be in flight at the same time, which lets storage latencies
+     * overlap.
+     */
+    virtual std::unique_ptr< ReadRequest > request_samples(
         void* const buffer,
         std::int64_t const size,
         voxel const* samples,
@@ -30,32 +56,86 @@ public:
         enum interpolation_method const interpolation_method
     ) noexcept(false) = 0;
 
+    void read_samples(
+        void* const buffer,
+        std::int64_t const size,
+        voxel const* samples,
+        std::size_t const nsamples,
+        enum interpolation_method const interpolation_method
+    ) noexcept(false);
+
     virtual std::int64_t subcube_buffer_size(SubCube const& subcube) noexcept(false) = 0;
 
-    virtual void read_subcube(
+    /**
+     * Issue a read of the subcube without waiting for it to complete.
+     */
+    virtual std::unique_ptr< ReadRequest > request_subcube(
         void* const buffer,
         std::int64_t size,
         SubCube const& subcube
     ) noexcept(false) = 0;
 
-    virtual std::int64_t traces_buffer_size(std::size_t const ntraces) noexcept(false) = 0;
+    void read_subcube(
+        void* const buffer,
+        std::int64_t size,
+        SubCube const& subcube
+    ) noexcept(false);
 
-    virtual void read_traces(
+    virtual std::int64_t traces_buffer_size(
+        std::size_t const ntraces,
+        int const lod
+    ) noexcept(false) = 0;
+
+    /**
+     * Issue a read of the traces without waiting for it to complete.
+     *
+     * Traces are read at level of detail lod, i.e. only every 2^lod-th sample
+     * is read. The coordinates are always given at full resolution.
+     */
+    virtual std::unique_ptr< ReadRequest > request_traces(
         void* const buffer,
         std::int64_t const size,
         voxel const* coordinates,
         std::size_t const ntraces,
-        enum interpolation_method const interpolation_method
+        enum interpolation_method const interpolation_method,
+        int const lod
     ) noexcept(false) = 0;
 
+    void read_traces(
+        void* const buffer,
+        std::int64_t const size,
+        voxel const* coordinates,
+        std::size_t const ntraces,
+        enum interpolation_method const interpolation_method,
+        int const lod
+    ) noexcept(false);
+
     static OpenVDS::VolumeDataFormat format() noexcept(true);
 };
 
+/**
+ * Handle to a single opened VDS.
+ *
+ * Copies of a SingleDataHandle share the underlying VDS. The VDS is closed
+ * when the last copy referring to it is closed or destroyed, which allows the
+ * same opened VDS to be used by multiple requests at once (see
+ * DataHandlePool).
+ *
+ * Subcube reads go through a SlicePrefetcher that is shared by all copies.
+ *
+ * When the BrickCache is enabled, and large enough to hold the bricks of the
+ * VDS, subcubes, and traces and samples read with nearest interpolation, are
+ * assembled from cached bricks. Other reads go straight to OpenVDS.
+ */
 class SingleDataHandle : public DataHandle {
-    SingleDataHandle(OpenVDS::VDSHandle handle);
+    SingleDataHandle(OpenVDS::VDSHandle handle, std::string url);
     friend SingleDataHandle make_single_datahandle(const char* url, const char* credentials);
 
 public:
+    /**
+     * Release this handle's reference to the VDS. The VDS itself is only
+     * closed once no other copies refer to it.
+     */
     void close();
 
     SingleMetadataHandle const& get_metadata() const noexcept (true);
@@ -64,26 +144,30 @@ public:
 
     std::int64_t subcube_buffer_size(SubCube const& subcube) noexcept (false);
 
-    void read_subcube(
+    std::unique_ptr< ReadRequest > request_subcube(
         void * const buffer,
         std::int64_t size,
         SubCube const& subcube
     ) noexcept (false);
 
-    std::int64_t traces_buffer_size(std::size_t const ntraces) noexcept (false);
+    std::int64_t traces_buffer_size(
+        std::size_t const ntraces,
+        int const lod
+    ) noexcept (false);
 
-    void read_traces(
+    std::unique_ptr< ReadRequest > request_traces(
         void * const                    buffer,
         std::int64_t const              size,
         voxel const*                    coordinates,
         std::size_t const               ntraces,
-        enum interpolation_method const interpolation_method
+        enum interpolation_method const interpolation_method,
+        int const                       lod
     ) noexcept (false);
 
 
     std::int64_t samples_buffer_size(std::size_t const nsamples) noexcept (false);
 
-    void read_samples(
+    std::unique_ptr< ReadRequest > request_samples(
         void * const                    buffer,
         std::int64_t const              size,
         voxel const*                    samples,
@@ -92,11 +176,32 @@ public:
     ) noexcept (false);
 
 private:
-    OpenVDS::VDSHandle m_handle;
+    std::unique_ptr< ReadRequest > request_cached_traces(
+        float* const        buffer,
+        std::int64_t const  size,
+        voxel const*        coordinates,
+        std::size_t const   ntraces,
+        int const           dimension
+    ) noexcept (false);
+
+    std::unique_ptr< ReadRequest > request_cached_samples(
+        float* const        buffer,
+        std::int64_t const  size,
+        voxel const*        samples,
+        std::size_t const   nsamples
+    ) noexcept (false);
+
+    std::shared_ptr< std::remove_pointer< OpenVDS::VDSHandle >::type > m_handle;
     OpenVDS::VolumeDataAccessManager m_access_manager;
     SingleMetadataHandle m_metadata;
+    /* Identifies the VDS in the BrickCache */
+    std::string m_url;
+    /*
+     * Declared after m_handle, so that the speculative reads are completed
+     * before the VDS is closed.
+     */
+    std::shared_ptr< SlicePrefetcher > m_prefetcher;
 
-    static int constexpr lod_level = 0;
     static int constexpr channel = 0;
 };
 
@@ -125,25 +230,34 @@ public:
 
     std::int64_t subcube_buffer_size(SubCube const& subcube) noexcept(false);
 
-    void read_subcube(
+    /*
+     * Reads from both cubes are issued before waiting on either of them, so
+     * the latency of a request is that of the slowest cube rather than the sum
+     * of both.
+     */
+    std::unique_ptr< ReadRequest > request_subcube(
         void* const buffer,
         std::int64_t size,
         SubCube const& subcube
     ) noexcept(false);
 
-    std::int64_t traces_buffer_size(std::size_t const ntraces) noexcept(false);
+    std::int64_t traces_buffer_size(
+        std::size_t const ntraces,
+        int const lod
+    ) noexcept(false);
 
-    void read_traces(
+    std::unique_ptr< ReadRequest > request_traces(
         void* const buffer,
         std::int64_t const size,
         voxel const* coordinates,
         std::size_t const ntraces,
-        enum interpolation_method const interpolation_method
+        enum interpolation_method const interpolation_method,
+        int const lod
     ) noexcept(false);
 
     std::int64_t samples_buffer_size(std::size_t const nsamples) noexcept(false);
 
-    void read_samples(
+    std::unique_ptr< ReadRequest > request_samples(
         void* const buffer,
         std::int64_t const size,
         voxel const* samples,
@@ -155,14 +269,13 @@ private:
     SingleDataHandle m_datahandle_a;
     SingleDataHandle m_datahandle_b;
     DoubleMetadataHandle m_metadata;
-    std::function<void(float*, const float*, std::size_t)> m_binary_operator;
+    inplace_operator m_binary_operator;
 
-    static int constexpr lod_level = 0;
     static int constexpr channel = 0;
 
     SubCube offset_bounds(const SubCube subcube, SingleMetadataHandle metadata);
     void extract_continuous_part_of_trace(
-        std::vector<float>* source_traces,
+        std::vector<float> const* source_traces,
         int source_trace_length,
         long start_extract_index,
         int nsamples_to_extract,
@@ -176,28 +289,4 @@ DoubleDataHandle make_double_datahandle(
     enum binary_operator bin_operator
 ) noexcept(false);
 
-void inplace_subtraction(
-    float* buffer_A,
-    const float* buffer_B,
-    std::size_t nsamples
-) noexcept(true);
-
-void inplace_addition(
-    float* buffer_A,
-    const float* buffer_B,
-    std::size_t nsamples
-) noexcept(true);
-
-void inplace_multiplication(
-    float* buffer_A,
-    const float* buffer_B,
-    std::size_t nsamples
-) noexcept(true);
-
-void inplace_division(
-    float* buffer_A,
-    const float* buffer_B,
-    std::size_t nsamples
-) noexcept(true);
-
 #endif /* ONESEISMIC_API_DATAHANDLE_HPP */
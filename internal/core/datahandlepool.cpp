@@ -0,0 +1,106 @@
+#include "datahandlepool.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+
+#include "datahandle.hpp"
+
+DataHandlePool& DataHandlePool::instance() noexcept (true) {
+    static DataHandlePool pool;
+    return pool;
+}
+
+SingleDataHandle DataHandlePool::acquire(
+    const char* url,
+    const char* credentials
+) noexcept (false) {
+    Key key(url, credentials);
+    auto const now = clock::now();
+
+    {
+        std::lock_guard< std::mutex > lock(this->m_mutex);
+        this->evict_idle(now);
+
+        auto it = this->m_entries.find(key);
+        if (it != this->m_entries.end()) {
+            it->second.last_used = now;
+            return it->second.handle;
+        }
+    }
+
+    /*
+     * Opening the VDS is slow, so it is done without holding the lock. If two
+     * callers race to open the same VDS, the first one to finish ends up in
+     * the pool and the other handle is simply closed when its caller is done
+     * with it.
+     */
+    SingleDataHandle handle = make_single_datahandle(url, credentials);
+
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    if (this->m_max_idle.count() == 0 or this->m_max_size == 0) {
+        return handle;
+    }
+
+    auto it = this->m_entries.find(key);
+    if (it != this->m_entries.end()) {
+        it->second.last_used = now;
+        return it->second.handle;
+    }
+
+    if (this->m_entries.size() >= this->m_max_size) {
+        this->evict_least_recently_used();
+    }
+    this->m_entries.emplace(std::move(key), Entry{ handle, now });
+    return handle;
+}
+
+void DataHandlePool::configure(
+    std::chrono::seconds max_idle,
+    std::size_t max_size
+) noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    this->m_max_idle = max_idle;
+    this->m_max_size = max_size;
+
+    if (this->m_max_idle.count() == 0) {
+        this->m_entries.clear();
+        return;
+    }
+    while (this->m_entries.size() > this->m_max_size) {
+        this->evict_least_recently_used();
+    }
+}
+
+void DataHandlePool::clear() noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    this->m_entries.clear();
+}
+
+std::size_t DataHandlePool::size() const noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    return this->m_entries.size();
+}
+
+void DataHandlePool::evict_idle(clock::time_point now) {
+    for (auto it = this->m_entries.begin(); it != this->m_entries.end();) {
+        if (now - it->second.last_used > this->m_max_idle) {
+            it = this->m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DataHandlePool::evict_least_recently_used() {
+    auto oldest = std::min_element(
+        this->m_entries.begin(),
+        this->m_entries.end(),
+        [](auto const& lhs, auto const& rhs) {
+            return lhs.second.last_used < rhs.second.last_used;
+        }
+    );
+    if (oldest != this->m_entries.end()) {
+        this->m_entries.erase(oldest);
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef ONESEISMIC_API_DATAHANDLEPOOL_HPP
+#define ONESEISMIC_API_DATAHANDLEPOOL_HPP
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "datahandle.hpp"
+
+/**
+ * Process-wide pool of opened VDS handles.
+ *
+ * Opening a VDS means fetching and parsing the layout from storage, and every
+ * newly opened VDS starts out with a cold OpenVDS chunk cache. The pool keeps
+ * handles open between requests so that requests to the same VDS can share a
+ * single opened instance.
+ *
+ * Handles are keyed on both url and credentials. A handle opened with one set
+ * of credentials is thus never handed out to a caller presenting different
+ * ones.
+ *
+ * Handles are reference counted (see SingleDataHandle). Evicting a handle from
+ * the pool only drops the pool's own reference, so requests still using the
+ * handle are not affected.
+ *
+ * The pool is disabled (max idle time of 0) by default, in which case acquire()
+ * simply opens a new handle for every call.
+ */
+class DataHandlePool {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static DataHandlePool& instance() noexcept (true);
+
+    /**
+     * Get a handle to the VDS at url. The handle is shared with other callers
+     * of acquire() with the same url and credentials. Release it by calling
+     * close() on the returned handle.
+     */
+    SingleDataHandle acquire(
+        const char* url,
+        const char* credentials
+    ) noexcept (false);
+
+    /**
+     * Configure the pool.
+     *
+     * @param max_idle Time a handle is kept in the pool after it was last
+     * acquired. Zero disables pooling.
+     * @param max_size Max number of handles kept in the pool. When the pool is
+     * full the least recently acquired handle is evicted.
+     */
+    void configure(
+        std::chrono::seconds max_idle,
+        std::size_t max_size
+    ) noexcept (true);
+
+    /** Drop the pool's references to all handles */
+    void clear() noexcept (true);
+
+    /** Number of handles currently kept in the pool */
+    std::size_t size() const noexcept (true);
+
+private:
+    DataHandlePool() = default;
+
+    struct Entry {
+        SingleDataHandle  handle;
+        clock::time_point last_used;
+    };
+
+    using Key = std::pair< std::string, std::string >;
+
+    void evict_idle(clock::time_point now);
+    void evict_least_recently_used();
+
+    mutable std::mutex m_mutex;
+    std::map< Key, Entry > m_entries;
+
+    std::chrono::seconds m_max_idle{0};
+    std::size_t m_max_size = 64;
+};
+
+#endif /* ONESEISMIC_API_DATAHANDLEPOOL_HPP */
@@ -0,0 +1,234 @@
+#include "inplace_operator.hpp"
+
+#include <cstddef>
+
+#include "ctypes.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #if defined(__GNUC__) || defined(__clang__)
+        #define ONESEISMIC_API_X86_KERNELS
+        #include <immintrin.h>
+    #endif
+#endif
+
+namespace {
+
+/*
+ * Each operator is described by a struct with one function per instruction
+ * set. The loops below are shared between all operators, so that adding an
+ * operator or an instruction set is a matter of filling in the blanks.
+ *
+ * Note that all loops use unaligned loads and stores. The buffers come
+ * straight from OpenVDS and std::vector, neither of which give any alignment
+ * guarantees beyond that of float, and on any cpu with avx2 or later unaligned
+ * access to aligned memory is as fast as aligned access.
+ */
+
+struct addition {
+    static float scalar(float a, float b) noexcept { return a + b; }
+#ifdef ONESEISMIC_API_X86_KERNELS
+    __attribute__((target("sse2")))
+    static __m128 sse2(__m128 a, __m128 b) noexcept { return _mm_add_ps(a, b); }
+    __attribute__((target("avx2")))
+    static __m256 avx2(__m256 a, __m256 b) noexcept { return _mm256_add_ps(a, b); }
+    __attribute__((target("avx512f")))
+    static __m512 avx512(__m512 a, __m512 b) noexcept { return _mm512_add_ps(a, b); }
+#endif
+};
+
+struct subtraction {
+    static float scalar(float a, float b) noexcept { return a - b; }
+#ifdef ONESEISMIC_API_X86_KERNELS
+    __attribute__((target("sse2")))
+    static __m128 sse2(__m128 a, __m128 b) noexcept { return _mm_sub_ps(a, b); }
+    __attribute__((target("avx2")))
+    static __m256 avx2(__m256 a, __m256 b) noexcept { return _mm256_sub_ps(a, b); }
+    __attribute__((target("avx512f")))
+    static __m512 avx512(__m512 a, __m512 b) noexcept { return _mm512_sub_ps(a, b); }
+#endif
+};
+
+struct multiplication {
+    static float scalar(float a, float b) noexcept { return a * b; }
+#ifdef ONESEISMIC_API_X86_KERNELS
+    __attribute__((target("sse2")))
+    static __m128 sse2(__m128 a, __m128 b) noexcept { return _mm_mul_ps(a, b); }
+    __attribute__((target("avx2")))
+    static __m256 avx2(__m256 a, __m256 b) noexcept { return _mm256_mul_ps(a, b); }
+    __attribute__((target("avx512f")))
+    static __m512 avx512(__m512 a, __m512 b) noexcept { return _mm512_mul_ps(a, b); }
+#endif
+};
+
+/*
+ * Division by zero is well defined in IEEE 754 and the vector instructions
+ * produce the same +/-inf and nan as the scalar division, so no special
+ * handling (and no branching) is needed for zero divisors. Floating point
+ * exceptions are masked by default, so the division never traps.
+ */
+struct division {
+    static float scalar(float a, float b) noexcept { return a / b; }
+#ifdef ONESEISMIC_API_X86_KERNELS
+    __attribute__((target("sse2")))
+    static __m128 sse2(__m128 a, __m128 b) noexcept { return _mm_div_ps(a, b); }
+    __attribute__((target("avx2")))
+    static __m256 avx2(__m256 a, __m256 b) noexcept { return _mm256_div_ps(a, b); }
+    __attribute__((target("avx512f")))
+    static __m512 avx512(__m512 a, __m512 b) noexcept { return _mm512_div_ps(a, b); }
+#endif
+};
+
+template< typename Op >
+void inplace_scalar(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept {
+    for (std::size_t i = 0; i < nsamples; i++) {
+        buffer_A[i] = Op::scalar(buffer_A[i], buffer_B[i]);
+    }
+}
+
+#ifdef ONESEISMIC_API_X86_KERNELS
+
+template< typename Op >
+__attribute__((target("sse2")))
+void inplace_sse2(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept {
+    std::size_t i = 0;
+    for (; i + 4 <= nsamples; i += 4) {
+        __m128 const a = _mm_loadu_ps(buffer_A + i);
+        __m128 const b = _mm_loadu_ps(buffer_B + i);
+        _mm_storeu_ps(buffer_A + i, Op::sse2(a, b));
+    }
+    for (; i < nsamples; i++) {
+        buffer_A[i] = Op::scalar(buffer_A[i], buffer_B[i]);
+    }
+}
+
+template< typename Op >
+__attribute__((target("avx2")))
+void inplace_avx2(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept {
+    std::size_t i = 0;
+    /*
+     * Two independent vectors per iteration keeps both load ports busy and
+     * hides the latency of the (slow) division.
+     */
+    for (; i + 16 <= nsamples; i += 16) {
+        __m256 const a0 = _mm256_loadu_ps(buffer_A + i);
+        __m256 const a1 = _mm256_loadu_ps(buffer_A + i + 8);
+        __m256 const b0 = _mm256_loadu_ps(buffer_B + i);
+        __m256 const b1 = _mm256_loadu_ps(buffer_B + i + 8);
+        _mm256_storeu_ps(buffer_A + i,     Op::avx2(a0, b0));
+        _mm256_storeu_ps(buffer_A + i + 8, Op::avx2(a1, b1));
+    }
+    for (; i + 8 <= nsamples; i += 8) {
+        __m256 const a = _mm256_loadu_ps(buffer_A + i);
+        __m256 const b = _mm256_loadu_ps(buffer_B + i);
+        _mm256_storeu_ps(buffer_A + i, Op::avx2(a, b));
+    }
+    for (; i < nsamples; i++) {
+        buffer_A[i] = Op::scalar(buffer_A[i], buffer_B[i]);
+    }
+}
+
+template< typename Op >
+__attribute__((target("avx512f")))
+void inplace_avx512(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept {
+    std::size_t i = 0;
+    for (; i + 16 <= nsamples; i += 16) {
+        __m512 const a = _mm512_loadu_ps(buffer_A + i);
+        __m512 const b = _mm512_loadu_ps(buffer_B + i);
+        _mm512_storeu_ps(buffer_A + i, Op::avx512(a, b));
+    }
+    /*
+     * Masked lanes are neither loaded from nor stored to, so the tail is
+     * handled without reading past the end of the buffers.
+     */
+    if (i < nsamples) {
+        __mmask16 const mask = (__mmask16)((1u << (nsamples - i)) - 1u);
+        __m512 const a = _mm512_maskz_loadu_ps(mask, buffer_A + i);
+        __m512 const b = _mm512_maskz_loadu_ps(mask, buffer_B + i);
+        _mm512_mask_storeu_ps(buffer_A + i, mask, Op::avx512(a, b));
+    }
+}
+
+#endif /* ONESEISMIC_API_X86_KERNELS */
+
+template< typename Op >
+inplace_operator kernel(instruction_set isa) noexcept {
+    switch (isa) {
+        case instruction_set::SCALAR: return &inplace_scalar< Op >;
+#ifdef ONESEISMIC_API_X86_KERNELS
+        case instruction_set::SSE2:   return &inplace_sse2< Op >;
+        case instruction_set::AVX2:   return &inplace_avx2< Op >;
+        case instruction_set::AVX512: return &inplace_avx512< Op >;
+#endif
+        default: return nullptr;
+    }
+}
+
+instruction_set detect_instruction_set() noexcept {
+#ifdef ONESEISMIC_API_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return instruction_set::AVX512;
+    if (__builtin_cpu_supports("avx2"))    return instruction_set::AVX2;
+    if (__builtin_cpu_supports("sse2"))    return instruction_set::SSE2;
+#endif
+    return instruction_set::SCALAR;
+}
+
+} /* namespace */
+
+instruction_set supported_instruction_set() noexcept(true) {
+    static instruction_set const isa = detect_instruction_set();
+    return isa;
+}
+
+inplace_operator inplace_kernel(
+    enum binary_operator binary_symbol,
+    instruction_set isa
+) noexcept(true) {
+    switch (binary_symbol) {
+        case ADDITION:       return kernel< addition >(isa);
+        case SUBTRACTION:    return kernel< subtraction >(isa);
+        case MULTIPLICATION: return kernel< multiplication >(isa);
+        case DIVISION:       return kernel< division >(isa);
+        default:             return nullptr;
+    }
+}
+
+inplace_operator inplace_kernel(enum binary_operator binary_symbol) noexcept(true) {
+    return inplace_kernel(binary_symbol, supported_instruction_set());
+}
+
+void inplace_subtraction(float* buffer_A, const float* buffer_B, std::size_t nsamples) noexcept(true) {
+    static inplace_operator const op = inplace_kernel(SUBTRACTION);
+    op(buffer_A, buffer_B, nsamples);
+}
+
+void inplace_addition(float* buffer_A, const float* buffer_B, std::size_t nsamples) noexcept(true) {
+    static inplace_operator const op = inplace_kernel(ADDITION);
+    op(buffer_A, buffer_B, nsamples);
+}
+
+void inplace_multiplication(float* buffer_A, const float* buffer_B, std::size_t nsamples) noexcept(true) {
+    static inplace_operator const op = inplace_kernel(MULTIPLICATION);
+    op(buffer_A, buffer_B, nsamples);
+}
+
+void inplace_division(float* buffer_A, const float* buffer_B, std::size_t nsamples) noexcept(true) {
+    static inplace_operator const op = inplace_kernel(DIVISION);
+    op(buffer_A, buffer_B, nsamples);
+}
@@ -0,0 +1,83 @@
+#ifndef ONESEISMIC_API_INPLACE_OPERATOR_HPP
+#define ONESEISMIC_API_INPLACE_OPERATOR_HPP
+
+#include <cstddef>
+
+#include "ctypes.h"
+
+/**
+ * Elementwise binary operator applied in place, i.e.
+ *
+ *     buffer_A[i] = buffer_A[i] <op> buffer_B[i], 0 <= i < nsamples
+ *
+ * The result follows IEEE 754 for all inputs. In particular, division by zero
+ * gives +/-inf (or nan for 0 / 0), exactly as the scalar loop would.
+ */
+using inplace_operator = void (*)(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept;
+
+/**
+ * Instruction sets the inplace operators are implemented for, ordered from
+ * narrowest to widest.
+ */
+enum class instruction_set {
+    SCALAR = 0,
+    SSE2   = 1,
+    AVX2   = 2,
+    AVX512 = 3,
+};
+
+/**
+ * Widest instruction set that is both compiled into this build and supported
+ * by the running CPU. Detected once and cached.
+ */
+instruction_set supported_instruction_set() noexcept(true);
+
+/**
+ * Get the kernel implementing binary_symbol with the given instruction set.
+ *
+ * Returns nullptr if binary_symbol is not an arithmetic operator, or if the
+ * instruction set is not compiled into this build. The kernel is returned
+ * regardless of what the running CPU supports, so it is up to the caller to
+ * check against supported_instruction_set() before calling it.
+ */
+inplace_operator inplace_kernel(
+    enum binary_operator binary_symbol,
+    instruction_set isa
+) noexcept(true);
+
+/**
+ * Get the kernel implementing binary_symbol with the widest instruction set
+ * supported by the running CPU, or nullptr if binary_symbol is not an
+ * arithmetic operator.
+ */
+inplace_operator inplace_kernel(enum binary_operator binary_symbol) noexcept(true);
+
+void inplace_subtraction(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept(true);
+
+void inplace_addition(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept(true);
+
+void inplace_multiplication(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept(true);
+
+void inplace_division(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept(true);
+
+#endif /* ONESEISMIC_API_INPLACE_OPERATOR_HPP */
@@ -1,5 +1,6 @@
 #include "metadatahandle.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
 #include <list>
@@ -43,6 +44,16 @@ BoundingBox MetadataHandle::bounding_box() const noexcept(false) {
     );
 }
 
+void MetadataHandle::validate_lod(int lod) const noexcept(false) {
+    int const max = this->max_lod();
+    if (lod < 0 or lod > max) {
+        throw detail::bad_request(
+            "Invalid level of detail: " + std::to_string(lod) +
+            ", valid range: [0:" + std::to_string(max) + "]"
+        );
+    }
+}
+
 namespace {
 
 void validate_dimensionality(int dimensionality) {
@@ -161,6 +172,15 @@ SingleCoordinateTransformer const& SingleMetadataHandle::coordinate_transformer(
     return this->m_coordinate_transformer;
 }
 
+int SingleMetadataHandle::max_lod() const noexcept(false) {
+    return static_cast< int >(this->m_layout->GetLayoutDescriptor().GetLODLevels());
+}
+
+int SingleMetadataHandle::brick_size() const noexcept(false) {
+    /* The layout gives the brick size as a power of two */
+    return 1 << static_cast< int >(this->m_layout->GetLayoutDescriptor().GetBrickSize());
+}
+
 Axis make_double_cube_axis(
     Axis const& axis_a,
     Axis const& axis_b,
@@ -327,6 +347,17 @@ DoubleCoordinateTransformer const& DoubleMetadataHandle::coordinate_transformer(
     return this->m_coordinate_transformer;
 }
 
+int DoubleMetadataHandle::max_lod() const noexcept(false) {
+    return 0;
+}
+
+int DoubleMetadataHandle::brick_size() const noexcept(false) {
+    return std::max(
+        this->m_metadata_a->brick_size(),
+        this->m_metadata_b->brick_size()
+    );
+}
+
 std::string DoubleMetadataHandle::operator_string() const noexcept(false) {
 
     switch (this->m_binary_symbol) {
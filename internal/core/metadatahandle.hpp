@@ -28,6 +28,21 @@ public:
 
     virtual CoordinateTransformer const& coordinate_transformer() const noexcept(false) = 0;
 
+    /** Highest level of detail available in the VDS */
+    virtual int max_lod() const noexcept(false) = 0;
+
+    /**
+     * Number of samples along each dimension of the bricks the VDS is stored
+     * in, at any level of detail
+     */
+    virtual int brick_size() const noexcept(false) = 0;
+
+    /**
+     * Throws bad_request if lod is not a level of detail available in the
+     * VDS.
+     */
+    void validate_lod(int lod) const noexcept(false);
+
 protected:
     MetadataHandle(std::unordered_map<AxisType, Axis> axes_map);
 
@@ -45,6 +60,10 @@ public:
 
     SingleCoordinateTransformer const& coordinate_transformer() const noexcept(false);
 
+    int max_lod() const noexcept(false);
+
+    int brick_size() const noexcept(false);
+
 protected:
     SingleMetadataHandle(OpenVDS::VolumeDataLayout const* const layout, std::unordered_map<AxisType, Axis> axes_map);
 
@@ -68,6 +87,19 @@ public:
 
     DoubleCoordinateTransformer const& coordinate_transformer() const noexcept(false);
 
+    /**
+     * Level of detail is not supported for binary operations. The two cubes
+     * are aligned at full resolution, and their decimated samples do not
+     * necessarily line up.
+     */
+    int max_lod() const noexcept(false);
+
+    /**
+     * The larger brick size of the two cubes. The cubes are offset from each
+     * other, so their bricks do not line up anyway.
+     */
+    int brick_size() const noexcept(false);
+
 protected:
     DoubleMetadataHandle(
         SingleMetadataHandle const* const metadata_a,
@@ -0,0 +1,237 @@
+#include "prefetcher.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "datahandle.hpp"
+#include "subcube.hpp"
+
+namespace {
+
+std::atomic< std::size_t > prefetch_depth{0};
+std::atomic< std::size_t > prefetch_max_bytes{256 * 1024 * 1024};
+
+std::atomic< std::uint64_t > prefetch_hits{0};
+std::atomic< std::uint64_t > prefetch_misses{0};
+std::atomic< std::uint64_t > prefetch_waste{0};
+
+/* Number of slices in a row with the same stride before reading ahead */
+constexpr int min_run = 2;
+
+/* Number of sequences tracked per VDS */
+constexpr std::size_t max_streams = 16;
+
+/**
+ * Read served by a speculative read. The speculative read might still be in
+ * flight, in which case wait() waits for it before copying the data to the
+ * caller's buffer.
+ */
+class PrefetchedReadRequest : public ReadRequest {
+public:
+    PrefetchedReadRequest(
+        void* buffer,
+        std::vector< char > prefetched,
+        std::unique_ptr< ReadRequest > request
+    ) : m_buffer(buffer),
+        m_prefetched(std::move(prefetched)),
+        m_request(std::move(request))
+    {}
+
+    void wait() noexcept(false) override {
+        this->m_request->wait();
+        std::memcpy(
+            this->m_buffer,
+            this->m_prefetched.data(),
+            this->m_prefetched.size()
+        );
+    }
+
+private:
+    void* m_buffer;
+    /* Declared before the request, so the request is cancelled first */
+    std::vector< char > m_prefetched;
+    std::unique_ptr< ReadRequest > m_request;
+};
+
+} /* namespace */
+
+SlicePrefetcher::SlicePrefetcher(
+    SubCube const& volume,
+    Fetch fetch,
+    BufferSize buffersize
+) : m_volume(volume),
+    m_fetch(std::move(fetch)),
+    m_buffersize(std::move(buffersize))
+{}
+
+SlicePrefetcher::~SlicePrefetcher() {
+    prefetch_waste += this->m_entries.size();
+}
+
+void SlicePrefetcher::configure(
+    std::size_t depth,
+    std::size_t max_bytes
+) noexcept(true) {
+    prefetch_depth = depth;
+    prefetch_max_bytes = max_bytes;
+}
+
+SlicePrefetcher::Statistics SlicePrefetcher::statistics() noexcept(true) {
+    return Statistics{
+        prefetch_hits.load(),
+        prefetch_misses.load(),
+        prefetch_waste.load(),
+    };
+}
+
+SlicePrefetcher::Key SlicePrefetcher::key(SubCube const& subcube) noexcept(true) {
+    Key key;
+    for (int i = 0; i < OpenVDS::Dimensionality_Max; ++i) {
+        key[i] = subcube.bounds.lower[i];
+        key[OpenVDS::Dimensionality_Max + i] = subcube.bounds.upper[i];
+    }
+    key.back() = subcube.lod;
+    return key;
+}
+
+std::unique_ptr< ReadRequest > SlicePrefetcher::request(
+    void* buffer,
+    std::int64_t size,
+    SubCube const& subcube
+) noexcept(false) {
+    std::size_t const depth = prefetch_depth;
+    int const dimension = subcube.slice_dimension();
+    if (depth == 0 or dimension < 0) {
+        return this->m_fetch(buffer, size, subcube);
+    }
+
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+
+    std::unique_ptr< ReadRequest > request;
+    auto it = this->m_entries.find(key(subcube));
+    if (it != this->m_entries.end() and
+        it->second.buffer.size() == static_cast< std::size_t >(size)
+    ) {
+        ++prefetch_hits;
+        this->m_bytes -= it->second.buffer.size();
+        request.reset(new PrefetchedReadRequest(
+            buffer,
+            std::move(it->second.buffer),
+            std::move(it->second.request)
+        ));
+        this->m_entries.erase(it);
+        this->m_order.erase(
+            std::find(this->m_order.begin(), this->m_order.end(), key(subcube))
+        );
+    } else {
+        ++prefetch_misses;
+        request = this->m_fetch(buffer, size, subcube);
+    }
+
+    /*
+     * Reading ahead is best effort. Failing to issue a speculative read must
+     * not fail the request that is actually asked for.
+     */
+    try {
+        this->update_stream(subcube, dimension);
+    } catch (...) {}
+
+    return request;
+}
+
+void SlicePrefetcher::update_stream(
+    SubCube const& subcube,
+    int dimension
+) noexcept(false) {
+    int const line = subcube.bounds.lower[dimension];
+
+    SubCube shape(subcube);
+    shape.bounds.lower[dimension] = 0;
+    shape.bounds.upper[dimension] = 0;
+    Key const id = key(shape);
+
+    auto it = this->m_streams.find(id);
+    if (it == this->m_streams.end()) {
+        if (this->m_streams.size() >= max_streams) {
+            auto oldest = this->m_streams.begin();
+            for (auto s = this->m_streams.begin(); s != this->m_streams.end(); ++s) {
+                if (s->second.last_used < oldest->second.last_used) oldest = s;
+            }
+            this->m_streams.erase(oldest);
+        }
+        this->m_streams.emplace(id, Stream{ line, 0, 0, ++this->m_clock });
+        return;
+    }
+
+    Stream& stream = it->second;
+    int const stride = line - stream.line;
+    if (stride != 0 and stride == stream.stride) {
+        ++stream.run;
+    } else {
+        stream.stride = stride;
+        stream.run = 1;
+    }
+    stream.line = line;
+    stream.last_used = ++this->m_clock;
+
+    if (stream.stride != 0 and stream.run >= min_run) {
+        this->prefetch(subcube, dimension, stream.stride, prefetch_depth);
+    }
+}
+
+void SlicePrefetcher::prefetch(
+    SubCube const& subcube,
+    int dimension,
+    int stride,
+    std::size_t depth
+) noexcept(false) {
+    std::size_t issued = 0;
+    SubCube next(subcube);
+    for (std::size_t i = 0; i < depth; ++i) {
+        next.bounds.lower[dimension] += stride;
+        next.bounds.upper[dimension] += stride;
+
+        int const line = next.bounds.lower[dimension];
+        if (line < this->m_volume.bounds.lower[dimension]) break;
+        if (line >= this->m_volume.bounds.upper[dimension]) break;
+
+        Key const id = key(next);
+        if (this->m_entries.find(id) != this->m_entries.end()) continue;
+
+        std::size_t const size = this->m_buffersize(next);
+        if (not this->make_room(size, issued)) break;
+
+        Entry entry;
+        entry.buffer.resize(size);
+        entry.request = this->m_fetch(entry.buffer.data(), size, next);
+
+        this->m_entries.emplace(id, std::move(entry));
+        this->m_order.push_back(id);
+        this->m_bytes += size;
+        ++issued;
+    }
+}
+
+bool SlicePrefetcher::make_room(
+    std::size_t size,
+    std::size_t protect
+) noexcept(true) {
+    std::size_t const max_bytes = prefetch_max_bytes;
+    if (size > max_bytes) return false;
+
+    while (this->m_bytes + size > max_bytes) {
+        /* Never evict the reads issued for the current request */
+        if (this->m_order.size() <= protect) return false;
+
+        auto it = this->m_entries.find(this->m_order.front());
+        this->m_order.pop_front();
+
+        ++prefetch_waste;
+        this->m_bytes -= it->second.buffer.size();
+        this->m_entries.erase(it);
+    }
+    return true;
+}
@@ -0,0 +1,131 @@
+#ifndef ONESEISMIC_API_PREFETCHER_HPP
+#define ONESEISMIC_API_PREFETCHER_HPP
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <OpenVDS/OpenVDS.h>
+
+#include "subcube.hpp"
+
+class ReadRequest;
+
+/**
+ * Speculative reads of slices for sequential access patterns.
+ *
+ * Users scroll through a cube slice by slice: lineno, lineno + 1,
+ * lineno + 2, and so on. The prefetcher watches the slices requested from a
+ * single VDS. When a slice is the previous slice shifted by the same stride
+ * at least twice in a row, reads of the next slices along that stride are
+ * issued before they are asked for. The next request is then served from
+ * memory, or from a read that is already in flight.
+ *
+ * Slices are told apart by their direction, level of detail and bounds in
+ * the other dimensions, so interleaved scrolling in different directions of
+ * the same VDS is tracked independently.
+ *
+ * Speculative reads are kept in a buffer that is bounded in bytes. Reads
+ * that are evicted or dropped without being used are counted as waste.
+ *
+ * Prefetching is disabled (depth of 0) by default. It is only of use when
+ * the same VDS handle serves consecutive requests, i.e. together with
+ * DataHandlePool.
+ */
+class SlicePrefetcher {
+public:
+    using Fetch = std::function<
+        std::unique_ptr< ReadRequest >(void*, std::int64_t, SubCube const&)
+    >;
+    using BufferSize = std::function< std::int64_t(SubCube const&) >;
+
+    struct Statistics {
+        /** Requests served by a speculative read */
+        std::uint64_t hits;
+        /** Requests not served by a speculative read */
+        std::uint64_t misses;
+        /** Speculative reads that were never used */
+        std::uint64_t waste;
+    };
+
+    /**
+     * @param volume     Bounds of the whole VDS. Speculative reads never go
+     *                   outside of them.
+     * @param fetch      Issue a (non-speculative) read of a subcube
+     * @param buffersize Size of the buffer needed for a subcube
+     */
+    SlicePrefetcher(SubCube const& volume, Fetch fetch, BufferSize buffersize);
+    ~SlicePrefetcher();
+
+    SlicePrefetcher(SlicePrefetcher const&) = delete;
+    SlicePrefetcher& operator=(SlicePrefetcher const&) = delete;
+
+    /**
+     * Read subcube, from the speculative buffer if possible, and issue
+     * speculative reads if the subcube continues a sequence.
+     */
+    std::unique_ptr< ReadRequest > request(
+        void* buffer,
+        std::int64_t size,
+        SubCube const& subcube
+    ) noexcept(false);
+
+    /**
+     * Configure prefetching for all VDSs.
+     *
+     * @param depth     Number of slices to read ahead. Zero disables
+     *                  prefetching.
+     * @param max_bytes Max size of the speculative buffer of a single VDS.
+     */
+    static void configure(std::size_t depth, std::size_t max_bytes) noexcept(true);
+
+    /** Counters accumulated over all VDSs since the process started */
+    static Statistics statistics() noexcept(true);
+
+private:
+    using Key = std::array< int, 2 * OpenVDS::Dimensionality_Max + 1 >;
+
+    struct Entry {
+        std::vector< char > buffer;
+        std::unique_ptr< ReadRequest > request;
+    };
+
+    struct Stream {
+        int line;
+        int stride;
+        int run;
+        std::uint64_t last_used;
+    };
+
+    static Key key(SubCube const& subcube) noexcept(true);
+
+    void update_stream(SubCube const& subcube, int dimension) noexcept(false);
+    void prefetch(
+        SubCube const& subcube,
+        int dimension,
+        int stride,
+        std::size_t depth
+    ) noexcept(false);
+    bool make_room(std::size_t size, std::size_t protect) noexcept(true);
+
+    SubCube m_volume;
+    Fetch m_fetch;
+    BufferSize m_buffersize;
+
+    std::mutex m_mutex;
+
+    std::map< Key, Entry > m_entries;
+    /* Keys of m_entries in the order the reads were issued */
+    std::deque< Key > m_order;
+    std::size_t m_bytes = 0;
+
+    std::map< Key, Stream > m_streams;
+    std::uint64_t m_clock = 0;
+};
+
+#endif /* ONESEISMIC_API_PREFETCHER_HPP */
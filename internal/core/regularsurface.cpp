@@ -10,6 +10,22 @@ Point AffineTransformation::operator*(Point p) const noexcept (true) {
     };
 };
 
+void AffineTransformation::transform(
+    double* x,
+    double* y,
+    std::size_t npoints
+) const noexcept (true) {
+    double const a = this->at(0)[0], b = this->at(0)[1], c = this->at(0)[2];
+    double const d = this->at(1)[0], e = this->at(1)[1], f = this->at(1)[2];
+
+    for (std::size_t i = 0; i < npoints; ++i) {
+        double const px = x[i];
+        double const py = y[i];
+        x[i] = a * px + b * py + c;
+        y[i] = d * px + e * py + f;
+    }
+}
+
 bool operator==(
     AffineTransformation const& left,
     AffineTransformation const& right
@@ -105,6 +121,20 @@ Point BoundedGrid::to_cdp(
     return to_cdp(row, col);
 }
 
+void BoundedGrid::row_to_cdp(
+    std::size_t const row,
+    double* x,
+    double* y
+) const noexcept (false) {
+    if (row >= this->nrows()) throw std::runtime_error("Row out of range");
+
+    for (std::size_t col = 0; col < this->ncols(); ++col) {
+        x[col] = static_cast<double>(row);
+        y[col] = static_cast<double>(col);
+    }
+    this->m_transformation.transform(x, y, this->ncols());
+}
+
 Point BoundedGrid::from_cdp(
     Point point
 ) const noexcept (false) {
@@ -118,13 +148,15 @@ std::pair<std::size_t, std::size_t> as_pair(std::size_t row, std::size_t col) {
 float &RegularSurface::operator[](std::size_t i) noexcept(false) {
     if (i >= this->m_grid.size())
         throw std::runtime_error("operator[]: index out of range");
+    if (this->m_view)
+        throw std::runtime_error("operator[]: shifted surface is read-only");
     return this->m_data[i];
 }
 
-const float &RegularSurface::operator[](std::size_t i) const noexcept(false) {
+float RegularSurface::operator[](std::size_t i) const noexcept(false) {
     if (i >= this->m_grid.size())
         throw std::runtime_error("const operator[]: index out of range");
-    return this->m_data[i];
+    return this->value(i);
 }
 
 float &RegularSurface::operator[](std::pair<std::size_t, std::size_t> p) noexcept(false) {
@@ -132,13 +164,15 @@ float &RegularSurface::operator[](std::pair<std::size_t, std::size_t> p) noexcep
         throw std::runtime_error("operator[]: index out of range");
     if (p.second >= this->m_grid.ncols())
         throw std::runtime_error("operator[]: index out of range");
+    if (this->m_view)
+        throw std::runtime_error("operator[]: shifted surface is read-only");
     return this->m_data[p.first * this->m_grid.ncols() + p.second];
 }
 
-const float &RegularSurface::operator[](std::pair<std::size_t, std::size_t> p) const noexcept(false) {
+float RegularSurface::operator[](std::pair<std::size_t, std::size_t> p) const noexcept(false) {
     if (p.first >= this->m_grid.nrows())
         throw std::runtime_error("const operator[]: index out of range");
     if (p.second >= this->m_grid.ncols())
         throw std::runtime_error("const operator[]: index out of range");
-    return this->m_data[p.first * this->m_grid.ncols() + p.second];
+    return this->value(p.first * this->m_grid.ncols() + p.second);
 }
@@ -2,6 +2,7 @@
 #define ONESEISMIC_API_REGULAR_SURFACE_HPP
 
 #include <array>
+#include <cstddef>
 
 struct Point {
     double x;
@@ -15,6 +16,13 @@ struct AffineTransformation : private std::array< std::array< double, 3>, 2 > {
 
     Point operator*(Point p) const noexcept (true);
 
+    /**
+     * Transform npoints points in place, with x and y in separate arrays.
+     * Same as operator* for every point, but written so that the compiler
+     * can vectorize it.
+     */
+    void transform(double* x, double* y, std::size_t npoints) const noexcept (true);
+
     friend bool operator==(
         AffineTransformation const& left,
         AffineTransformation const& right
@@ -95,6 +103,16 @@ struct BoundedGrid : public Grid
         std::size_t i
     ) const noexcept(false);
 
+    /**
+     * World coordinates of all points in row. x and y must have room for
+     * ncols values each.
+     */
+    void row_to_cdp(
+        std::size_t const row,
+        double* x,
+        double* y
+    ) const noexcept (false);
+
     /* World coordinates -> grid position */
     Point from_cdp(
         Point point
@@ -129,6 +147,11 @@ std::pair<std::size_t, std::size_t> as_pair(std::size_t row, std::size_t col);
  * The grid itself, although 2D by nature, is represented by a flat C array, in
  * order to pass it between Go and C++ (through C) without copying it.
  *
+ * A surface can also be a shifted view of another surface's data, where every
+ * value but the fill values is offset by a constant, see shifted(). This is
+ * how the top and bottom of a window along a surface are represented, without
+ * copying the surface.
+ *
  * [1] https://en.wikipedia.org/wiki/Affine_transformation
  */
 class RegularSurface{
@@ -138,9 +161,7 @@ public:
         float* data,
         BoundedGrid grid,
         float fillvalue
-    ) : m_data(data),
-        m_fillvalue(fillvalue),
-        m_grid(grid)
+    ) : RegularSurface(data, grid, fillvalue, 0, false)
     {}
 
     RegularSurface(
@@ -152,11 +173,27 @@ public:
     ) : RegularSurface(data, BoundedGrid(grid, nrows, ncols), fillvalue)
     {}
 
+    /**
+     * View of the same data where every value, except the fill values, is
+     * offset by offset, on top of any offset of this surface. The view is
+     * read-only and shares the data of this surface, which must outlive it.
+     */
+    RegularSurface shifted(float offset) const noexcept (true) {
+        return RegularSurface(
+            this->m_data,
+            this->m_grid,
+            this->m_fillvalue,
+            this->m_offset + offset,
+            true
+        );
+    }
+
+    /* Writable values. Throws for shifted views, even when offset is 0. */
     float(&operator[](std::size_t i) noexcept(false));
-    const float(&operator[](std::size_t i) const noexcept(false));
+    float operator[](std::size_t i) const noexcept(false);
 
     float(&operator[](std::pair<std::size_t, std::size_t>) noexcept(false));
-    const float(&operator[](std::pair<std::size_t, std::size_t>) const noexcept(false));
+    float operator[](std::pair<std::size_t, std::size_t>) const noexcept(false);
 
     float fillvalue() const noexcept (true) { return this->m_fillvalue; };
 
@@ -165,8 +202,29 @@ public:
     BoundedGrid const& grid() const noexcept(true) { return this->m_grid; };
 
 private:
+    RegularSurface(
+        float* data,
+        BoundedGrid grid,
+        float fillvalue,
+        float offset,
+        bool view
+    ) : m_data(data),
+        m_fillvalue(fillvalue),
+        m_offset(offset),
+        m_view(view),
+        m_grid(grid)
+    {}
+
+    float value(std::size_t i) const noexcept (true) {
+        float const value = this->m_data[i];
+        return value == this->m_fillvalue ? value : value + this->m_offset;
+    }
+
     float*             m_data;
     float              m_fillvalue;
+    float              m_offset;
+    /* Shifted views are read-only */
+    bool               m_view;
     const BoundedGrid m_grid;
 };
 
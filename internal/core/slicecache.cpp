@@ -0,0 +1,78 @@
+#include "slicecache.hpp"
+
+#include <mutex>
+
+namespace {
+
+std::size_t bytes(SliceCache::Slice const& slice) noexcept (true) {
+    return slice.data.size() * sizeof(float);
+}
+
+} /* namespace */
+
+SliceCache& SliceCache::instance() noexcept (true) {
+    static SliceCache cache;
+    return cache;
+}
+
+void SliceCache::configure(std::size_t max_bytes) noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    this->m_max_bytes = max_bytes;
+    this->evict(max_bytes);
+}
+
+bool SliceCache::enabled() const noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    return this->m_max_bytes != 0;
+}
+
+std::shared_ptr< SliceCache::Slice const > SliceCache::find(
+    Key const& key
+) noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+
+    auto it = this->m_index.find(key);
+    if (it == this->m_index.end()) return nullptr;
+
+    this->m_entries.splice(this->m_entries.begin(), this->m_entries, it->second);
+    return it->second->second;
+}
+
+void SliceCache::insert(
+    Key const& key,
+    std::shared_ptr< Slice const > slice
+) noexcept (false) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    if (::bytes(*slice) > this->m_max_bytes) return;
+
+    auto it = this->m_index.find(key);
+    if (it != this->m_index.end()) {
+        this->m_entries.splice(this->m_entries.begin(), this->m_entries, it->second);
+        return;
+    }
+
+    this->m_bytes += ::bytes(*slice);
+    this->m_entries.emplace_front(key, std::move(slice));
+    this->m_index.emplace(key, this->m_entries.begin());
+
+    this->evict(this->m_max_bytes);
+}
+
+void SliceCache::clear() noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    this->evict(0);
+}
+
+std::size_t SliceCache::size() const noexcept (true) {
+    std::lock_guard< std::mutex > lock(this->m_mutex);
+    return this->m_bytes;
+}
+
+void SliceCache::evict(std::size_t max_bytes) noexcept (true) {
+    while (this->m_bytes > max_bytes) {
+        auto const& last = this->m_entries.back();
+        this->m_bytes -= ::bytes(*last.second);
+        this->m_index.erase(last.first);
+        this->m_entries.pop_back();
+    }
+}
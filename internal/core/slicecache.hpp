@@ -0,0 +1,93 @@
+#ifndef ONESEISMIC_API_SLICECACHE_HPP
+#define ONESEISMIC_API_SLICECACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * Process-wide cache of full slices.
+ *
+ * Slices that span the whole VDS in the two other dimensions are kept, keyed
+ * on the url of the VDS, the dimension and (voxel) line they are taken along,
+ * and the level of detail. Any later slice of the same line, constrained or
+ * not, is a sub-rectangle of the full slice and is copied straight out of
+ * it, without going to storage. This is what happens when a user first views
+ * a whole inline and then zooms in on it.
+ *
+ * As with the BrickCache, callers must only look up slices of a VDS they
+ * have already successfully opened.
+ *
+ * The least recently used slices are evicted when the cache grows past its
+ * byte budget. The cache is disabled (budget of 0) by default.
+ */
+class SliceCache {
+public:
+    struct Key {
+        std::string vds;
+        int dimension;
+        int line;
+        int lod;
+
+        bool operator<(Key const& other) const noexcept (true) {
+            return std::tie(this->vds, this->dimension, this->line, this->lod)
+                 < std::tie(other.vds, other.dimension, other.line, other.lod);
+        }
+    };
+
+    struct Slice {
+        /**
+         * Number of samples in each of the three first dimensions, at the
+         * slice's level of detail. Samples are stored with dimension 0 as the
+         * fastest varying.
+         */
+        std::array< int, 3 > shape;
+        std::vector< float > data;
+    };
+
+    static SliceCache& instance() noexcept (true);
+
+    /**
+     * Configure the cache.
+     *
+     * @param max_bytes Max total size of the cached slices. Zero disables the
+     * cache and drops all slices.
+     */
+    void configure(std::size_t max_bytes) noexcept (true);
+
+    bool enabled() const noexcept (true);
+
+    /** Get slice, or nullptr if it is not in the cache */
+    std::shared_ptr< Slice const > find(Key const& key) noexcept (true);
+
+    void insert(Key const& key, std::shared_ptr< Slice const > slice) noexcept (false);
+
+    /** Drop all slices */
+    void clear() noexcept (true);
+
+    /** Total size of the cached slices in bytes */
+    std::size_t size() const noexcept (true);
+
+private:
+    SliceCache() = default;
+
+    using Entries = std::list< std::pair< Key, std::shared_ptr< Slice const > > >;
+
+    void evict(std::size_t max_bytes) noexcept (true);
+
+    mutable std::mutex m_mutex;
+    /* Most recently used slices first */
+    Entries m_entries;
+    std::map< Key, Entries::iterator > m_index;
+    std::size_t m_bytes = 0;
+    std::size_t m_max_bytes = 0;
+};
+
+#endif /* ONESEISMIC_API_SLICECACHE_HPP */
@@ -1,5 +1,6 @@
 #include "subcube.hpp"
 
+#include <cmath>
 #include <stdexcept>
 
 #include "axis.hpp"
@@ -82,6 +83,28 @@ SubCube::SubCube(MetadataHandle const& metadata) {
     this->bounds.upper[sample.dimension()] = sample.nsamples();
 }
 
+int SubCube::first(int dimension) const noexcept(true) {
+    return (this->bounds.lower[dimension] >> this->lod) << this->lod;
+}
+
+int SubCube::last(int dimension) const noexcept(true) {
+    return ((this->bounds.upper[dimension] - 1) >> this->lod) << this->lod;
+}
+
+int SubCube::nsamples(int dimension) const noexcept(true) {
+    return ((this->bounds.upper[dimension] - 1) >> this->lod)
+         - (this->bounds.lower[dimension] >> this->lod)
+         + 1;
+}
+
+int SubCube::slice_dimension() const noexcept(true) {
+    for (int dim = 0; dim < 3; ++dim) {
+        if (this->bounds.upper[dim] - this->bounds.lower[dim] == 1) {
+            return dim;
+        }
+    }
+    return -1;
+}
 
 void SubCube::constrain(
     MetadataHandle const& metadata,
@@ -110,3 +133,63 @@ void SubCube::set_slice(
     this->bounds.lower[axis.dimension()] = voxelline;
     this->bounds.upper[axis.dimension()] = voxelline + 1;
 }
+
+VerticalWindows::VerticalWindows(
+    Axis const& sample,
+    float const* windows,
+    std::size_t nwindows,
+    std::size_t npoints
+) {
+    if (nwindows != 1 and nwindows != npoints) {
+        throw detail::bad_request(
+            "Expected 1 or " + std::to_string(npoints) +
+            " vertical windows, got " + std::to_string(nwindows)
+        );
+    }
+
+    auto to_voxel = [&](float depth) {
+        if (not sample.inrange(depth)) {
+            throw detail::bad_request(
+                "Vertical window is out of vertical bounds. Request: " +
+                utils::to_string_with_precision(depth) +
+                ". Seismic bounds: [" + utils::to_string_with_precision(sample.min())
+                + ", " + utils::to_string_with_precision(sample.max()) + "]"
+            );
+        }
+        return int(std::round((depth - sample.min()) / sample.stepsize()));
+    };
+
+    this->m_tops.reserve(nwindows);
+    for (std::size_t i = 0; i < nwindows; ++i) {
+        float const top    = windows[2 * i];
+        float const bottom = windows[2 * i + 1];
+        if (top > bottom) {
+            throw detail::bad_request(
+                "Vertical window top " + utils::to_string_with_precision(top) +
+                " is below bottom " + utils::to_string_with_precision(bottom)
+            );
+        }
+
+        int const first = to_voxel(top);
+        int const nsamples = to_voxel(bottom) - first + 1;
+        if (i == 0) {
+            this->m_nsamples = nsamples;
+        } else if (nsamples != this->m_nsamples) {
+            throw detail::bad_request(
+                "Vertical windows must all cover the same number of samples, "
+                "window 0 covers " + std::to_string(this->m_nsamples) +
+                ", window " + std::to_string(i) + " covers " +
+                std::to_string(nsamples)
+            );
+        }
+        this->m_tops.push_back(first);
+    }
+}
+
+int VerticalWindows::top(std::size_t point) const noexcept(true) {
+    return this->m_tops.size() == 1 ? this->m_tops[0] : this->m_tops[point];
+}
+
+int VerticalWindows::nsamples() const noexcept(true) {
+    return this->m_nsamples;
+}
@@ -1,6 +1,9 @@
 #ifndef ONESEISMIC_API_SUBCUBE_HPP
 #define ONESEISMIC_API_SUBCUBE_HPP
 
+#include <cstddef>
+#include <vector>
+
 #include <OpenVDS/OpenVDS.h>
 
 #include "axis.hpp"
@@ -13,8 +16,30 @@ struct SubCube {
         int upper[OpenVDS::VolumeDataLayout::Dimensionality_Max]{1, 1, 1, 1, 1, 1};
     } bounds;
 
+    /**
+     * Level of detail to read the subcube at. At level n only every 2^n-th
+     * sample is present in each dimension, starting at sample 0. The bounds
+     * are always given at full resolution.
+     */
+    int lod = 0;
+
     SubCube(MetadataHandle const& metadata);
 
+    /** First sample in dimension that is present at the level of detail */
+    int first(int dimension) const noexcept(true);
+
+    /** Last sample (inclusive) in dimension present at the level of detail */
+    int last(int dimension) const noexcept(true);
+
+    /** Number of samples in dimension at the level of detail */
+    int nsamples(int dimension) const noexcept(true);
+
+    /**
+     * The dimension the subcube is a slice of, i.e. the first dimension where
+     * it is one sample thick. Returns -1 if the subcube is not a slice.
+     */
+    int slice_dimension() const noexcept(true);
+
     void set_slice(
         Axis const&                  axis,
         int const                    lineno,
@@ -27,4 +52,33 @@ struct SubCube {
     ) noexcept (false);
 };
 
+/**
+ * Vertical windows of a fence, i.e. the range of samples to read from each
+ * trace.
+ *
+ * Windows are given as (top, bottom) pairs in the unit of the sample axis,
+ * either a single pair for all points, or one pair per point. top and bottom
+ * snap to the nearest sample and are both inclusive. All windows must cover
+ * the same number of samples, so that the fence is still a npoints x nsamples
+ * array.
+ */
+struct VerticalWindows {
+    VerticalWindows(
+        Axis const& sample,
+        float const* windows,
+        std::size_t nwindows,
+        std::size_t npoints
+    ) noexcept (false);
+
+    /** First sample (voxel index) of the window of point */
+    int top(std::size_t point) const noexcept(true);
+
+    /** Number of samples in every window */
+    int nsamples() const noexcept(true);
+
+private:
+    std::vector< int > m_tops;
+    int m_nsamples = 0;
+};
+
 #endif /* ONESEISMIC_API_SUBCUBE_HPP */
@@ -1,14 +1,17 @@
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <exception>
+#include <limits>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "axis.hpp"
 #include "subvolume.hpp"
+#include "threadpool.hpp"
 #include "utils.hpp"
 
-#include <boost/math/interpolators/makima.hpp>
-using boost::math::interpolators::makima;
-
 static const float tolerance = 1e-3f;
 
 float floor_with_tolerance(float x) {
@@ -44,7 +47,8 @@ SurfaceBoundedSubVolume* make_subvolume(
         throw std::runtime_error("Expected surfaces to have the same plane and size");
     }
 
-    CoordinateTransformer const& transform = metadata.coordinate_transformer();
+    AffineTransformation const to_annotation =
+        metadata.coordinate_transformer().WorldToAnnotationTransformation();
 
     auto iline = metadata.iline();
     auto xline = metadata.xline();
@@ -57,7 +61,7 @@ SurfaceBoundedSubVolume* make_subvolume(
     SurfaceBoundedSubVolume* subvolume = subvolume_unique_ptr.get();
     auto const horizontal_grid = subvolume->horizontal_grid();
 
-    subvolume->m_segment_offsets[0] = 0;
+    std::size_t const ncols = horizontal_grid.ncols();
 
     /**
      * Try to establish how far away from the start each segment in the
@@ -67,8 +71,27 @@ SurfaceBoundedSubVolume* make_subvolume(
      * of the previous one. If segment is empty (because no data exists or user
      * is not interested), simply set beginning of the next segment same as
      * current one as no data is expected to be fetched.
+     *
+     * Segments are planned in blocks on the thread pool. Every block first
+     * writes the size of each segment i to m_offset_deltas[i + 1], then the
+     * sizes are summed into offsets with a parallel prefix scan. Blocks start
+     * at an offset anchor, so that every anchor is computed by one block.
      */
-    for (int i = 0; i < horizontal_grid.size(); ++i) {
+    struct Block {
+        Block(std::size_t first, std::size_t last) : first(first), last(last) {}
+
+        std::size_t first;
+        std::size_t last;
+        /* Top margins that differ from the preferred one */
+        std::vector< std::pair< std::size_t, std::uint8_t > > top_margins;
+        /* Number of samples in the block */
+        std::size_t nsamples = 0;
+        /* First cell in the block that failed, if any */
+        std::size_t error_index = std::size_t(-1);
+        std::exception_ptr error;
+    };
+
+    auto plan_segment = [&](std::size_t i, double iline_position, double xline_position, Block& block) {
         float reference_depth = reference[i];
         float top_depth = top[i];
         float bottom_depth = bottom[i];
@@ -78,8 +101,7 @@ SurfaceBoundedSubVolume* make_subvolume(
             top_depth == top.fillvalue() ||
             bottom_depth == bottom.fillvalue()
         ) {
-            subvolume->m_segment_offsets[i + 1] = subvolume->m_segment_offsets[i];
-            continue;
+            return std::size_t(0);
         }
 
         if (
@@ -91,12 +113,8 @@ SurfaceBoundedSubVolume* make_subvolume(
             );
         }
 
-        auto const cdp = horizontal_grid.to_cdp(i);
-        auto ij = transform.WorldToAnnotation({cdp.x, cdp.y, 0});
-
-        if (not iline.inrange_with_margin(ij[0]) or not xline.inrange_with_margin(ij[1])) {
-            subvolume->m_segment_offsets[i + 1] = subvolume->m_segment_offsets[i];
-            continue;
+        if (not iline.inrange_with_margin(iline_position) or not xline.inrange_with_margin(xline_position)) {
+            return std::size_t(0);
         }
 
         if (not sample.inrange(top_depth) or
@@ -166,17 +184,165 @@ SurfaceBoundedSubVolume* make_subvolume(
         }
 
         if (is_top_margin_atypical) {
-            subvolume->m_segment_top_margins.emplace(i, top_margin);
+            block.top_margins.emplace_back(i, top_margin);
+        }
+
+        return segment_blueprint.size(top_depth, bottom_depth, top_margin, bottom_margin);
+    };
+
+    std::size_t const nsegments = horizontal_grid.size();
+    std::size_t const interval = SurfaceBoundedSubVolume::offset_anchor_interval;
+    auto& anchors = subvolume->m_offset_anchors;
+    auto& deltas  = subvolume->m_offset_deltas;
+
+    ThreadPool& pool = ThreadPool::instance();
+    std::size_t const nblocks = 4 * (pool.size() + 1);
+    std::size_t const block_size =
+        std::max< std::size_t >(1, (nsegments / nblocks + interval - 1) / interval) * interval;
+    std::vector< Block > blocks;
+    for (std::size_t first = 0; first < nsegments; first += block_size) {
+        blocks.emplace_back(first, std::min(first + block_size, nsegments));
+    }
+
+    pool.parallel_for(blocks.size(), [&](std::size_t b) {
+        Block& block = blocks[b];
+
+        /*
+         * Annotated and sample positions of the current row, transformed a
+         * row at a time
+         */
+        std::vector< double > ilines(ncols);
+        std::vector< double > xlines(ncols);
+        std::vector< double > iline_positions(ncols);
+        std::vector< double > xline_positions(ncols);
+        std::size_t row = std::size_t(-1);
+
+        for (std::size_t i = block.first; i < block.last; ++i) {
+            if (i / ncols != row) {
+                row = i / ncols;
+                horizontal_grid.row_to_cdp(row, ilines.data(), xlines.data());
+                to_annotation.transform(ilines.data(), xlines.data(), ncols);
+
+                iline_positions = ilines;
+                xline_positions = xlines;
+                iline.to_sample_positions(iline_positions.data(), ncols);
+                xline.to_sample_positions(xline_positions.data(), ncols);
+            }
+
+            std::size_t const col = i % ncols;
+            subvolume->m_positions[2 * i]     = iline_positions[col];
+            subvolume->m_positions[2 * i + 1] = xline_positions[col];
+            std::size_t size;
+            try {
+                size = plan_segment(i, ilines[col], xlines[col], block);
+            } catch (...) {
+                block.error_index = i;
+                block.error = std::current_exception();
+                return;
+            }
+            deltas[i + 1] = size;
+            block.nsamples += size;
         }
+    });
+
+    /* Report the same error as planning the cells one by one would */
+    for (auto const& block : blocks) {
+        if (block.error) std::rethrow_exception(block.error);
+    }
 
-        subvolume->m_segment_offsets[i + 1] =
-            subvolume->m_segment_offsets[i] + segment_blueprint.size(top_depth, bottom_depth, top_margin, bottom_margin);
+    std::size_t start = 0;
+    std::vector< std::size_t > starts;
+    for (auto& block : blocks) {
+        starts.push_back(start);
+        start += block.nsamples;
+        subvolume->m_segment_top_margins.insert(
+            subvolume->m_segment_top_margins.end(),
+            block.top_margins.begin(),
+            block.top_margins.end()
+        );
     }
-    subvolume->m_data.reserve(subvolume->m_segment_offsets[horizontal_grid.size()]);
+
+    /*
+     * The anchor of the first segment in a block is the start of the block,
+     * and is written by the block before it, or is the first anchor, 0.
+     */
+    pool.parallel_for(blocks.size(), [&](std::size_t b) {
+        std::size_t offset = starts[b];
+        std::size_t anchor = starts[b];
+        for (std::size_t i = blocks[b].first + 1; i <= blocks[b].last; ++i) {
+            offset += deltas[i];
+            if (i % interval == 0) {
+                anchor = offset;
+                anchors[i / interval] = anchor;
+            }
+            if (offset - anchor > std::numeric_limits< std::uint32_t >::max()) {
+                throw std::runtime_error("Segments are too large to be planned");
+            }
+            deltas[i] = offset - anchor;
+        }
+    });
+
+    /*
+     * Nothing is allocated until the data is fetched, so that a subvolume
+     * larger than memory can still be tiled
+     */
+    subvolume->m_tile_bounds = { 0, horizontal_grid.size() };
+    subvolume->m_tiles.resize(1);
 
     return subvolume_unique_ptr.release();
 }
 
+std::size_t SurfaceBoundedSubVolume::tile(std::size_t max_bytes) {
+    std::size_t const max_samples = std::max< std::size_t >(max_bytes / sizeof(float), 1);
+    std::size_t const nsegments = this->horizontal_grid().size();
+
+    this->m_tile_bounds = { 0 };
+    for (std::size_t i = 0; i < nsegments; ++i) {
+        std::size_t const first = this->m_tile_bounds.back();
+        if (i > first and this->nsamples(first, i + 1) > max_samples) {
+            this->m_tile_bounds.push_back(i);
+        }
+    }
+    this->m_tile_bounds.push_back(nsegments);
+
+    this->m_tiles.clear();
+    this->m_tiles.resize(this->ntiles());
+    return this->ntiles();
+}
+
+void SurfaceBoundedSubVolume::allocate(std::size_t from, std::size_t to) {
+    if (from >= to) return;
+
+    std::size_t const tile = this->tile_of(from);
+    auto const bounds = this->tile_bounds(tile);
+    if (to > bounds.second) {
+        throw std::runtime_error(
+            "Segments [" + std::to_string(from) + ", " + std::to_string(to) +
+            ") span more than one tile"
+        );
+    }
+
+    /*
+     * The tile is sized rather than reserved, as fetch_subvolume writes into
+     * it through raw pointers. An allocated tile is left untouched, so that
+     * reads into it can run concurrently.
+     */
+    auto& data = this->m_tiles[tile];
+    std::size_t const nsamples = this->nsamples(bounds.first, bounds.second);
+    if (data.size() < nsamples) {
+        data.resize(nsamples);
+    }
+}
+
+void SurfaceBoundedSubVolume::release(std::size_t from, std::size_t to) {
+    for (std::size_t tile = 0; tile < this->ntiles(); ++tile) {
+        auto const bounds = this->tile_bounds(tile);
+        if (from <= bounds.first and bounds.second <= to) {
+            std::vector<float>().swap(this->m_tiles[tile]);
+        }
+    }
+}
+
 void SurfaceBoundedSubVolume::reinitialize(
     std::size_t index,
     RawSegment& segment
@@ -184,7 +350,7 @@ void SurfaceBoundedSubVolume::reinitialize(
     segment.reinitialize(
         m_ref[index], m_top[index], m_bottom[index],
         top_margin(index),
-        m_data.begin() + m_segment_offsets[index], m_data.begin() + m_segment_offsets[index + 1]
+        segment_begin(index), segment_begin(index) + nsamples(index, index + 1)
     );
 }
 
@@ -195,35 +361,132 @@ void SurfaceBoundedSubVolume::reinitialize(
     segment.reinitialize(m_ref[index], m_top[index], m_bottom[index]);
 }
 
-void resample(RawSegment const& src_segment, ResampledSegment& dst_segment) {
+namespace {
+
+/**
+ * Makima derivative at a sample, given the slopes of the two intervals on
+ * either side of it. Where the weights vanish, i.e. in flat regions, the
+ * derivative is 0.
+ */
+double makima_derivative(double mm2, double mm1, double m0, double m1) noexcept {
+    double const w1 = std::abs(m1 - m0) + std::abs(m1 + m0) / 2;
+    double const w2 = std::abs(mm1 - mm2) + std::abs(mm1 + mm2) / 2;
+    double const derivative = (w1 * mm1 + w2 * m0) / (w1 + w2);
+    return std::isnan(derivative) ? 0 : derivative;
+}
+
+} // namespace
+
+void resample(
+    RawSegment const& src_segment,
+    ResampledSegment& dst_segment,
+    ResampleScratch& scratch
+) {
     /**
      * Interpolation and attribute calculation should be performed on
      * doubles to avoid loss of precision in these intermediate steps.
      */
-    std::vector<double> src_points = src_segment.sample_positions();
-    /**
-     * something weird is going on here. If dst_points creation is moved after makima
-     * interpolation on machine under test whole attributes function performance
-     * became unstable. On some calls it was a bit faster than the one with
-     * current lines order, on some calls it is twice as slow. Reason is
-     * unknown.
+    std::size_t const n = src_segment.size();
+    if (n < 4) {
+        throw std::domain_error("Must be at least four data points.");
+    }
+    auto const y = src_segment.begin();
+
+    /*
+     * Positions are computed on the fly the same way the blueprint does, so
+     * that they match the sample positions bit by bit.
      */
-    std::vector<double> dst_points = dst_segment.sample_positions();
+    float const src_top = src_segment.top_sample_position();
+    float const src_step = src_segment.stepsize();
+    auto x = [src_top, src_step](int index) -> double {
+        return src_top + src_step * index;
+    };
+
+    float const dst_top = dst_segment.top_sample_position();
+    float const dst_step = dst_segment.stepsize();
+    auto dst_x = [dst_top, dst_step](int index) -> double {
+        return float(dst_top + dst_step * index);
+    };
 
-    std::vector<double> src_data(src_segment.begin(), src_segment.end());
+    /*
+     * When the destination samples are a subset of the source samples, which
+     * is the case for the default stepsize and a reference on the sample
+     * grid, the source values are copied straight over. A spline evaluated
+     * at its knots gives back the knot values, so the result is the same.
+     * Positions are compared exactly as anything else has to be interpolated.
+     */
+    if (dst_step == src_step) {
+        long const offset = std::lround((dst_top - src_top) / src_step);
+        std::size_t const size = dst_segment.size();
+        if (offset >= 0 and std::size_t(offset) + size <= n) {
+            std::size_t j = 0;
+            while (j < size and dst_x(j) == x(offset + j)) ++j;
+            if (j == size) {
+                std::copy(y + offset, y + offset + size, dst_segment.begin());
+                return;
+            }
+        }
+    }
 
     /*
-     * Regarding use of data at the array edge: in majority of cases
-     * interpolated area near the edges won't be used as segment samples.
-     * Exception are cases where user requested data near trace border. Here we
-     * allow algorithm to choose spline itself. Supplying additional edge
-     * samples with arbitrary value seems unnecessary.
+     * slopes[k + 2] is the slope between sample k and k + 1. The two first
+     * and the two last slopes are quadratic extrapolations. Regarding use of
+     * data at the array edge: in majority of cases interpolated area near the
+     * edges won't be used as segment samples. Exception are cases where user
+     * requested data near trace border. Here we allow algorithm to choose
+     * spline itself. Supplying additional edge samples with arbitrary value
+     * seems unnecessary.
      */
-    auto spline = makima<std::vector<double>>(std::move(src_points), std::move(src_data));
+    auto& slopes = scratch.slopes;
+    slopes.resize(n + 3);
+    for (std::size_t k = 0; k < n - 1; ++k) {
+        slopes[k + 2] = (double(y[k + 1]) - double(y[k])) / (x(k + 1) - x(k));
+    }
+    slopes[1]     = 2 * slopes[2]     - slopes[3];
+    slopes[0]     = 2 * slopes[1]     - slopes[2];
+    slopes[n + 1] = 2 * slopes[n]     - slopes[n - 1];
+    slopes[n + 2] = 2 * slopes[n + 1] - slopes[n];
+
+    auto& derivatives = scratch.derivatives;
+    derivatives.resize(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        derivatives[k] = makima_derivative(
+            slopes[k], slopes[k + 1], slopes[k + 2], slopes[k + 3]
+        );
+    }
 
-    auto dst = dst_segment.begin();
-    for (int j = 0; j < dst_points.size(); ++j) {
-        *dst = spline(dst_points.at(j));
-        std::advance(dst, 1);
+    /*
+     * Destination samples are increasing, so the interval they fall into is
+     * found by walking along the source rather than by searching.
+     */
+    double const first = x(0);
+    double const last  = x(n - 1);
+    std::size_t i = 0;
+    std::size_t j = 0;
+    for (auto dst = dst_segment.begin(); dst != dst_segment.end(); ++dst, ++j) {
+        double const position = dst_x(j);
+        if (position < first or position > last) {
+            throw std::domain_error(
+                "Requested position " + std::to_string(position) +
+                " is outside of segment [" + std::to_string(first) + ", " +
+                std::to_string(last) + "]"
+            );
+        }
+        if (position == last) {
+            *dst = y[n - 1];
+            continue;
+        }
+        while (x(i + 1) <= position) ++i;
+
+        double const x0 = x(i);
+        double const dx = x(i + 1) - x0;
+        double const t  = (position - x0) / dx;
+        double const y0 = y[i];
+        double const y1 = y[i + 1];
+        double const s0 = derivatives[i];
+        double const s1 = derivatives[i + 1];
+
+        *dst = (1 - t) * (1 - t) * (y0 * (1 + 2 * t) + s0 * (position - x0))
+             + t * t * (y1 * (3 - 2 * t) + dx * s1 * (t - 1));
     }
 }
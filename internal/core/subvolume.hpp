@@ -2,9 +2,11 @@
 #define ONESEISMIC_API_SUBVOLUME_HPP
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <stdexcept>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "metadatahandle.hpp"
@@ -46,6 +48,12 @@ public:
     float sample_position_at(int index, float zero_index_sample_position) const noexcept{
         return zero_index_sample_position + this->stepsize() * index;
     }
+
+    /**
+     * Distance between sequential samples (in annotated coordinate system of
+     * samples axis)
+     */
+    float stepsize() const { return m_stepsize; }
 protected:
     /**
      * @param stepsize Distance between sequential samples
@@ -73,12 +81,6 @@ protected:
                this->to_round_up_sample_number(zero_sample_offset, top_boundary) + 1;
     }
 
-    /**
-     * Distance between sequential samples (in annotated coordinate system of
-     * samples axis)
-     */
-    float stepsize() const { return m_stepsize; }
-
     /**
      * Sequence number of the closest sample that is <= position
      *
@@ -284,6 +286,14 @@ public:
         return this->blueprint()->sample_position_at(index, this->top_sample_position());
     }
 
+    /**
+     * Distance between sequential samples (in annotated coordinates of
+     * samples axis)
+     */
+    float stepsize() const noexcept {
+        return this->blueprint()->stepsize();
+    }
+
 protected:
     Segment(
         const float reference,
@@ -451,6 +461,11 @@ private:
  *
  * Data is a 3D array. Vertical axis is expected to be the fastest moving, i.e.
  * vertical samples at the same horizontal position are contiguous in memory.
+ *
+ * Data is stored in tiles of consecutive segments. By default the whole
+ * subvolume is a single tile. Every tile is allocated when it is fetched, and
+ * after a call to tile() dropped again by release(), so that only the tiles
+ * being worked on are held in memory.
  */
 class SurfaceBoundedSubVolume {
     friend SurfaceBoundedSubVolume* make_subvolume(
@@ -466,8 +481,17 @@ public:
     }
 
     std::uint8_t top_margin(std::size_t index) const {
-        return this->m_segment_top_margins.count(index)
-                   ? this->m_segment_top_margins.at(index)
+        auto const& margins = this->m_segment_top_margins;
+        auto it = std::lower_bound(
+            margins.begin(),
+            margins.end(),
+            index,
+            [](std::pair< std::size_t, std::uint8_t > const& margin, std::size_t index) {
+                return margin.first < index;
+            }
+        );
+        return (it != margins.end() and it->first == index)
+                   ? it->second
                    : this->m_segment_blueprint.preferred_margin();
     }
 
@@ -477,8 +501,8 @@ public:
             this->m_top[index],
             this->m_bottom[index],
             this->top_margin(index),
-            m_data.begin() + m_segment_offsets[index],
-            m_data.begin() + m_segment_offsets[index + 1],
+            this->segment_begin(index),
+            this->segment_begin(index) + this->nsamples(index, index + 1),
             &this->m_segment_blueprint
         );
     }
@@ -487,17 +511,59 @@ public:
      * Number if samples contained in total between segments [from, to)
      */
     std::size_t nsamples(std::size_t from_segment, std::size_t to_segment) const noexcept {
-        return this->m_segment_offsets[to_segment] - this->m_segment_offsets[from_segment];
+        return this->offset(to_segment) - this->offset(from_segment);
+    }
+
+    /**
+     * Horizontal sample position (inline, crossline) of segment index in the
+     * VDS, as computed when the subvolume was made
+     */
+    std::array< float, 2 > position(std::size_t index) const noexcept {
+        return { this->m_positions[2 * index], this->m_positions[2 * index + 1] };
     }
 
     bool is_empty(std::size_t index) const noexcept {
-        return m_segment_offsets[index] == m_segment_offsets[index + 1];
+        return this->offset(index) == this->offset(index + 1);
     }
 
+    /**
+     * Data of segment from_segment and the segments after it, up to the end
+     * of its tile.
+     */
     float* data(std::size_t from_segment) noexcept {
-        return this->m_data.data() + m_segment_offsets[from_segment];
+        std::size_t const tile = this->tile_of(from_segment);
+        return this->m_tiles[tile].data() + this->tile_offset(tile, from_segment);
+    }
+
+    /**
+     * Split the subvolume into tiles of consecutive segments, holding at most
+     * max_bytes of data each. A segment larger than max_bytes gets a tile of
+     * its own. Drops all data.
+     *
+     * @return Number of tiles
+     */
+    std::size_t tile(std::size_t max_bytes);
+
+    std::size_t ntiles() const noexcept {
+        return this->m_tile_bounds.size() - 1;
+    }
+
+    /** Segments [first, last) of tile */
+    std::pair< std::size_t, std::size_t > tile_bounds(std::size_t tile) const {
+        return { this->m_tile_bounds.at(tile), this->m_tile_bounds.at(tile + 1) };
     }
 
+    /**
+     * Make room for the data of segments [from, to), which must all be in
+     * the same tile. Tiles are allocated at most once, so different tiles
+     * can be allocated concurrently, but not the same tile. A tile shared by
+     * concurrent reads must be allocated before they start.
+     */
+    void allocate(std::size_t from, std::size_t to);
+
+    /** Drop the data of all tiles that are entirely within [from, to) */
+    void release(std::size_t from, std::size_t to);
+
     float fillvalue() const noexcept {
         return m_ref.fillvalue();
     }
@@ -523,22 +589,59 @@ private:
     )
         : m_ref(reference), m_top(top), m_bottom(bottom), m_segment_blueprint(segment_blueprint) {
 
-        this->m_segment_offsets = std::vector<std::size_t>(horizontal_grid().size() + 1);
+        std::size_t const nsegments = horizontal_grid().size();
+        this->m_offset_anchors = std::vector<std::size_t>(nsegments / offset_anchor_interval + 1);
+        this->m_offset_deltas  = std::vector<std::uint32_t>(nsegments + 1);
+        this->m_positions      = std::vector<float>(2 * nsegments);
+    }
+
+    /**
+     * Number of samples one must skip from start of the (untiled) data to get
+     * to the data of segment index.
+     */
+    std::size_t offset(std::size_t index) const noexcept {
+        return m_offset_anchors[index / offset_anchor_interval] + m_offset_deltas[index];
+    }
+
+    std::size_t tile_of(std::size_t index) const noexcept {
+        auto it = std::upper_bound(m_tile_bounds.begin(), m_tile_bounds.end(), index);
+        return std::distance(m_tile_bounds.begin(), it) - 1;
+    }
+
+    std::size_t tile_offset(std::size_t tile, std::size_t index) const noexcept {
+        return this->offset(index) - this->offset(m_tile_bounds[tile]);
     }
 
-    std::vector<float> m_data;
+    std::vector<float>::const_iterator segment_begin(std::size_t index) const noexcept {
+        std::size_t const tile = this->tile_of(index);
+        return m_tiles[tile].begin() + this->tile_offset(tile, index);
+    }
+
+    /**
+     * First segment of every tile, followed by the number of segments, i.e.
+     * tile t covers segments [m_tile_bounds[t], m_tile_bounds[t + 1]).
+     */
+    std::vector<std::size_t> m_tile_bounds;
+    std::vector< std::vector<float> > m_tiles;
     /**
-     * Distances from data start to start of every segment, i.e.
-     * m_segment_offsets[i] contains number of samples one must skip from start
-     * of m_data to get to the data of segment i.
+     * Distances from data start to start of every segment, see offset(). The
+     * distance of every offset_anchor_interval-th segment is stored in full
+     * as an anchor, and every segment stores its 32-bit distance from the
+     * anchor before it, which keeps the offsets at 4 bytes per segment.
      */
-    std::vector<std::size_t> m_segment_offsets;
+    static constexpr std::size_t offset_anchor_interval = 64;
+    std::vector<std::size_t> m_offset_anchors;
+    std::vector<std::uint32_t> m_offset_deltas;
+
+    /* Sample positions of every segment, see position() */
+    std::vector<float> m_positions;
 
     /**
      * In order to not bloat structure unnecessary, contains only margins
-     * that are different from preferred blueprint margin.
+     * that are different from preferred blueprint margin, sorted on segment
+     * index.
      */
-    std::unordered_map<std::size_t, std::uint8_t> m_segment_top_margins;
+    std::vector< std::pair< std::size_t, std::uint8_t > > m_segment_top_margins;
 
     RegularSurface const& m_ref;
     RegularSurface const& m_top;
@@ -558,9 +661,38 @@ SurfaceBoundedSubVolume* make_subvolume(
     RegularSurface const& bottom
 );
 
+/**
+ * Scratch memory for resample().
+ *
+ * Resampling needs a few buffers of the size of the source segment. A single
+ * scratch should be kept around and passed to every resample() call on the
+ * same thread, so that the buffers are allocated once and then only grow to
+ * the largest segment seen, rather than allocated anew for every cell.
+ */
+struct ResampleScratch {
+    /**
+     * Slopes between neighbouring samples, with two extrapolated slopes on
+     * either side of the segment
+     */
+    std::vector<double> slopes;
+    /** Spline derivative at every sample */
+    std::vector<double> derivatives;
+};
+
 /**
  * Resamples source segment into destination.
+ *
+ * Uses modified Akima (makima) piecewise cubic Hermite interpolation [1]. The
+ * result is the same as that of boost::math::interpolators::makima, but as
+ * samples are evenly spaced no position arrays are stored and all temporary
+ * buffers are taken from the scratch.
+ *
+ * [1] https://blogs.mathworks.com/cleve/2019/04/29/makima-piecewise-cubic-interpolation/
  */
-void resample(RawSegment const& src_segment, ResampledSegment& dst_segment);
+void resample(
+    RawSegment const& src_segment,
+    ResampledSegment& dst_segment,
+    ResampleScratch& scratch
+);
 
 #endif /* ONESEISMIC_API_SUBVOLUME_HPP */
@@ -0,0 +1,220 @@
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace {
+
+/* Set while the thread runs a task */
+thread_local bool in_task = false;
+
+} /* namespace */
+
+struct ThreadPool::Batch {
+    explicit Batch(
+        std::function< void(std::size_t) > const& fn,
+        std::size_t ntasks
+    ) : fn(fn), remaining(ntasks) {}
+
+    std::function< void(std::size_t) > const& fn;
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t remaining;
+    /* First exception thrown by any of the tasks */
+    std::exception_ptr error;
+};
+
+ThreadPool& ThreadPool::instance() noexcept (true) {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() {
+    this->start(0);
+}
+
+ThreadPool::~ThreadPool() {
+    std::unique_lock< std::shared_mutex > lock(this->m_workers_mutex);
+    this->stop();
+}
+
+void ThreadPool::configure(std::size_t nthreads) noexcept (false) {
+    std::unique_lock< std::shared_mutex > lock(this->m_workers_mutex);
+    this->stop();
+    this->start(nthreads);
+}
+
+std::size_t ThreadPool::size() const noexcept (true) {
+    std::shared_lock< std::shared_mutex > lock(this->m_workers_mutex);
+    return this->m_workers.size();
+}
+
+void ThreadPool::parallel_for(
+    std::size_t ntasks,
+    std::function< void(std::size_t) > const& fn
+) noexcept (false) {
+    /*
+     * Tasks that call parallel_for run their subtasks themselves. The cores
+     * are already busy with the outer tasks, and waiting for the pool from
+     * within a task could deadlock with configure().
+     */
+    if (ntasks == 1 or in_task) {
+        for (std::size_t i = 0; i < ntasks; ++i) fn(i);
+        return;
+    }
+    if (ntasks == 0) return;
+
+    std::shared_lock< std::shared_mutex > lock(this->m_workers_mutex);
+
+    Batch batch(fn, ntasks);
+
+    /*
+     * Tasks are dealt out over the queues, starting where the last batch
+     * stopped, so that concurrent batches are interleaved in every queue.
+     *
+     * The tasks are counted as pending before they are queued, so that a
+     * worker that takes one of them straight away never sees the count
+     * drop below zero.
+     */
+    std::size_t const nqueues = this->m_queues.size();
+    std::size_t first;
+    {
+        std::lock_guard< std::mutex > guard(this->m_mutex);
+        first = this->m_next_queue;
+        this->m_next_queue = (first + ntasks) % nqueues;
+        this->m_pending += ntasks;
+    }
+    for (std::size_t q = 0; q < std::min(ntasks, nqueues); ++q) {
+        Queue& queue = *this->m_queues[(first + q) % nqueues];
+        std::lock_guard< std::mutex > guard(queue.mutex);
+        for (std::size_t i = q; i < ntasks; i += nqueues) {
+            queue.tasks.push_back(Task{ &batch, i });
+        }
+    }
+    this->m_wake.notify_all();
+
+    /* Help out with the batch rather than sit idle */
+    Task task;
+    while (this->take(&batch, task)) {
+        run(task);
+    }
+
+    std::unique_lock< std::mutex > wait(batch.mutex);
+    batch.done.wait(wait, [&batch] { return batch.remaining == 0; });
+
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+void ThreadPool::start(std::size_t nthreads) {
+    if (nthreads == 0) {
+        nthreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (std::size_t i = 0; i < nthreads; ++i) {
+        this->m_queues.push_back(std::make_unique< Queue >());
+    }
+    for (std::size_t i = 0; i < nthreads; ++i) {
+        this->m_workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard< std::mutex > guard(this->m_mutex);
+        this->m_stop = true;
+    }
+    this->m_wake.notify_all();
+
+    for (auto& worker : this->m_workers) {
+        worker.join();
+    }
+    this->m_workers.clear();
+    this->m_queues.clear();
+    this->m_next_queue = 0;
+    this->m_stop = false;
+}
+
+void ThreadPool::work(std::size_t worker) noexcept (true) {
+    while (true) {
+        Task task;
+        if (this->take(worker, task)) {
+            run(task);
+            continue;
+        }
+
+        std::unique_lock< std::mutex > lock(this->m_mutex);
+        this->m_wake.wait(lock, [this] {
+            return this->m_stop or this->m_pending > 0;
+        });
+        /* Queued tasks are finished before stopping */
+        if (this->m_stop and this->m_pending == 0) return;
+    }
+}
+
+bool ThreadPool::take(std::size_t queue, Task& task) noexcept (true) {
+    std::size_t const nqueues = this->m_queues.size();
+    for (std::size_t i = 0; i < nqueues; ++i) {
+        Queue& victim = *this->m_queues[(queue + i) % nqueues];
+        std::lock_guard< std::mutex > guard(victim.mutex);
+        if (victim.tasks.empty()) continue;
+
+        if (i == 0) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+        } else {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+        }
+
+        std::lock_guard< std::mutex > pending(this->m_mutex);
+        --this->m_pending;
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::take(Batch const* batch, Task& task) noexcept (true) {
+    for (auto& queue : this->m_queues) {
+        std::lock_guard< std::mutex > guard(queue->mutex);
+        auto it = std::find_if(
+            queue->tasks.rbegin(),
+            queue->tasks.rend(),
+            [batch](Task const& task) { return task.batch == batch; }
+        );
+        if (it == queue->tasks.rend()) continue;
+
+        task = *it;
+        queue->tasks.erase(std::next(it).base());
+
+        std::lock_guard< std::mutex > pending(this->m_mutex);
+        --this->m_pending;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(Task const& task) noexcept (true) {
+    Batch& batch = *task.batch;
+    try {
+        in_task = true;
+        batch.fn(task.index);
+        in_task = false;
+    } catch (...) {
+        in_task = false;
+        std::lock_guard< std::mutex > guard(batch.mutex);
+        if (not batch.error) batch.error = std::current_exception();
+    }
+
+    /*
+     * Notify while holding the lock, as the batch lives on the stack of the
+     * waiting thread and is gone as soon as it wakes up
+     */
+    std::lock_guard< std::mutex > guard(batch.mutex);
+    if (--batch.remaining == 0) {
+        batch.done.notify_all();
+    }
+}
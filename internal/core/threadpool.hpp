@@ -0,0 +1,100 @@
+#ifndef ONESEISMIC_API_THREADPOOL_HPP
+#define ONESEISMIC_API_THREADPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Process-wide work-stealing thread pool.
+ *
+ * All requests share the same, fixed number of threads, so that concurrent
+ * requests split the cores between them rather than each starting threads
+ * of their own. Every worker has its own queue of tasks. Workers take tasks
+ * from the front of their own queue and, when it is empty, steal from the
+ * back of the other workers' queues.
+ *
+ * The tasks of a call to parallel_for() are spread over all queues, so tasks
+ * of concurrent calls are interleaved and all calls make progress. The
+ * calling thread takes part in running its own tasks while it waits.
+ *
+ * By default the pool has one thread per hardware thread.
+ */
+class ThreadPool {
+public:
+    static ThreadPool& instance() noexcept (true);
+
+    /**
+     * Configure the pool.
+     *
+     * Waits for queued tasks to finish before the threads are replaced.
+     *
+     * @param nthreads Number of worker threads. Zero means one per hardware
+     * thread.
+     */
+    void configure(std::size_t nthreads) noexcept (false);
+
+    /** Number of worker threads */
+    std::size_t size() const noexcept (true);
+
+    /**
+     * Call fn(i) for every i in [0, ntasks), and return when all calls are
+     * done. If any call throws, the first exception is rethrown once all
+     * calls are done. Calls made from within a task run on the calling
+     * thread.
+     */
+    void parallel_for(
+        std::size_t ntasks,
+        std::function< void(std::size_t) > const& fn
+    ) noexcept (false);
+
+    ~ThreadPool();
+
+private:
+    ThreadPool();
+
+    struct Batch;
+
+    struct Task {
+        Batch*      batch;
+        std::size_t index;
+    };
+
+    struct Queue {
+        std::mutex        mutex;
+        std::deque< Task > tasks;
+    };
+
+    void start(std::size_t nthreads);
+    void stop();
+    void work(std::size_t worker) noexcept (true);
+
+    /* Take a task, preferably from the front of queue */
+    bool take(std::size_t queue, Task& task) noexcept (true);
+    /* Take a task of batch, from the back of any queue */
+    bool take(Batch const* batch, Task& task) noexcept (true);
+
+    static void run(Task const& task) noexcept (true);
+
+    /*
+     * Held shared while tasks are queued and run, and exclusively while the
+     * workers are replaced
+     */
+    mutable std::shared_mutex m_workers_mutex;
+    std::vector< std::unique_ptr< Queue > > m_queues;
+    std::vector< std::thread > m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::size_t m_pending = 0;
+    std::size_t m_next_queue = 0;
+    bool m_stop = false;
+};
+
+#endif /* ONESEISMIC_API_THREADPOOL_HPP */
@@ -62,6 +62,44 @@ func NewMetrics() *Metrics {
 	return metrics;
 }
 
+/** Export the hit, miss and waste counters of the slice prefetcher
+ *
+ * The counters are owned by the core library, so they are read when the
+ * metrics are collected rather than updated by the request handlers.
+ */
+func (metrics *Metrics) RegisterPrefetchStatistics(
+	statistics func() (uint64, uint64, uint64, error),
+) {
+	counter := func(name string, help string, pick func(hits, misses, waste uint64) uint64) prometheus.CounterFunc {
+		return prometheus.NewCounterFunc(prometheus.CounterOpts{
+			Name: name,
+			Help: help,
+		}, func() float64 {
+			hits, misses, waste, err := statistics()
+			if err != nil {
+				return 0
+			}
+			return float64(pick(hits, misses, waste))
+		})
+	}
+
+	metrics.registry.MustRegister(counter(
+		"oneseismic_api_prefetch_hits_count",
+		"oneseismic-api number of slices served by a prefetched slice.",
+		func(hits, misses, waste uint64) uint64 { return hits },
+	))
+	metrics.registry.MustRegister(counter(
+		"oneseismic_api_prefetch_misses_count",
+		"oneseismic-api number of slices not served by a prefetched slice.",
+		func(hits, misses, waste uint64) uint64 { return misses },
+	))
+	metrics.registry.MustRegister(counter(
+		"oneseismic_api_prefetch_waste_count",
+		"oneseismic-api number of prefetched slices that were never used.",
+		func(hits, misses, waste uint64) uint64 { return waste },
+	))
+}
+
 /** New gin middleware for writing prometheus metrics */
 func NewGinMiddleware(metrics *Metrics) gin.HandlerFunc {
 	return func(ctx *gin.Context) {
@@ -0,0 +1,209 @@
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "attribute.hpp"
+#include "cppapi.hpp"
+#include "ctypes.h"
+#include "datahandle.hpp"
+#include "regularsurface.hpp"
+#include "subvolume.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+const std::string REGULAR_DATA = "file://regular_8x2_cube.vds";
+const std::string CREDENTIALS = "";
+
+/* Grid aligned with the inlines and crosslines of the VDS */
+Grid make_grid(MetadataHandle const& metadata) {
+    auto cdp = metadata.bounding_box().world();
+
+    auto nsteps_iline = metadata.iline().nsamples() - 1;
+    auto nsteps_xline = metadata.xline().nsamples() - 1;
+
+    auto iline_distance_x = cdp[1].first  - cdp[0].first;
+    auto iline_distance_y = cdp[1].second - cdp[0].second;
+    auto xline_distance_x = cdp[3].first  - cdp[0].first;
+    auto xline_distance_y = cdp[3].second - cdp[0].second;
+
+    return Grid(
+        cdp[0].first,
+        cdp[0].second,
+        std::hypot(iline_distance_x, iline_distance_y) / nsteps_iline,
+        std::hypot(xline_distance_x, xline_distance_y) / nsteps_xline,
+        std::atan2(iline_distance_y, iline_distance_x) * 180 / M_PI
+    );
+}
+
+/* All attributes, the n first of which are requested by a benchmark */
+std::vector< Attribute > const all_attributes{
+    Value(), Min(), MinAt(), Max(), MaxAt(), MaxAbs(), MaxAbsAt(), Mean(),
+    MeanAbs(), MeanPos(), MeanNeg(), Median(), Rms(), Var(), Sd(), SumPos(),
+    SumNeg(),
+};
+
+/*
+ * The virtual attribute maps the attributes were computed with before they
+ * were dispatched at compile time, kept as a baseline. Every map is its own
+ * heap object and every value is bounds checked and copied on write.
+ */
+class VirtualAttributeMap {
+public:
+    VirtualAttributeMap(void* dst, std::size_t size) : dst(dst), size(size) {}
+
+    virtual float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) = 0;
+
+    virtual unsigned statistics() const = 0;
+
+    void write(float value, std::size_t index) {
+        std::size_t offset = index * sizeof(float);
+        if (offset >= this->size) {
+            throw std::out_of_range("Attempting write outside attribute buffer");
+        }
+        std::memcpy((char*)this->dst + offset, &value, sizeof(float));
+    }
+
+    virtual ~VirtualAttributeMap() = default;
+
+private:
+    void*       dst;
+    std::size_t size;
+};
+
+template< typename T >
+class VirtualAttribute final : public VirtualAttributeMap {
+public:
+    using VirtualAttributeMap::VirtualAttributeMap;
+
+    float compute(
+        ResampledSegment const & segment,
+        SegmentStatistics const & statistics
+    ) override {
+        return T::compute(segment, statistics);
+    }
+
+    unsigned statistics() const override { return T::groups; }
+};
+
+std::unique_ptr< VirtualAttributeMap > make_virtual(
+    Attribute const& attribute,
+    void* dst,
+    std::size_t size
+) {
+    return std::visit([&](auto const& kernel) -> std::unique_ptr< VirtualAttributeMap > {
+        using T = std::decay_t< decltype(kernel) >;
+        return std::make_unique< VirtualAttribute< T > >(dst, size);
+    }, attribute);
+}
+
+void baseline_calc_attributes(
+    SurfaceBoundedSubVolume const& src_subvolume,
+    ResampledSegmentBlueprint const* dst_segment_blueprint,
+    std::vector< std::unique_ptr< VirtualAttributeMap > >& attrs,
+    std::size_t from,
+    std::size_t to
+) {
+    auto fill = src_subvolume.fillvalue();
+
+    RawSegment src_segment = src_subvolume.vertical_segment(from);
+    ResampledSegment dst_segment = ResampledSegment(0, 0, 0, dst_segment_blueprint);
+    ResampleScratch scratch;
+    SegmentStatistics statistics;
+
+    unsigned groups = SegmentStatistics::NONE;
+    for (auto const& attr : attrs) groups |= attr->statistics();
+
+    for (std::size_t i = from; i < to; ++i) {
+        if (src_subvolume.is_empty(i)) {
+            for (auto& attr : attrs) attr->write(fill, i);
+            continue;
+        }
+
+        src_subvolume.reinitialize(i, src_segment);
+        src_subvolume.reinitialize(i, dst_segment);
+        resample(src_segment, dst_segment, scratch);
+        statistics.gather(dst_segment, groups);
+
+        for (auto& attr : attrs) {
+            attr->write(attr->compute(dst_segment, statistics), i);
+        }
+    }
+}
+
+/*
+ * Attributes of a window over the whole VDS, resampled at a quarter of the
+ * sample stepsize, with the n first attributes requested
+ */
+void BM_attributes(benchmark::State& state, bool virtual_dispatch) {
+    SingleDataHandle datahandle = make_single_datahandle(
+        REGULAR_DATA.c_str(),
+        CREDENTIALS.c_str()
+    );
+    MetadataHandle const& metadata = datahandle.get_metadata();
+    Axis const& sample = metadata.sample();
+
+    std::size_t const nrows = metadata.iline().nsamples();
+    std::size_t const ncols = metadata.xline().nsamples();
+    std::size_t const hsize = nrows * ncols;
+    float const fill = -999.25;
+
+    float const middle = (sample.min() + sample.max()) / 2;
+    float const half_window = 8 * sample.stepsize();
+
+    std::vector< float > reference(hsize, middle);
+    std::vector< float > top(hsize, middle - half_window);
+    std::vector< float > bottom(hsize, middle + half_window);
+
+    Grid const grid = make_grid(metadata);
+    RegularSurface reference_surface(reference.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface(top.data(), nrows, ncols, grid, fill);
+    RegularSurface bottom_surface(bottom.data(), nrows, ncols, grid, fill);
+
+    std::unique_ptr< SurfaceBoundedSubVolume > subvolume(make_subvolume(
+        metadata,
+        reference_surface,
+        top_surface,
+        bottom_surface
+    ));
+    cppapi::fetch_subvolume(datahandle, *subvolume, NEAREST, 0, hsize);
+
+    ResampledSegmentBlueprint blueprint(sample.stepsize() / 4);
+
+    std::size_t const nattributes = state.range(0);
+    std::vector< float > out(hsize * nattributes);
+    std::size_t const size = hsize * sizeof(float);
+
+    for (auto _ : state) {
+        if (virtual_dispatch) {
+            std::vector< std::unique_ptr< VirtualAttributeMap > > attrs;
+            for (std::size_t i = 0; i < nattributes; ++i) {
+                attrs.push_back(make_virtual(all_attributes[i], out.data() + i * hsize, size));
+            }
+            baseline_calc_attributes(*subvolume, &blueprint, attrs, 0, hsize);
+        } else {
+            std::vector< AttributeMap > attrs;
+            for (std::size_t i = 0; i < nattributes; ++i) {
+                attrs.emplace_back(all_attributes[i], out.data() + i * hsize, size);
+            }
+            calc_attributes(*subvolume, &blueprint, attrs, 0, hsize);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * hsize);
+    datahandle.close();
+}
+
+#define NATTRIBUTES Arg(1)->Arg(4)->Arg(17)
+
+BENCHMARK_CAPTURE(BM_attributes, virtual, true)->NATTRIBUTES;
+BENCHMARK_CAPTURE(BM_attributes, variant, false)->NATTRIBUTES;
+
+} // namespace
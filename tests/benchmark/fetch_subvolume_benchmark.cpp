@@ -0,0 +1,97 @@
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cppapi.hpp"
+#include "ctypes.h"
+#include "datahandle.hpp"
+#include "regularsurface.hpp"
+#include "subvolume.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+const std::string REGULAR_DATA = "file://regular_8x2_cube.vds";
+const std::string CREDENTIALS = "";
+
+/* Grid aligned with the inlines and crosslines of the VDS */
+Grid make_grid(MetadataHandle const& metadata) {
+    auto cdp = metadata.bounding_box().world();
+
+    auto nsteps_iline = metadata.iline().nsamples() - 1;
+    auto nsteps_xline = metadata.xline().nsamples() - 1;
+
+    auto iline_distance_x = cdp[1].first  - cdp[0].first;
+    auto iline_distance_y = cdp[1].second - cdp[0].second;
+    auto xline_distance_x = cdp[3].first  - cdp[0].first;
+    auto xline_distance_y = cdp[3].second - cdp[0].second;
+
+    return Grid(
+        cdp[0].first,
+        cdp[0].second,
+        std::hypot(iline_distance_x, iline_distance_y) / nsteps_iline,
+        std::hypot(xline_distance_x, xline_distance_y) / nsteps_xline,
+        std::atan2(iline_distance_y, iline_distance_x) * 180 / M_PI
+    );
+}
+
+/*
+ * Fetch a flat horizon over the whole VDS. The window is given as a number of
+ * samples around the middle of the trace, from a couple of samples to the
+ * whole trace.
+ */
+void BM_fetch_subvolume(benchmark::State& state, cppapi::SubvolumeFetch strategy) {
+    SingleDataHandle datahandle = make_single_datahandle(
+        REGULAR_DATA.c_str(),
+        CREDENTIALS.c_str()
+    );
+    MetadataHandle const& metadata = datahandle.get_metadata();
+    Axis const& sample = metadata.sample();
+
+    std::size_t const nrows = metadata.iline().nsamples();
+    std::size_t const ncols = metadata.xline().nsamples();
+    float const fill = -999.25;
+
+    float const middle = (sample.min() + sample.max()) / 2;
+    float const half_window = state.range(0) * sample.stepsize() / 2;
+
+    std::vector< float > reference(nrows * ncols, middle);
+    std::vector< float > top(nrows * ncols, middle - half_window);
+    std::vector< float > bottom(nrows * ncols, middle + half_window);
+
+    Grid const grid = make_grid(metadata);
+    RegularSurface reference_surface(reference.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface(top.data(), nrows, ncols, grid, fill);
+    RegularSurface bottom_surface(bottom.data(), nrows, ncols, grid, fill);
+
+    std::unique_ptr< SurfaceBoundedSubVolume > subvolume(make_subvolume(
+        metadata,
+        reference_surface,
+        top_surface,
+        bottom_surface
+    ));
+
+    for (auto _ : state) {
+        cppapi::fetch_subvolume(
+            datahandle,
+            *subvolume,
+            NEAREST,
+            0,
+            nrows * ncols,
+            strategy
+        );
+        benchmark::DoNotOptimize(subvolume->data(0));
+    }
+    state.SetItemsProcessed(state.iterations() * subvolume->nsamples(0, nrows * ncols));
+    datahandle.close();
+}
+
+#define WINDOWS Arg(2)->Arg(8)->Arg(16)->Arg(24)
+
+BENCHMARK_CAPTURE(BM_fetch_subvolume, samples, cppapi::SubvolumeFetch::SAMPLES)->WINDOWS;
+BENCHMARK_CAPTURE(BM_fetch_subvolume, traces,  cppapi::SubvolumeFetch::TRACES)->WINDOWS;
+BENCHMARK_CAPTURE(BM_fetch_subvolume, automatic, cppapi::SubvolumeFetch::AUTOMATIC)->WINDOWS;
+
+} // namespace
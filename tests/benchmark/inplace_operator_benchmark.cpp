@@ -0,0 +1,80 @@
+#include <vector>
+
+#include "ctypes.h"
+#include "inplace_operator.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+/*
+ * The loop the inplace operators were implemented with before they were
+ * vectorized by hand, kept as a baseline. Note that the compiler is free to
+ * auto-vectorize it for the build target (sse2 on x86-64).
+ */
+void baseline_subtraction(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept {
+    for (std::size_t i = 0; i < nsamples; i++) {
+        buffer_A[i] -= buffer_B[i];
+    }
+}
+
+void baseline_division(
+    float* buffer_A,
+    const float* buffer_B,
+    std::size_t nsamples
+) noexcept {
+    for (std::size_t i = 0; i < nsamples; i++) {
+        buffer_A[i] /= buffer_B[i];
+    }
+}
+
+void run(benchmark::State& state, inplace_operator op) {
+    std::size_t const nsamples = state.range(0);
+    std::vector< float > a(nsamples, 3.0f);
+    std::vector< float > b(nsamples, 1.0f);
+
+    for (auto _ : state) {
+        op(a.data(), b.data(), nsamples);
+        benchmark::DoNotOptimize(a.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * nsamples * 3 * sizeof(float));
+}
+
+void BM_baseline(benchmark::State& state, binary_operator symbol) {
+    run(state, symbol == DIVISION ? &baseline_division : &baseline_subtraction);
+}
+
+void BM_kernel(benchmark::State& state, binary_operator symbol, instruction_set isa) {
+    if (isa > supported_instruction_set()) {
+        state.SkipWithError("instruction set not supported by cpu");
+        return;
+    }
+    inplace_operator op = inplace_kernel(symbol, isa);
+    if (not op) {
+        state.SkipWithError("instruction set not compiled in");
+        return;
+    }
+    run(state, op);
+}
+
+/* From a cache-resident trace up to a full-cube time slice of a large survey */
+#define SIZES RangeMultiplier(16)->Range(1 << 10, 1 << 24)
+
+BENCHMARK_CAPTURE(BM_baseline, subtraction, SUBTRACTION)->SIZES;
+BENCHMARK_CAPTURE(BM_kernel, subtraction_scalar, SUBTRACTION, instruction_set::SCALAR)->SIZES;
+BENCHMARK_CAPTURE(BM_kernel, subtraction_sse2,   SUBTRACTION, instruction_set::SSE2)->SIZES;
+BENCHMARK_CAPTURE(BM_kernel, subtraction_avx2,   SUBTRACTION, instruction_set::AVX2)->SIZES;
+BENCHMARK_CAPTURE(BM_kernel, subtraction_avx512, SUBTRACTION, instruction_set::AVX512)->SIZES;
+
+BENCHMARK_CAPTURE(BM_baseline, division, DIVISION)->SIZES;
+BENCHMARK_CAPTURE(BM_kernel, division_scalar, DIVISION, instruction_set::SCALAR)->SIZES;
+BENCHMARK_CAPTURE(BM_kernel, division_sse2,   DIVISION, instruction_set::SSE2)->SIZES;
+BENCHMARK_CAPTURE(BM_kernel, division_avx2,   DIVISION, instruction_set::AVX2)->SIZES;
+BENCHMARK_CAPTURE(BM_kernel, division_avx512, DIVISION, instruction_set::AVX512)->SIZES;
+
+} // namespace
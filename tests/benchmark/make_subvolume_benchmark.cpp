@@ -0,0 +1,95 @@
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "datahandle.hpp"
+#include "regularsurface.hpp"
+#include "subvolume.hpp"
+#include "threadpool.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+const std::string REGULAR_DATA = "file://regular_8x2_cube.vds";
+const std::string CREDENTIALS = "";
+
+/*
+ * Grid aligned with the inlines and crosslines of the VDS, with density
+ * points per line spacing in both directions
+ */
+Grid make_grid(MetadataHandle const& metadata, int density) {
+    auto cdp = metadata.bounding_box().world();
+
+    auto nsteps_iline = metadata.iline().nsamples() - 1;
+    auto nsteps_xline = metadata.xline().nsamples() - 1;
+
+    auto iline_distance_x = cdp[1].first  - cdp[0].first;
+    auto iline_distance_y = cdp[1].second - cdp[0].second;
+    auto xline_distance_x = cdp[3].first  - cdp[0].first;
+    auto xline_distance_y = cdp[3].second - cdp[0].second;
+
+    return Grid(
+        cdp[0].first,
+        cdp[0].second,
+        std::hypot(iline_distance_x, iline_distance_y) / nsteps_iline / density,
+        std::hypot(xline_distance_x, xline_distance_y) / nsteps_xline / density,
+        std::atan2(iline_distance_y, iline_distance_x) * 180 / M_PI
+    );
+}
+
+/*
+ * Plan a subvolume between flat surfaces over the whole VDS, without reading
+ * any data. The first argument is the density of the surface grid relative
+ * to the VDS, the second the number of threads in the pool (0 for one per
+ * hardware thread).
+ */
+void BM_make_subvolume(benchmark::State& state) {
+    SingleDataHandle datahandle = make_single_datahandle(
+        REGULAR_DATA.c_str(),
+        CREDENTIALS.c_str()
+    );
+    MetadataHandle const& metadata = datahandle.get_metadata();
+    Axis const& sample = metadata.sample();
+
+    int const density = state.range(0);
+    ThreadPool::instance().configure(state.range(1));
+
+    std::size_t const nrows = (metadata.iline().nsamples() - 1) * density + 1;
+    std::size_t const ncols = (metadata.xline().nsamples() - 1) * density + 1;
+    float const fill = -999.25;
+
+    float const middle = (sample.min() + sample.max()) / 2;
+    float const half_window = 4 * sample.stepsize();
+
+    std::vector< float > reference(nrows * ncols, middle);
+    std::vector< float > top(nrows * ncols, middle - half_window);
+    std::vector< float > bottom(nrows * ncols, middle + half_window);
+
+    Grid const grid = make_grid(metadata, density);
+    RegularSurface reference_surface(reference.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface(top.data(), nrows, ncols, grid, fill);
+    RegularSurface bottom_surface(bottom.data(), nrows, ncols, grid, fill);
+
+    for (auto _ : state) {
+        std::unique_ptr< SurfaceBoundedSubVolume > subvolume(make_subvolume(
+            metadata,
+            reference_surface,
+            top_surface,
+            bottom_surface
+        ));
+        benchmark::DoNotOptimize(subvolume->nsamples(0, nrows * ncols));
+    }
+    state.SetItemsProcessed(state.iterations() * nrows * ncols);
+
+    ThreadPool::instance().configure(0);
+    datahandle.close();
+}
+
+BENCHMARK(BM_make_subvolume)
+    ->ArgNames({ "density", "threads" })
+    ->ArgsProduct({ { 16, 128, 512 }, { 1, 0 } })
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "attribute.hpp"
+#include "subvolume.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+class AttributeTest : public ::testing::Test {
+protected:
+    AttributeTest()
+        : blueprint(4),
+          /* Samples at 8, 12, ..., 36 with the reference at 20 */
+          segment(20, 8, 36, &blueprint)
+    {}
+
+    void fill(std::vector< double > const& values) {
+        ASSERT_EQ(values.size(), segment.size());
+        std::copy(values.begin(), values.end(), segment.begin());
+    }
+
+    template< typename T >
+    float compute(unsigned groups) {
+        EXPECT_EQ(T::groups & ~groups, 0);
+
+        SegmentStatistics statistics;
+        statistics.gather(segment, groups);
+        return T::compute(segment, statistics);
+    }
+
+    template< typename T >
+    float compute() {
+        return compute< T >(T::groups);
+    }
+
+    ResampledSegmentBlueprint blueprint;
+    ResampledSegment segment;
+};
+
+TEST_F(AttributeTest, SinglePassMatchesSeparatePasses) {
+    std::vector< double > const values{ 1.5, -3.25, 7, 0, -3.25, 7, -7, 2.5 };
+    fill(values);
+
+    double const n = values.size();
+    double const sum = std::accumulate(values.begin(), values.end(), 0.0);
+    double const mean = sum / n;
+    double sumsq = 0, sqdev = 0, sumabs = 0, sumpos = 0, sumneg = 0;
+    int npos = 0, nneg = 0;
+    for (double x : values) {
+        sumsq  += x * x;
+        sqdev  += (x - mean) * (x - mean);
+        sumabs += std::abs(x);
+        if (x > 0) { sumpos += x; ++npos; }
+        if (x < 0) { sumneg += x; ++nneg; }
+    }
+
+    EXPECT_FLOAT_EQ(compute< Value >(),    0);
+    EXPECT_FLOAT_EQ(compute< Min >(),      -7);
+    EXPECT_FLOAT_EQ(compute< MinAt >(),    32);
+    EXPECT_FLOAT_EQ(compute< Max >(),      7);
+    /* First occurrence */
+    EXPECT_FLOAT_EQ(compute< MaxAt >(),    16);
+    EXPECT_FLOAT_EQ(compute< MaxAbs >(),   7);
+    EXPECT_FLOAT_EQ(compute< MaxAbsAt >(), 16);
+    EXPECT_FLOAT_EQ(compute< Mean >(),     mean);
+    EXPECT_FLOAT_EQ(compute< MeanAbs >(),  sumabs / n);
+    EXPECT_FLOAT_EQ(compute< MeanPos >(),  sumpos / npos);
+    EXPECT_FLOAT_EQ(compute< MeanNeg >(),  sumneg / nneg);
+    EXPECT_FLOAT_EQ(compute< Median >(),   (0 + 1.5) / 2);
+    EXPECT_FLOAT_EQ(compute< Rms >(),      std::sqrt(sumsq / n));
+    EXPECT_FLOAT_EQ(compute< Var >(),      sqdev / n);
+    EXPECT_FLOAT_EQ(compute< Sd >(),       std::sqrt(sqdev / n));
+    EXPECT_FLOAT_EQ(compute< SumPos >(),   sumpos);
+    EXPECT_FLOAT_EQ(compute< SumNeg >(),   sumneg);
+}
+
+TEST_F(AttributeTest, AllGroupsGatheredTogether) {
+    fill({ 2, -1, 4, 4, -6, 0.5, 3, -2 });
+
+    unsigned const all =
+        SegmentStatistics::MOMENTS |
+        SegmentStatistics::SIGNED  |
+        SegmentStatistics::EXTREMA;
+
+    EXPECT_FLOAT_EQ(compute< Min >(all),    compute< Min >());
+    EXPECT_FLOAT_EQ(compute< MaxAt >(all),  compute< MaxAt >());
+    EXPECT_FLOAT_EQ(compute< Sd >(all),     compute< Sd >());
+    EXPECT_FLOAT_EQ(compute< MeanNeg >(all), compute< MeanNeg >());
+}
+
+TEST_F(AttributeTest, ConstantSegmentHasNoVariance) {
+    fill(std::vector< double >(8, 1e8 + 0.1));
+
+    EXPECT_EQ(compute< Var >(), 0);
+    EXPECT_EQ(compute< Sd >(),  0);
+}
+
+TEST_F(AttributeTest, NoPositiveOrNegativeValues) {
+    fill(std::vector< double >(8, 0));
+
+    EXPECT_EQ(compute< MeanPos >(), 0);
+    EXPECT_EQ(compute< MeanNeg >(), 0);
+    EXPECT_EQ(compute< SumPos >(),  0);
+    EXPECT_EQ(compute< SumNeg >(),  0);
+}
+
+TEST_F(AttributeTest, MedianOfAnySize) {
+    /* Both sides of the insertion sort cut-off, odd and even sizes */
+    for (int n = 1; n <= 40; ++n) {
+        ResampledSegment segment(8, 8, 8 + 4 * (n - 1), &blueprint);
+        ASSERT_EQ(segment.size(), n);
+
+        std::vector< double > values;
+        for (int i = 0; i < n; ++i) values.push_back((i * 7919) % 23 - 11.5);
+        std::copy(values.begin(), values.end(), segment.begin());
+
+        std::sort(values.begin(), values.end());
+        double const expected = n % 2
+            ? values[n / 2]
+            : (values[n / 2 - 1] + values[n / 2]) / 2;
+
+        SegmentStatistics statistics;
+        EXPECT_EQ(Median::compute(segment, statistics), float(expected)) << "n = " << n;
+    }
+}
+
+TEST_F(AttributeTest, MedianOfRepeatedAndOrderedValues) {
+    /* Sorted, reversed and heavily repeated values, past the insertion sort cut-off */
+    for (int n : { 9, 10, 31, 64, 257 }) {
+        ResampledSegment segment(8, 8, 8 + 4 * (n - 1), &blueprint);
+        ASSERT_EQ(segment.size(), n);
+
+        for (int pattern = 0; pattern < 4; ++pattern) {
+            std::vector< double > values;
+            for (int i = 0; i < n; ++i) {
+                switch (pattern) {
+                    case 0: values.push_back(i); break;
+                    case 1: values.push_back(n - i); break;
+                    case 2: values.push_back(i % 3); break;
+                    case 3: values.push_back((i * 7919) % 13 - (i % 2) * 0.5); break;
+                }
+            }
+            std::copy(values.begin(), values.end(), segment.begin());
+
+            std::sort(values.begin(), values.end());
+            double const expected = n % 2
+                ? values[n / 2]
+                : (values[n / 2 - 1] + values[n / 2]) / 2;
+
+            SegmentStatistics statistics;
+            EXPECT_EQ(Median::compute(segment, statistics), float(expected))
+                << "n = " << n << ", pattern = " << pattern;
+        }
+    }
+}
+
+TEST_F(AttributeTest, MapsCollectStatisticsGroups) {
+    float value;
+    AttributeMap mean(Mean(), &value, sizeof(value));
+    AttributeMap min(Min(), &value, sizeof(value));
+    AttributeMap median(Median(), &value, sizeof(value));
+
+    EXPECT_EQ(mean.statistics(),   SegmentStatistics::MOMENTS);
+    EXPECT_EQ(min.statistics(),    SegmentStatistics::EXTREMA);
+    EXPECT_EQ(median.statistics(), SegmentStatistics::NONE);
+}
+
+} // namespace
@@ -0,0 +1,137 @@
+#include <memory>
+#include <vector>
+
+#include "brickcache.hpp"
+#include "cppapi.hpp"
+#include "ctypes.h"
+#include "test_utils.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+class BrickCacheTest : public DatahandleRegularCubeTest {
+protected:
+    void SetUp() override {
+        cache.configure(64 * 1024 * 1024);
+    }
+
+    void TearDown() override {
+        cache.configure(0);
+        DatahandleRegularCubeTest::TearDown();
+    }
+
+    static BrickCache::Brick make_brick(std::size_t nsamples) {
+        return std::make_shared< std::vector< float > >(nsamples, 1.0f);
+    }
+
+    BrickCache& cache = BrickCache::instance();
+};
+
+TEST_F(BrickCacheTest, FindInsertedBrick) {
+    BrickCache::Key const key{ "vds", 0, { 1, 2, 3 } };
+    EXPECT_EQ(cache.find(key), nullptr);
+
+    auto brick = make_brick(8);
+    cache.insert(key, brick);
+    EXPECT_EQ(cache.find(key), brick);
+
+    BrickCache::Key const other_lod{ "vds", 1, { 1, 2, 3 } };
+    BrickCache::Key const other_vds{ "other", 0, { 1, 2, 3 } };
+    EXPECT_EQ(cache.find(other_lod), nullptr);
+    EXPECT_EQ(cache.find(other_vds), nullptr);
+}
+
+TEST_F(BrickCacheTest, CacheIsBounded) {
+    std::size_t const max_bytes = 64 * 1024;
+    cache.configure(max_bytes);
+
+    for (int i = 0; i < 1024; ++i) {
+        cache.insert(BrickCache::Key{ "vds", 0, { i, 0, 0 } }, make_brick(256));
+    }
+    EXPECT_GT(cache.size(), 0);
+    EXPECT_LE(cache.size(), max_bytes);
+}
+
+TEST_F(BrickCacheTest, DisabledCacheKeepsNothing) {
+    cache.configure(0);
+    EXPECT_FALSE(cache.enabled());
+
+    BrickCache::Key const key{ "vds", 0, { 0, 0, 0 } };
+    cache.insert(key, make_brick(8));
+    EXPECT_EQ(cache.find(key), nullptr);
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(BrickCacheTest, BricksMustFitInAShard) {
+    std::size_t const brick_bytes = 1024 * 1024;
+    cache.configure(16 * brick_bytes);
+    EXPECT_TRUE(cache.fits(brick_bytes));
+    EXPECT_FALSE(cache.fits(brick_bytes + 1));
+
+    cache.configure(0);
+    EXPECT_FALSE(cache.fits(1));
+}
+
+TEST_F(BrickCacheTest, CacheTooSmallForBricksIsBypassed) {
+    std::size_t const brick_size = datahandle.get_metadata().brick_size();
+    std::size_t const brick_bytes = brick_size * brick_size * brick_size * sizeof(float);
+
+    cache.configure(0);
+    auto const expected = slice(Direction(axis_name::I), 3);
+
+    cache.configure(brick_bytes);
+    EXPECT_TRUE(cache.enabled());
+    EXPECT_EQ(slice(Direction(axis_name::I), 3), expected);
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(BrickCacheTest, ClearDropsAllBricks) {
+    cache.insert(BrickCache::Key{ "vds", 0, { 0, 0, 0 } }, make_brick(8));
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(BrickCacheTest, CachedSlicesMatchVds) {
+    std::vector< Direction > const directions{
+        Direction(axis_name::I),
+        Direction(axis_name::J),
+        Direction(axis_name::K),
+    };
+    for (auto const& direction : directions) {
+        cache.configure(0);
+        auto const expected = slice(direction, 3);
+
+        cache.configure(64 * 1024 * 1024);
+        EXPECT_EQ(slice(direction, 3), expected);
+        EXPECT_GT(cache.size(), 0);
+
+        /* Served from the cache */
+        EXPECT_EQ(slice(direction, 3), expected);
+    }
+}
+
+TEST_F(BrickCacheTest, CachedFenceMatchesVds) {
+    std::vector< float > const coordinates{
+        0, 0, 0.4, 0.6, 1, 1, 2.5, 3.49, 7, 7, 7.4, 0, 0, 7.4
+    };
+
+    cache.configure(0);
+    auto const nearest = fence(coordinates, NEAREST);
+    auto const linear  = fence(coordinates, LINEAR);
+
+    cache.configure(64 * 1024 * 1024);
+    EXPECT_EQ(fence(coordinates, NEAREST), nearest);
+    EXPECT_EQ(fence(coordinates, LINEAR),  linear);
+}
+
+TEST_F(BrickCacheTest, SliceAndFenceShareBricks) {
+    slice(Direction(axis_name::I), 0);
+    std::size_t const size = cache.size();
+
+    fence({ 0, 0, 0, 1, 0, 2 }, NEAREST);
+    EXPECT_EQ(cache.size(), size);
+}
+
+} // namespace
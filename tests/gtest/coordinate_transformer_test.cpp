@@ -7,6 +7,8 @@
 
 #include <OpenVDS/OpenVDS.h>
 
+#include <vector>
+
 namespace {
 
 const std::string CREDENTIALS = "";
@@ -132,4 +134,71 @@ TEST(NegativeCoordinateTransformerTest, NegativeAnnotation) {
     EXPECT_EQ(as_annotation.Y, transformer.WorldToAnnotation(as_cdp).Y);
 }
 
+TEST(BatchCoordinateTransformerTest, MatchesPerPointTransform) {
+    const std::string url = "file://10_negative.vds";
+
+    auto datahandle = make_single_datahandle(
+        url.c_str(),
+        CREDENTIALS.c_str()
+    );
+    MetadataHandle const& metadata = datahandle.get_metadata();
+    CoordinateTransformer const& transformer = metadata.coordinate_transformer();
+
+    std::vector< double > xs{ 8, 2, 14.5, -3, 100.25 };
+    std::vector< double > ys{ 4, 1,  7.5, 20, -33.75 };
+    std::vector< double > ilines = xs;
+    std::vector< double > xlines = ys;
+
+    transformer.WorldToAnnotationTransformation()
+        .transform(ilines.data(), xlines.data(), xs.size());
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        auto const expected = transformer.WorldToAnnotation({ xs[i], ys[i], 0 });
+        EXPECT_NEAR(ilines[i], expected[0], 1e-9);
+        EXPECT_NEAR(xlines[i], expected[1], 1e-9);
+    }
+
+    ilines = xs;
+    xlines = ys;
+    transformer.IJKPositionToAnnotationTransformation()
+        .transform(ilines.data(), xlines.data(), xs.size());
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        auto const expected = transformer.IJKPositionToAnnotation({ xs[i], ys[i], 0 });
+        EXPECT_NEAR(ilines[i], expected[0], 1e-9);
+        EXPECT_NEAR(xlines[i], expected[1], 1e-9);
+    }
+
+    Axis iline = metadata.iline();
+    std::vector< double > const annotations{ 1, 2, 3, 4, 5.5 };
+    std::vector< double > positions = annotations;
+    iline.to_sample_positions(positions.data(), positions.size());
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        EXPECT_EQ(positions[i], iline.to_sample_position(annotations[i]));
+    }
+}
+
+TEST(BatchCoordinateTransformerTest, SamplePositionsMatchPerPoint) {
+    const std::string url = "file://regular_8x2_cube.vds";
+
+    auto datahandle = make_single_datahandle(
+        url.c_str(),
+        CREDENTIALS.c_str()
+    );
+    MetadataHandle const& metadata = datahandle.get_metadata();
+
+    for (Axis axis : { metadata.iline(), metadata.xline() }) {
+        /* Every grid cell, and the half-way points between them */
+        std::vector< double > annotations;
+        for (int i = -1; i <= 2 * axis.nsamples(); ++i) {
+            annotations.push_back(axis.min() + 0.5 * i * axis.stepsize());
+        }
+
+        std::vector< double > positions = annotations;
+        axis.to_sample_positions(positions.data(), positions.size());
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            EXPECT_EQ(positions[i], axis.to_sample_position(annotations[i]))
+                << "axis " << axis.name() << ", annotation " << annotations[i];
+        }
+    }
+}
+
 } // namespace
@@ -156,6 +156,72 @@ TEST_F(SubvolumeTest, SubvolumeSize)
     delete subvolume;
 }
 
+TEST_F(SubvolumeTest, PartitionIsBalancedOnSamples)
+{
+    static constexpr int nrows = 3;
+    static constexpr int ncols = 2;
+    static constexpr std::size_t size = nrows * ncols;
+
+    std::array<float, size> primary_surface_data = {
+        20, 20,
+        20, 20,
+        20, 19,
+    };
+
+    std::array<float, size> top_surface_data = {
+        20, 17,
+        16, 17,
+        16, 16,
+    };
+
+    std::array<float, size> bottom_surface_data = {
+        20, 23,
+        23, 24,
+        24, 24,
+    };
+
+    RegularSurface primary_surface =
+        RegularSurface(primary_surface_data.data(), nrows, ncols, samples_10_grid, fill);
+
+    RegularSurface top_surface =
+        RegularSurface(top_surface_data.data(), nrows, ncols, samples_10_grid, fill);
+
+    RegularSurface bottom_surface =
+        RegularSurface(bottom_surface_data.data(), nrows, ncols, samples_10_grid, fill);
+
+    SurfaceBoundedSubVolume* subvolume = make_subvolume(
+        datahandle.get_metadata(), primary_surface, top_surface, bottom_surface
+    );
+
+    using Parts = std::vector< std::pair< std::size_t, std::size_t > >;
+    int const brick_size = datahandle.get_metadata().brick_size();
+
+    /* Segments hold 5, 5, 6, 6, 7 and 7 samples, all in the same brick */
+    EXPECT_EQ(
+        cppapi::partition_subvolume(*subvolume, 0, size, 1, brick_size),
+        Parts({ { 0, 6 } })
+    );
+    EXPECT_EQ(
+        cppapi::partition_subvolume(*subvolume, 0, size, 3, brick_size),
+        Parts({ { 0, 2 }, { 2, 4 }, { 4, 6 } })
+    );
+
+    for (std::size_t nparts = 1; nparts <= 2 * size; ++nparts) {
+        auto const parts =
+            cppapi::partition_subvolume(*subvolume, 1, size, nparts, brick_size);
+        ASSERT_FALSE(parts.empty());
+        EXPECT_LE(parts.size(), nparts);
+        EXPECT_EQ(parts.front().first, 1);
+        EXPECT_EQ(parts.back().second, size);
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            EXPECT_LT(parts[i].first, parts[i].second);
+            if (i > 0) EXPECT_EQ(parts[i - 1].second, parts[i].first);
+        }
+    }
+
+    delete subvolume;
+}
+
 TEST_F(SubvolumeTest, DataForUnalignedSurface)
 {
     const float above = 2;
@@ -815,6 +881,9 @@ TEST_F(FenceFunctionTest, RequestingFenceData) {
         coordinate_size,
         interpolation,
         &fill,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -837,6 +906,9 @@ TEST_F(FenceFunctionTest, RequestingFenceDataSubtract) {
         coordinate_size,
         interpolation,
         &fill,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -879,6 +951,7 @@ TEST_F(SliceFunctionTest, RequestingSliceData) {
         direction,
         lineno,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -900,6 +973,7 @@ TEST_F(SliceFunctionTest, RequestingSliceDataSubtraction) {
         direction,
         lineno,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -1,13 +1,17 @@
 #include "cppapi.hpp"
 #include "ctypes.h"
+#include <array>
 #include <iostream>
 #include <sstream>
+#include <tuple>
 
 #include "test_utils.hpp"
 
 #include "attribute.hpp"
+#include "capi.h"
 #include "metadatahandle.hpp"
 #include "subvolume.hpp"
+#include "threadpool.hpp"
 #include "utils.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -103,6 +107,238 @@ TEST_F(DatahandleCubeIntersectionTest, Attribute_Double) {
     delete subvolume;
 }
 
+/*
+ * Windows covering most of the trace are read as whole traces rather than
+ * sample by sample
+ */
+TEST_F(DatahandleCubeIntersectionTest, Attribute_Trace_Windows_Single) {
+
+    DataHandle& datahandle = single_datahandle;
+    Grid grid = get_grid(datahandle);
+    const MetadataHandle* metadata = &(datahandle.get_metadata());
+
+    std::size_t nrows = metadata->iline().nsamples();
+    std::size_t ncols = metadata->xline().nsamples();
+    static std::vector<float> top_surface_data(nrows * ncols, 28.0f);
+    static std::vector<float> pri_surface_data(nrows * ncols, 36.0f);
+    static std::vector<float> bot_surface_data(nrows * ncols, 100.0f);
+    RegularSurface pri_surface = RegularSurface(pri_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface = RegularSurface(top_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface bot_surface = RegularSurface(bot_surface_data.data(), nrows, ncols, grid, fill);
+    SurfaceBoundedSubVolume* subvolume = make_subvolume(datahandle.get_metadata(), pri_surface, top_surface, bot_surface);
+
+    cppapi::fetch_subvolume(single_datahandle, *subvolume, NEAREST, 0, nrows * ncols);
+
+    int low[3] = {3, 2, 28};
+    int high[3] = {24, 16, 100};
+    check_attribute(*subvolume, low, high, 1);
+
+    delete subvolume;
+}
+
+TEST_F(DatahandleCubeIntersectionTest, Attribute_Trace_Windows_Double) {
+
+    DoubleDataHandle& datahandle = double_datahandle;
+    Grid grid = get_grid(datahandle);
+    const MetadataHandle* metadata = &(datahandle.get_metadata());
+
+    std::size_t nrows = metadata->iline().nsamples();
+    std::size_t ncols = metadata->xline().nsamples();
+    static std::vector<float> top_surface_data(nrows * ncols, 28.0f);
+    static std::vector<float> pri_surface_data(nrows * ncols, 36.0f);
+    static std::vector<float> bot_surface_data(nrows * ncols, 100.0f);
+    RegularSurface pri_surface = RegularSurface(pri_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface = RegularSurface(top_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface bot_surface = RegularSurface(bot_surface_data.data(), nrows, ncols, grid, fill);
+    SurfaceBoundedSubVolume* subvolume = make_subvolume(datahandle.get_metadata(), pri_surface, top_surface, bot_surface);
+
+    cppapi::fetch_subvolume(datahandle, *subvolume, NEAREST, 0, nrows * ncols);
+
+    int low[3] = {15, 10, 28};
+    int high[3] = {24, 16, 100};
+    check_attribute(*subvolume, low, high, 2);
+
+    delete subvolume;
+}
+
+/*
+ * A tiled subvolume is fetched tile by tile, and each tile is dropped again
+ * once all of it has been used
+ */
+TEST_F(DatahandleCubeIntersectionTest, Attribute_Tiled_Double) {
+
+    DoubleDataHandle& datahandle = double_datahandle;
+    Grid grid = get_grid(datahandle);
+    const MetadataHandle* metadata = &(datahandle.get_metadata());
+
+    std::size_t nrows = metadata->iline().nsamples();
+    std::size_t ncols = metadata->xline().nsamples();
+    static std::vector<float> top_surface_data(nrows * ncols, 28.0f);
+    static std::vector<float> pri_surface_data(nrows * ncols, 36.0f);
+    static std::vector<float> bot_surface_data(nrows * ncols, 52.0f);
+    RegularSurface pri_surface = RegularSurface(pri_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface = RegularSurface(top_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface bot_surface = RegularSurface(bot_surface_data.data(), nrows, ncols, grid, fill);
+    SurfaceBoundedSubVolume* subvolume = make_subvolume(datahandle.get_metadata(), pri_surface, top_surface, bot_surface);
+
+    std::size_t const ntiles = subvolume->tile(64 * sizeof(float));
+    EXPECT_GT(ntiles, 1);
+    EXPECT_EQ(subvolume->tile_bounds(0).first, 0);
+    EXPECT_EQ(subvolume->tile_bounds(ntiles - 1).second, nrows * ncols);
+
+    for (std::size_t tile = 0; tile < ntiles; ++tile) {
+        auto const bounds = subvolume->tile_bounds(tile);
+        EXPECT_LE(subvolume->nsamples(bounds.first, bounds.second), 64);
+        cppapi::fetch_subvolume(datahandle, *subvolume, NEAREST, bounds.first, bounds.second);
+    }
+
+    int low[3] = {15, 10, 28};
+    int high[3] = {24, 16, 52};
+    check_attribute(*subvolume, low, high, 2);
+
+    auto const first = subvolume->tile_bounds(0);
+    auto const last  = subvolume->tile_bounds(ntiles - 1);
+    EXPECT_THROW(
+        subvolume->allocate(first.first, last.second),
+        std::runtime_error
+    );
+
+    /* Released tiles can be fetched again */
+    subvolume->release(first.first, first.second);
+    cppapi::fetch_subvolume(datahandle, *subvolume, NEAREST, first.first, first.second);
+    check_attribute(*subvolume, low, high, 2);
+
+    delete subvolume;
+}
+
+TEST_F(DatahandleCubeIntersectionTest, Attribute_Pipelined_Double) {
+
+    DoubleDataHandle& datahandle = double_datahandle;
+    Grid grid = get_grid(datahandle);
+    const MetadataHandle* metadata = &(datahandle.get_metadata());
+
+    std::size_t nrows = metadata->iline().nsamples();
+    std::size_t ncols = metadata->xline().nsamples();
+    std::size_t size = nrows * ncols;
+    static std::vector<float> top_surface_data(size, 28.0f);
+    static std::vector<float> pri_surface_data(size, 36.0f);
+    static std::vector<float> bot_surface_data(size, 52.0f);
+    RegularSurface pri_surface = RegularSurface(pri_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface = RegularSurface(top_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface bot_surface = RegularSurface(bot_surface_data.data(), nrows, ncols, grid, fill);
+
+    std::vector< enum attribute > attributes{ VALUE, MIN, MEAN, SD };
+    ResampledSegmentBlueprint blueprint(metadata->sample().stepsize());
+
+    auto compute = [&](std::size_t tile_bytes, std::size_t max_depth) {
+        SurfaceBoundedSubVolume* subvolume = make_subvolume(
+            datahandle.get_metadata(), pri_surface, top_surface, bot_surface
+        );
+
+        std::vector< std::pair< std::size_t, std::size_t > > chunks;
+        if (tile_bytes) {
+            std::size_t const ntiles = subvolume->tile(tile_bytes);
+            for (std::size_t tile = 0; tile < ntiles; ++tile) {
+                chunks.push_back(subvolume->tile_bounds(tile));
+            }
+        } else {
+            for (std::size_t row = 0; row < nrows; ++row) {
+                chunks.emplace_back(row * ncols, (row + 1) * ncols);
+            }
+        }
+
+        std::vector< float > buffer(size * attributes.size());
+        std::vector< void* > outs;
+        for (std::size_t i = 0; i < attributes.size(); ++i) {
+            outs.push_back(buffer.data() + size * i);
+        }
+
+        std::size_t next = 0;
+        cppapi::pipeline_attributes(
+            datahandle,
+            *subvolume,
+            NEAREST,
+            &blueprint,
+            attributes.data(),
+            attributes.size(),
+            [&](std::pair< std::size_t, std::size_t >& chunk) {
+                if (next == chunks.size()) return false;
+                chunk = chunks[next++];
+                return true;
+            },
+            max_depth,
+            outs.data()
+        );
+        EXPECT_EQ(next, chunks.size());
+
+        delete subvolume;
+        return buffer;
+    };
+
+    auto const expected = compute(0, 0);
+    EXPECT_EQ(compute(0, 1), expected);
+    EXPECT_EQ(compute(0, 4), expected);
+    EXPECT_EQ(compute(64 * sizeof(float), 1), expected);
+}
+
+/*
+ * An untiled subvolume is a single tile shared by all the lanes of the pool,
+ * which must not race on allocating it
+ */
+TEST_F(DatahandleCubeIntersectionTest, Attribute_Untiled_Multithreaded_Double) {
+
+    DoubleDataHandle& datahandle = double_datahandle;
+    Grid grid = get_grid(datahandle);
+    const MetadataHandle* metadata = &(datahandle.get_metadata());
+
+    std::size_t nrows = metadata->iline().nsamples();
+    std::size_t ncols = metadata->xline().nsamples();
+    std::size_t size = nrows * ncols;
+    static std::vector<float> top_surface_data(size, 28.0f);
+    static std::vector<float> pri_surface_data(size, 36.0f);
+    static std::vector<float> bot_surface_data(size, 52.0f);
+    RegularSurface pri_surface = RegularSurface(pri_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface = RegularSurface(top_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface bot_surface = RegularSurface(bot_surface_data.data(), nrows, ncols, grid, fill);
+
+    std::vector< enum attribute > attributes{ VALUE, MIN, MEAN, SD };
+
+    auto compute = [&](std::size_t nthreads) {
+        ThreadPool::instance().configure(nthreads);
+        std::unique_ptr< SurfaceBoundedSubVolume > subvolume(make_subvolume(
+            datahandle.get_metadata(), pri_surface, top_surface, bot_surface
+        ));
+        EXPECT_EQ(subvolume->ntiles(), 1);
+
+        std::vector< float > buffer(size * attributes.size());
+        Context* ctx = context_new();
+        int status = attribute(
+            ctx,
+            &datahandle,
+            subvolume.get(),
+            NEAREST,
+            attributes.data(),
+            attributes.size(),
+            0,
+            0,
+            size,
+            buffer.data()
+        );
+        EXPECT_EQ(status, STATUS_OK) << errmsg(ctx);
+        context_free(ctx);
+
+        int low[3] = {15, 10, 28};
+        int high[3] = {24, 16, 52};
+        check_attribute(*subvolume, low, high, 2);
+        return buffer;
+    };
+
+    auto const expected = compute(0);
+    EXPECT_EQ(compute(4), expected);
+    EXPECT_EQ(compute(8), expected);
+    ThreadPool::instance().configure(0);
+}
+
 TEST_F(DatahandleCubeIntersectionTest, Attribute_Reverse_Double) {
 
     DataHandle& datahandle = double_reverse_datahandle;
@@ -228,6 +464,84 @@ TEST_F(DatahandleCubeIntersectionTest, Attribute_Double_Data_Outside_Intersectio
     );
 }
 
+TEST_F(DatahandleCubeIntersectionTest, Subvolume_Error_Is_First_Failing_Cell) {
+
+    DoubleDataHandle& datahandle = double_datahandle;
+    Grid grid = get_grid(datahandle);
+    const MetadataHandle* metadata = &(datahandle.get_metadata());
+
+    std::size_t nrows = metadata->iline().nsamples();
+    std::size_t ncols = metadata->xline().nsamples();
+    std::vector<float> top_surface_data(nrows * ncols, 28.0f);
+    std::vector<float> pri_surface_data(nrows * ncols, 36.0f);
+    std::vector<float> bot_surface_data(nrows * ncols, 52.0f);
+    // lowest sample belonging to intersection is 20
+    top_surface_data[2 * ncols + 1] = 16.0f;
+    top_surface_data[(nrows - 1) * ncols] = 16.0f;
+    RegularSurface pri_surface = RegularSurface(pri_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface = RegularSurface(top_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface bot_surface = RegularSurface(bot_surface_data.data(), nrows, ncols, grid, fill);
+
+    for (std::size_t nthreads : { 1, 4 }) {
+        ThreadPool::instance().configure(nthreads);
+        EXPECT_THAT(
+            [&]() {
+                make_subvolume(datahandle.get_metadata(), pri_surface, top_surface, bot_surface);
+            },
+            testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("at row: 2 col:1."))
+        );
+    }
+    ThreadPool::instance().configure(0);
+}
+
+TEST_F(DatahandleCubeIntersectionTest, Subvolume_Planning_Is_Independent_Of_Threads) {
+
+    DoubleDataHandle& datahandle = double_datahandle;
+    Grid grid = get_grid(datahandle);
+    const MetadataHandle* metadata = &(datahandle.get_metadata());
+
+    std::size_t nrows = metadata->iline().nsamples();
+    std::size_t ncols = metadata->xline().nsamples();
+    std::size_t size = nrows * ncols;
+    std::vector<float> top_surface_data(size);
+    std::vector<float> pri_surface_data(size, 36.0f);
+    std::vector<float> bot_surface_data(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        top_surface_data[i] = 20.0f + (i % 5) * 3;
+        bot_surface_data[i] = 40.0f + (i % 7) * 2;
+    }
+    pri_surface_data[3] = fill;
+    RegularSurface pri_surface = RegularSurface(pri_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface top_surface = RegularSurface(top_surface_data.data(), nrows, ncols, grid, fill);
+    RegularSurface bot_surface = RegularSurface(bot_surface_data.data(), nrows, ncols, grid, fill);
+
+    auto plan = [&](std::size_t nthreads) {
+        ThreadPool::instance().configure(nthreads);
+        std::unique_ptr< SurfaceBoundedSubVolume > subvolume(
+            make_subvolume(datahandle.get_metadata(), pri_surface, top_surface, bot_surface)
+        );
+        std::vector< std::size_t > offsets;
+        std::vector< int > margins;
+        std::vector< std::array< float, 2 > > positions;
+        for (std::size_t i = 0; i <= size; ++i) {
+            offsets.push_back(subvolume->nsamples(0, i));
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            margins.push_back(subvolume->top_margin(i));
+            positions.push_back(subvolume->position(i));
+        }
+        return std::make_tuple(offsets, margins, positions);
+    };
+
+    auto const expected = plan(1);
+    /* The grid follows the VDS, so the segments are centered on the traces */
+    EXPECT_NEAR(std::get< 2 >(expected)[0][0], 0.5, 1e-3);
+    EXPECT_NEAR(std::get< 2 >(expected)[0][1], 0.5, 1e-3);
+    EXPECT_EQ(plan(3), expected);
+    EXPECT_EQ(plan(8), expected);
+    ThreadPool::instance().configure(0);
+}
+
 TEST_F(DatahandleCubeIntersectionTest, Attribute_Double_Different_Number_Of_Samples_To_Border_Per_Dimension) {
     const std::string INNER_CUBE = "file://inner_4x2_cube.vds";
 
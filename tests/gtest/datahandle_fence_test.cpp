@@ -22,6 +22,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_INDEX_Single) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -43,6 +46,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_INDEX_Double) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -64,6 +70,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_INDEX_Fill_Single) {
         int(coordinates.size() / 2),
         NEAREST,
         &fill,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -85,6 +94,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_INDEX_Fill_Double) {
         int(coordinates.size() / 2),
         NEAREST,
         &fill,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -106,6 +118,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_INDEX_out_Of_Bounds_Single) {
             int(coordinates.size() / 2),
             NEAREST,
             nullptr,
+            nullptr,
+            0,
+            0,
             &response_data
         );
     },
@@ -125,6 +140,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_INDEX_out_Of_Bounds_Double) {
             int(coordinates.size() / 2),
             NEAREST,
             nullptr,
+            nullptr,
+            0,
+            0,
             &response_data
         );
     },
@@ -146,6 +164,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_ANNOTATION_Single) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -167,6 +188,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_ANNOTATION_Double) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -188,6 +212,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_ANNOTATION_Fill_Single) {
         int(coordinates.size() / 2),
         NEAREST,
         &fill,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -209,6 +236,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_ANNOTATION_Fill_Double) {
         int(coordinates.size() / 2),
         NEAREST,
         &fill,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -230,6 +260,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_ANNOTATION_out_Of_Bounds_Single) {
             int(coordinates.size() / 2),
             NEAREST,
             nullptr,
+            nullptr,
+            0,
+            0,
             &response_data
         );
     },
@@ -249,6 +282,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_ANNOTATION_out_Of_Bounds_Double) {
             int(coordinates.size() / 2),
             NEAREST,
             nullptr,
+            nullptr,
+            0,
+            0,
             &response_data
         );
     },
@@ -270,6 +306,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_CDP_Single) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -291,6 +330,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_CDP_Double) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -312,6 +354,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_CDP_Fill_Single) {
         int(coordinates.size() / 2),
         NEAREST,
         &fill,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -333,6 +378,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_CDP_Fill_Double) {
         int(coordinates.size() / 2),
         NEAREST,
         &fill,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -354,6 +402,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_CDP_out_Of_Bounds_Single) {
             int(coordinates.size() / 2),
             NEAREST,
             nullptr,
+            nullptr,
+            0,
+            0,
             &response_data
         );
     },
@@ -373,6 +424,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_CDP_out_Of_Bounds_Double) {
             int(coordinates.size() / 2),
             NEAREST,
             nullptr,
+            nullptr,
+            0,
+            0,
             &response_data
         );
     },
@@ -395,6 +449,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_INDEX_Reverse_Double) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -416,6 +473,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_INDEX_Different_Size_Double) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -450,6 +510,9 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_Different_Number_Of_Samples_To_Bord
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
@@ -470,12 +533,63 @@ TEST_F(DatahandleCubeIntersectionTest, Fence_Different_Number_Of_Samples_To_Bord
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data_reverse
     );
 
     check_fence(response_data_reverse, check_coordinates, low_sample, high_sample, 2, false);
 }
 
+TEST_F(DatahandleCubeIntersectionTest, Fence_Unordered_Duplicates_Fill_Single) {
+
+    const std::vector<float> coordinates{
+        3, 3, -1, -1, 0, 0, 3, 3, 7, 0, 8, 8, 0, 0, 0, 7, 3.4, 3.4, 7, 7
+    };
+    std::size_t const npoints = coordinates.size() / 2;
+
+    struct response response_data;
+    cppapi::fence(
+        single_datahandle,
+        coordinate_system::INDEX,
+        coordinates.data(),
+        npoints,
+        NEAREST,
+        &fill,
+        nullptr,
+        0,
+        0,
+        &response_data
+    );
+
+    std::vector<float> const values = to_vector(response_data);
+    std::size_t const nsamples = values.size() / npoints;
+
+    for (std::size_t i = 0; i < npoints; ++i) {
+        struct response point_data;
+        cppapi::fence(
+            single_datahandle,
+            coordinate_system::INDEX,
+            coordinates.data() + 2 * i,
+            1,
+            NEAREST,
+            &fill,
+            nullptr,
+            0,
+            0,
+            &point_data
+        );
+
+        std::vector<float> const expected(
+            values.begin() + i * nsamples,
+            values.begin() + (i + 1) * nsamples
+        );
+        EXPECT_EQ(to_vector(point_data), expected)
+            << "Point " << i << " differs from a fence of the point alone";
+    }
+}
+
 TEST_F(Datahandle10SamplesTest, Fence_Single_Negative) {
     const std::string NEGATIVE = "file://10_negative.vds";
 
@@ -499,6 +613,9 @@ TEST_F(Datahandle10SamplesTest, Fence_Single_Negative) {
         int(coordinates.size() / 2),
         NEAREST,
         nullptr,
+        nullptr,
+        0,
+        0,
         &response_data
     );
 
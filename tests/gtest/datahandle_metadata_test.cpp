@@ -114,6 +114,7 @@ TEST_F(DatahandleMetadataTest, Metadata_Single_Slice) {
         Direction(axis_name::I),
         2,
         slice_bounds,
+        0,
         &response_data
     );
     nlohmann::json metadata = nlohmann::json::parse(response_data.data, response_data.data + response_data.size);
@@ -134,6 +135,9 @@ TEST_F(DatahandleMetadataTest, Metadata_Single_Fence) {
     cppapi::fence_metadata(
         single_datahandle,
         5,
+        nullptr,
+        0,
+        0,
         &response_data
     );
     nlohmann::json metadata = nlohmann::json::parse(response_data.data, response_data.data + response_data.size);
@@ -199,6 +203,7 @@ TEST_F(DatahandleMetadataTest, Metadata_Double_Slice) {
         Direction(axis_name::I),
         2,
         slice_bounds,
+        0,
         &response_data
     );
     nlohmann::json metadata = nlohmann::json::parse(response_data.data, response_data.data + response_data.size);
@@ -219,6 +224,9 @@ TEST_F(DatahandleMetadataTest, Metadata_Double_Fence) {
     cppapi::fence_metadata(
         double_datahandle,
         5,
+        nullptr,
+        0,
+        0,
         &response_data
     );
     nlohmann::json metadata = nlohmann::json::parse(response_data.data, response_data.data + response_data.size);
@@ -1,5 +1,6 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include <cstring>
 #include <iostream>
 
 #include "test_utils.hpp"
@@ -20,6 +21,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_I_Single) {
         Direction(axis_name::I),
         line_index,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -39,6 +41,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_I_Double) {
         Direction(axis_name::I),
         line_index,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -58,6 +61,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_J_Single) {
         Direction(axis_name::J),
         line_index,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -77,6 +81,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_J_Double) {
         Direction(axis_name::J),
         line_index,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -96,6 +101,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_K_Single) {
         Direction(axis_name::K),
         line_index,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -115,6 +121,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_K_Double) {
         Direction(axis_name::K),
         line_index,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -131,6 +138,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_INLINE_Single) {
         Direction(axis_name::INLINE),
         21,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -147,6 +155,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_INLINE_Double) {
         Direction(axis_name::INLINE),
         21,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -163,6 +172,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_CROSSLINE_Single) {
         Direction(axis_name::CROSSLINE),
         14,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -179,6 +189,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_CROSSLINE_Double) {
         Direction(axis_name::CROSSLINE),
         14,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -195,6 +206,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_SAMPLE_Single) {
         Direction(axis_name::SAMPLE),
         40,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -211,6 +223,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_SAMPLE_Double) {
         Direction(axis_name::SAMPLE),
         40,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -227,6 +240,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Single) {
         Direction(axis_name::TIME),
         40,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -243,6 +257,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Double) {
         Direction(axis_name::TIME),
         40,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -261,6 +276,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_DEPTH_Single) {
             Direction(axis_name::DEPTH),
             40,
             slice_bounds,
+            0,
             &response_data
         );
     },
@@ -277,6 +293,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_DEPTH_Double) {
             Direction(axis_name::DEPTH),
             40,
             slice_bounds,
+            0,
             &response_data
         );
     },
@@ -294,6 +311,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Invalid_Single) {
             direction,
             0,
             slice_bounds,
+            0,
             &response_data
         );
     },
@@ -305,6 +323,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Invalid_Single) {
             direction,
             132,
             slice_bounds,
+            0,
             &response_data
         );
     },
@@ -316,6 +335,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Invalid_Single) {
             direction,
             21,
             slice_bounds,
+            0,
             &response_data
         );
     },
@@ -333,6 +353,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Invalid_Double) {
             direction,
             16,
             slice_bounds,
+            0,
             &response_data
         );
     },
@@ -344,6 +365,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Invalid_Double) {
             direction,
             132,
             slice_bounds,
+            0,
             &response_data
         );
     },
@@ -355,6 +377,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Invalid_Double) {
             direction,
             21,
             slice_bounds,
+            0,
             &response_data
         );
     },
@@ -369,6 +392,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Axis_TIME_Reverse_Double) {
         Direction(axis_name::TIME),
         40,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -385,6 +409,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Different_Size_Double) {
         Direction(axis_name::INLINE),
         30,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -410,6 +435,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Different_Number_Of_Samples_To_Bord
         Direction(axis_name::CROSSLINE),
         14,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -434,6 +460,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Minimum_Single) {
         Direction(axis_name::TIME),
         8,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -465,6 +492,7 @@ TEST_F(DatahandleCubeIntersectionTest, Slice_Minimum_Double) {
         Direction(axis_name::TIME),
         124,
         slice_bounds,
+        0,
         &response_data
     );
 
@@ -501,6 +529,7 @@ TEST_F(Datahandle10SamplesTest, Slice_Single_Negative) {
         Direction(axis_name::CROSSLINE),
         -11,
         std::vector<Bound>{Bound{-16, 8, axis_name::TIME}},
+        0,
         &response_data
     );
 
@@ -509,4 +538,126 @@ TEST_F(Datahandle10SamplesTest, Slice_Single_Negative) {
     check_slice(response_data, metadata.coordinate_transformer(), low, high);
 }
 
+TEST_F(DatahandleCubeIntersectionTest, Slice_Negative_LOD) {
+    struct response response_data;
+
+    EXPECT_THAT([&]() {
+        cppapi::slice(
+            single_datahandle,
+            Direction(axis_name::I),
+            2,
+            slice_bounds,
+            -1,
+            &response_data
+        );
+    },
+                testing::ThrowsMessage<detail::bad_request>(testing::HasSubstr("Invalid level of detail: -1")));
+}
+
+TEST_F(DatahandleCubeIntersectionTest, Slice_LOD_Double) {
+    struct response response_data;
+
+    EXPECT_THAT([&]() {
+        cppapi::slice(
+            double_datahandle,
+            Direction(axis_name::I),
+            2,
+            slice_bounds,
+            1,
+            &response_data
+        );
+    },
+                testing::ThrowsMessage<detail::bad_request>(testing::HasSubstr("Invalid level of detail: 1, valid range: [0:0]")));
+}
+
+TEST_F(DatahandleCubeIntersectionTest, Slices_Match_Slice) {
+    std::vector< int > const linenos{ 5, 0, 1, 2, 7, 2 };
+    std::vector< Direction > const directions{
+        Direction(axis_name::I),
+        Direction(axis_name::J),
+        Direction(axis_name::K),
+    };
+
+    for (auto const& direction : directions) {
+        for (int lod : { 0, 1 }) {
+            struct response response_data;
+            cppapi::slices(
+                single_datahandle,
+                direction,
+                linenos,
+                slice_bounds,
+                lod,
+                &response_data
+            );
+            std::unique_ptr< char[] > slices(response_data.data);
+
+            std::size_t const slice_size = response_data.size / linenos.size();
+            for (std::size_t i = 0; i < linenos.size(); ++i) {
+                struct response expected;
+                cppapi::slice(
+                    single_datahandle,
+                    direction,
+                    linenos[i],
+                    slice_bounds,
+                    lod,
+                    &expected
+                );
+                std::unique_ptr< char[] > data(expected.data);
+
+                ASSERT_EQ(expected.size, slice_size);
+                EXPECT_EQ(std::memcmp(data.get(), slices.get() + i * slice_size, slice_size), 0)
+                    << "Slice " << linenos[i] << " at lod " << lod << " differs";
+            }
+        }
+    }
+}
+
+TEST_F(DatahandleCubeIntersectionTest, Slices_Double) {
+    std::vector< int > const linenos{ 3, 1 };
+    struct response response_data;
+    cppapi::slices(
+        double_datahandle,
+        Direction(axis_name::I),
+        linenos,
+        slice_bounds,
+        0,
+        &response_data
+    );
+    std::unique_ptr< char[] > slices(response_data.data);
+
+    std::size_t const slice_size = response_data.size / linenos.size();
+    for (std::size_t i = 0; i < linenos.size(); ++i) {
+        struct response expected;
+        cppapi::slice(
+            double_datahandle,
+            Direction(axis_name::I),
+            linenos[i],
+            slice_bounds,
+            0,
+            &expected
+        );
+        std::unique_ptr< char[] > data(expected.data);
+
+        ASSERT_EQ(expected.size, slice_size);
+        EXPECT_EQ(std::memcmp(data.get(), slices.get() + i * slice_size, slice_size), 0);
+    }
+}
+
+TEST_F(DatahandleCubeIntersectionTest, SubCube_LOD_Decimation) {
+    SubCube subcube(single_datahandle.get_metadata());
+    subcube.bounds.lower[0] = 3;
+    subcube.bounds.upper[0] = 14;
+    subcube.lod = 2;
+
+    /* Samples 3 through 13 are covered by samples 0, 4, 8 and 12 at lod 2 */
+    EXPECT_EQ(subcube.first(0), 0);
+    EXPECT_EQ(subcube.last(0), 12);
+    EXPECT_EQ(subcube.nsamples(0), 4);
+
+    subcube.lod = 0;
+    EXPECT_EQ(subcube.first(0), 3);
+    EXPECT_EQ(subcube.last(0), 13);
+    EXPECT_EQ(subcube.nsamples(0), 11);
+}
+
 } // namespace
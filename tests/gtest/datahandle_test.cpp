@@ -219,4 +219,47 @@ TEST_F(DataHandleTest, SubtractionReverse) {
     delete subvolume;
 }
 
+TEST_F(DataHandleTest, ConcurrentSubcubeRequests) {
+    DoubleDataHandle datahandle = make_double_datahandle(
+        DEFAULT_DATA.c_str(),
+        CREDENTIALS.c_str(),
+        DOUBLE_VALUE_DATA.c_str(),
+        CREDENTIALS.c_str(),
+        binary_operator::ADDITION
+    );
+
+    SubCube subcube(datahandle.get_metadata());
+    subcube.set_slice(datahandle.get_metadata().iline(), 0, INDEX);
+    std::int64_t const size = datahandle.subcube_buffer_size(subcube);
+
+    std::vector< float > sum(size / sizeof(float));
+    std::vector< float > reference(size / sizeof(float));
+
+    auto request_sum = datahandle.request_subcube(sum.data(), size, subcube);
+    auto request_reference = datahandle_reference.request_subcube(
+        reference.data(), size, subcube
+    );
+
+    request_reference->wait();
+    request_sum->wait();
+
+    for (std::size_t i = 0; i < sum.size(); ++i) {
+        EXPECT_NEAR(sum[i], 3 * reference[i], DELTA) << "at position " << i;
+    }
+}
+
+TEST_F(DataHandleTest, DroppedRequestIsCancelled) {
+    SubCube subcube(datahandle_reference.get_metadata());
+    subcube.set_slice(datahandle_reference.get_metadata().iline(), 0, INDEX);
+    std::int64_t const size = datahandle_reference.subcube_buffer_size(subcube);
+
+    {
+        std::vector< float > buffer(size / sizeof(float));
+        auto request = datahandle_reference.request_subcube(buffer.data(), size, subcube);
+    }
+
+    std::vector< float > buffer(size / sizeof(float));
+    EXPECT_NO_THROW(datahandle_reference.read_subcube(buffer.data(), size, subcube));
+}
+
 } // namespace
@@ -0,0 +1,73 @@
+#include <chrono>
+
+#include "cppapi.hpp"
+#include "ctypes.h"
+#include "datahandlepool.hpp"
+#include "test_utils.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+const std::string REGULAR_DATA = "file://regular_8x2_cube.vds";
+const std::string SHIFT_4_DATA = "file://shift_4_8x2_cube.vds";
+const std::string SHIFT_8_32_DATA = "file://shift_8_32x3_cube.vds";
+
+class DataHandlePoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        DataHandlePool::instance().configure(std::chrono::seconds(60), 2);
+    }
+
+    void TearDown() override {
+        DataHandlePool::instance().configure(std::chrono::seconds(0), 64);
+    }
+
+    DataHandlePool& pool = DataHandlePool::instance();
+};
+
+TEST_F(DataHandlePoolTest, DisabledPoolKeepsNothing) {
+    pool.configure(std::chrono::seconds(0), 2);
+
+    SingleDataHandle handle = pool.acquire(REGULAR_DATA.c_str(), CREDENTIALS.c_str());
+    EXPECT_EQ(pool.size(), 0);
+    handle.close();
+}
+
+TEST_F(DataHandlePoolTest, SameVdsIsShared) {
+    SingleDataHandle handle_a = pool.acquire(REGULAR_DATA.c_str(), CREDENTIALS.c_str());
+    SingleDataHandle handle_b = pool.acquire(REGULAR_DATA.c_str(), CREDENTIALS.c_str());
+    EXPECT_EQ(pool.size(), 1);
+
+    handle_a.close();
+
+    struct response response_data;
+    cppapi::slice(handle_b, Direction(axis_name::I), 0, {}, 0, &response_data);
+    EXPECT_FALSE(to_vector(response_data).empty());
+
+    handle_b.close();
+}
+
+TEST_F(DataHandlePoolTest, LeastRecentlyUsedIsEvicted) {
+    pool.acquire(REGULAR_DATA.c_str(), CREDENTIALS.c_str()).close();
+    pool.acquire(SHIFT_4_DATA.c_str(), CREDENTIALS.c_str()).close();
+    EXPECT_EQ(pool.size(), 2);
+
+    pool.acquire(SHIFT_8_32_DATA.c_str(), CREDENTIALS.c_str()).close();
+    EXPECT_EQ(pool.size(), 2);
+}
+
+TEST_F(DataHandlePoolTest, HandleOutlivesEviction) {
+    SingleDataHandle handle = pool.acquire(REGULAR_DATA.c_str(), CREDENTIALS.c_str());
+    pool.clear();
+    EXPECT_EQ(pool.size(), 0);
+
+    struct response response_data;
+    cppapi::slice(handle, Direction(axis_name::I), 0, {}, 0, &response_data);
+    EXPECT_FALSE(to_vector(response_data).empty());
+
+    handle.close();
+}
+
+} // namespace
@@ -0,0 +1,116 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "ctypes.h"
+#include "inplace_operator.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+const std::vector< binary_operator > OPERATORS{
+    ADDITION, SUBTRACTION, MULTIPLICATION, DIVISION
+};
+
+const std::vector< instruction_set > INSTRUCTION_SETS{
+    instruction_set::SCALAR,
+    instruction_set::SSE2,
+    instruction_set::AVX2,
+    instruction_set::AVX512,
+};
+
+float apply(binary_operator op, float a, float b) {
+    switch (op) {
+        case ADDITION:       return a + b;
+        case SUBTRACTION:    return a - b;
+        case MULTIPLICATION: return a * b;
+        case DIVISION:       return a / b;
+        default:             throw std::runtime_error("Unexpected operator");
+    }
+}
+
+/*
+ * Inputs include zeros, negative zeros, infinities and nans so that the
+ * special cases of division are exercised in every lane.
+ */
+std::vector< float > make_input(std::size_t size, int seed) {
+    const float special[] = {
+        0.0f, -0.0f, 1.0f, -2.5f,
+        std::numeric_limits< float >::infinity(),
+        std::numeric_limits< float >::quiet_NaN(),
+        -999.25f, 3.0f,
+    };
+    std::vector< float > input(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        input[i] = special[(i * 7 + seed) % 8] + (i % 3) * seed;
+    }
+    return input;
+}
+
+void expect_same(float expected, float actual, std::size_t i) {
+    if (std::isnan(expected)) {
+        EXPECT_TRUE(std::isnan(actual)) << "at position " << i;
+    } else {
+        EXPECT_EQ(expected, actual) << "at position " << i;
+    }
+}
+
+TEST(InplaceOperatorTest, InvalidOperator) {
+    EXPECT_EQ(inplace_kernel(NO_OPERATOR), nullptr);
+    EXPECT_EQ(inplace_kernel(INVALID_OPERATOR), nullptr);
+}
+
+TEST(InplaceOperatorTest, ScalarAlwaysAvailable) {
+    for (auto op : OPERATORS) {
+        EXPECT_NE(inplace_kernel(op, instruction_set::SCALAR), nullptr);
+    }
+}
+
+TEST(InplaceOperatorTest, KernelsMatchScalarDefinition) {
+    /* Sizes around the vector widths to hit all loop tails */
+    const std::vector< std::size_t > sizes{0, 1, 3, 4, 5, 8, 15, 16, 17, 31, 33, 67};
+
+    for (auto isa : INSTRUCTION_SETS) {
+        if (isa > supported_instruction_set()) continue;
+
+        for (auto op : OPERATORS) {
+            inplace_operator kernel = inplace_kernel(op, isa);
+            if (not kernel) continue;
+
+            for (auto size : sizes) {
+                std::vector< float > a = make_input(size, 1);
+                std::vector< float > b = make_input(size, 2);
+                std::vector< float > result = a;
+
+                kernel(result.data(), b.data(), size);
+
+                for (std::size_t i = 0; i < size; ++i) {
+                    SCOPED_TRACE(
+                        "isa " + std::to_string((int)isa) +
+                        ", operator " + std::to_string(op) +
+                        ", size " + std::to_string(size)
+                    );
+                    expect_same(apply(op, a[i], b[i]), result[i], i);
+                }
+            }
+        }
+    }
+}
+
+TEST(InplaceOperatorTest, DivisionByZero) {
+    std::vector< float > a{1.0f, -1.0f, 0.0f, 2.0f, 1.0f, -1.0f, 0.0f, 2.0f, 1.0f};
+    std::vector< float > b{0.0f, 0.0f, 0.0f, -0.0f, 0.0f, 0.0f, 0.0f, -0.0f, 0.0f};
+
+    inplace_division(a.data(), b.data(), a.size());
+
+    const float inf = std::numeric_limits< float >::infinity();
+    EXPECT_EQ(a[0], inf);
+    EXPECT_EQ(a[1], -inf);
+    EXPECT_TRUE(std::isnan(a[2]));
+    EXPECT_EQ(a[3], -inf);
+    EXPECT_EQ(a[8], inf);
+}
+
+} // namespace
@@ -0,0 +1,180 @@
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "cppapi.hpp"
+#include "ctypes.h"
+#include "prefetcher.hpp"
+#include "test_utils.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+/* Size of a fake slice in bytes */
+constexpr std::int64_t SLICE_SIZE = 16;
+
+/* Fake read that fills the buffer with the line number */
+class FakeReadRequest : public ReadRequest {
+public:
+    FakeReadRequest(void* buffer, std::int64_t size, int line)
+        : m_buffer(buffer), m_size(size), m_line(line)
+    {}
+
+    void wait() noexcept(false) override {
+        std::memset(this->m_buffer, this->m_line, this->m_size);
+    }
+
+private:
+    void* m_buffer;
+    std::int64_t m_size;
+    int m_line;
+};
+
+class PrefetcherTest : public DatahandleRegularCubeTest {
+protected:
+    PrefetcherTest() : volume(datahandle.get_metadata()) {}
+
+    void SetUp() override {
+        SlicePrefetcher::configure(2, 1024);
+        this->before = SlicePrefetcher::statistics();
+    }
+
+    void TearDown() override {
+        SlicePrefetcher::configure(0, 256 * 1024 * 1024);
+        DatahandleRegularCubeTest::TearDown();
+    }
+
+    std::unique_ptr< SlicePrefetcher > make_prefetcher() {
+        return std::unique_ptr< SlicePrefetcher >(new SlicePrefetcher(
+            this->volume,
+            [this](void* buffer, std::int64_t size, SubCube const& subcube) {
+                int const line = subcube.bounds.lower[dimension];
+                this->fetched.push_back(line);
+                return std::unique_ptr< ReadRequest >(
+                    new FakeReadRequest(buffer, size, line)
+                );
+            },
+            [](SubCube const&) { return SLICE_SIZE; }
+        ));
+    }
+
+    SubCube slice(int line) const {
+        SubCube subcube(this->volume);
+        subcube.bounds.lower[dimension] = line;
+        subcube.bounds.upper[dimension] = line + 1;
+        return subcube;
+    }
+
+    std::vector< char > read(SlicePrefetcher& prefetcher, int line) const {
+        std::vector< char > buffer(SLICE_SIZE);
+        prefetcher.request(buffer.data(), buffer.size(), slice(line))->wait();
+        return buffer;
+    }
+
+    SlicePrefetcher::Statistics delta() const {
+        auto const after = SlicePrefetcher::statistics();
+        return SlicePrefetcher::Statistics{
+            after.hits   - this->before.hits,
+            after.misses - this->before.misses,
+            after.waste  - this->before.waste,
+        };
+    }
+
+    static constexpr int dimension = 2;
+
+    SubCube volume;
+    std::vector< int > fetched;
+    SlicePrefetcher::Statistics before;
+};
+
+TEST_F(PrefetcherTest, DisabledPrefetcherIsPassThrough) {
+    SlicePrefetcher::configure(0, 1024);
+    auto prefetcher = make_prefetcher();
+
+    for (int line = 0; line < 4; ++line) read(*prefetcher, line);
+
+    EXPECT_THAT(fetched, ::testing::ElementsAre(0, 1, 2, 3));
+    EXPECT_EQ(delta().hits, 0);
+    EXPECT_EQ(delta().misses, 0);
+}
+
+TEST_F(PrefetcherTest, SequentialSlicesAreReadAhead) {
+    auto prefetcher = make_prefetcher();
+
+    read(*prefetcher, 0);
+    read(*prefetcher, 1);
+    EXPECT_THAT(fetched, ::testing::ElementsAre(0, 1));
+
+    /* Second slice with the same stride, the next two are read ahead */
+    read(*prefetcher, 2);
+    EXPECT_THAT(fetched, ::testing::ElementsAre(0, 1, 2, 3, 4));
+
+    std::vector< char > const buffer = read(*prefetcher, 3);
+    EXPECT_THAT(buffer, ::testing::Each(3));
+    EXPECT_THAT(fetched, ::testing::ElementsAre(0, 1, 2, 3, 4, 5));
+
+    EXPECT_EQ(delta().hits, 1);
+    EXPECT_EQ(delta().misses, 3);
+}
+
+TEST_F(PrefetcherTest, NegativeStrideIsReadAhead) {
+    auto prefetcher = make_prefetcher();
+
+    read(*prefetcher, 6);
+    read(*prefetcher, 4);
+    read(*prefetcher, 2);
+    EXPECT_THAT(fetched, ::testing::ElementsAre(6, 4, 2, 0));
+
+    std::vector< char > const buffer = read(*prefetcher, 0);
+    EXPECT_THAT(buffer, ::testing::Each(0));
+    EXPECT_EQ(delta().hits, 1);
+}
+
+TEST_F(PrefetcherTest, ReadAheadStopsAtEdgeOfVolume) {
+    auto prefetcher = make_prefetcher();
+
+    int const last = volume.bounds.upper[dimension] - 1;
+    read(*prefetcher, last - 2);
+    read(*prefetcher, last - 1);
+    read(*prefetcher, last);
+    EXPECT_THAT(fetched, ::testing::ElementsAre(last - 2, last - 1, last));
+}
+
+TEST_F(PrefetcherTest, BufferIsBounded) {
+    SlicePrefetcher::configure(4, 2 * SLICE_SIZE);
+    {
+        auto prefetcher = make_prefetcher();
+
+        read(*prefetcher, 0);
+        read(*prefetcher, 1);
+        read(*prefetcher, 2);
+        /* Room for two slices only */
+        EXPECT_THAT(fetched, ::testing::ElementsAre(0, 1, 2, 3, 4));
+    }
+    /* Both speculative reads were dropped unused */
+    EXPECT_EQ(delta().waste, 2);
+}
+
+TEST_F(PrefetcherTest, OldestSliceIsEvicted) {
+    SlicePrefetcher::configure(1, SLICE_SIZE);
+    auto prefetcher = make_prefetcher();
+
+    read(*prefetcher, 0);
+    read(*prefetcher, 1);
+    read(*prefetcher, 2);
+    EXPECT_THAT(fetched, ::testing::ElementsAre(0, 1, 2, 3));
+
+    /* Turning around evicts 3 to make room for 4 */
+    read(*prefetcher, 7);
+    read(*prefetcher, 6);
+    read(*prefetcher, 5);
+    EXPECT_THAT(fetched, ::testing::ElementsAre(0, 1, 2, 3, 7, 6, 5, 4));
+    EXPECT_EQ(delta().waste, 1);
+
+    read(*prefetcher, 4);
+    EXPECT_EQ(delta().hits, 1);
+}
+
+} // namespace
@@ -168,4 +168,41 @@ TEST(RegularSurfaceSubscriptTest, DoubleVersusReference) {
     }
 }
 
+TEST(RegularSurfaceShiftedTest, ValuesAreOffset) {
+    std::array<float, nrows *ncols> data = {2, 3, fill, 7, 11, 13};
+    RegularSurface const surface =
+        RegularSurface(data.data(), nrows, ncols, samples_10_grid, fill);
+    RegularSurface const shifted = surface.shifted(-1.5);
+
+    EXPECT_EQ(shifted.grid(), surface.grid());
+    EXPECT_EQ(shifted.fillvalue(), fill);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        if (data[i] == fill) {
+            EXPECT_EQ(shifted[i], fill);
+        } else {
+            EXPECT_EQ(shifted[i], data[i] - 1.5f);
+        }
+    }
+    EXPECT_EQ(shifted[as_pair(2, 1)], 11.5f);
+
+    /* The shifted surface is a view, not a copy */
+    data[0] = 4;
+    EXPECT_EQ(shifted[0], 2.5f);
+}
+
+TEST(RegularSurfaceShiftedTest, IsReadOnly) {
+    std::array<float, nrows *ncols> data = ref_surface_data;
+    RegularSurface surface =
+        RegularSurface(data.data(), nrows, ncols, samples_10_grid, fill);
+    RegularSurface shifted = surface.shifted(2);
+
+    EXPECT_THROW(shifted[0] = 1, std::runtime_error);
+    EXPECT_THROW(shifted[as_pair(0, 0)] = 1, std::runtime_error);
+
+    RegularSurface unshifted = surface.shifted(0);
+    EXPECT_THROW(unshifted[0] = 1, std::runtime_error);
+    EXPECT_THROW(unshifted[as_pair(0, 0)] = 1, std::runtime_error);
+    EXPECT_EQ(data, ref_surface_data);
+}
+
 } // namespace
@@ -0,0 +1,88 @@
+#include <memory>
+#include <vector>
+
+#include "cppapi.hpp"
+#include "ctypes.h"
+#include "slicecache.hpp"
+#include "test_utils.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+class SliceCacheTest : public DatahandleRegularCubeTest {
+protected:
+    void SetUp() override {
+        cache.configure(64 * 1024 * 1024);
+    }
+
+    void TearDown() override {
+        cache.configure(0);
+        DatahandleRegularCubeTest::TearDown();
+    }
+
+    static std::shared_ptr< SliceCache::Slice > make_slice(std::size_t nsamples) {
+        auto slice = std::make_shared< SliceCache::Slice >();
+        slice->shape = { int(nsamples), 1, 1 };
+        slice->data.resize(nsamples);
+        return slice;
+    }
+
+    SliceCache& cache = SliceCache::instance();
+};
+
+TEST_F(SliceCacheTest, CacheIsBounded) {
+    cache.configure(4 * 1024);
+
+    for (int line = 0; line < 16; ++line) {
+        cache.insert(SliceCache::Key{ "vds", 0, line, 0 }, make_slice(256));
+    }
+    EXPECT_EQ(cache.size(), 4 * 1024);
+    EXPECT_EQ(cache.find(SliceCache::Key{ "vds", 0, 0, 0 }), nullptr);
+    EXPECT_NE(cache.find(SliceCache::Key{ "vds", 0, 15, 0 }), nullptr);
+}
+
+TEST_F(SliceCacheTest, DisabledCacheKeepsNothing) {
+    cache.configure(0);
+    EXPECT_FALSE(cache.enabled());
+
+    slice(Direction(axis_name::I), 2, {});
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(SliceCacheTest, OnlyFullSlicesAreKept) {
+    slice(Direction(axis_name::I), 2, { Bound{ 1, 4, axis_name::J } });
+    EXPECT_EQ(cache.size(), 0);
+
+    slice(Direction(axis_name::I), 2, {});
+    EXPECT_GT(cache.size(), 0);
+}
+
+TEST_F(SliceCacheTest, ConstrainedSlicesMatchVds) {
+    struct Case {
+        Direction direction;
+        std::vector< Bound > bounds;
+    };
+    std::vector< Case > const cases{
+        { Direction(axis_name::I), { Bound{ 1, 4, axis_name::J } } },
+        { Direction(axis_name::I), { Bound{ 2, 5, axis_name::K } } },
+        { Direction(axis_name::J), { Bound{ 0, 3, axis_name::I },
+                                     Bound{ 4, 9, axis_name::K } } },
+        { Direction(axis_name::K), { Bound{ 3, 7, axis_name::J } } },
+    };
+
+    for (auto const& c : cases) {
+        cache.configure(0);
+        auto const expected = slice(c.direction, 3, c.bounds);
+
+        cache.configure(64 * 1024 * 1024);
+        slice(c.direction, 3, {});
+        std::size_t const size = cache.size();
+
+        EXPECT_EQ(slice(c.direction, 3, c.bounds), expected);
+        EXPECT_EQ(cache.size(), size);
+    }
+}
+
+} // namespace
@@ -333,4 +333,98 @@ TEST(SegmentBlueprintTest, NegativeAxis) {
     EXPECT_EQ(6, resampled.size(reference, top_boundary, bottom_boundary));
 }
 
+TEST(ResampleTest, OnSamplesIsIdentity) {
+    RawSegmentBlueprint raw = RawSegmentBlueprint(4, 0);
+    ResampledSegmentBlueprint resampled = ResampledSegmentBlueprint(4);
+
+    std::vector<float> data{ 3, -1, 4, 1, -5, 9, 2, -6 };
+    /* Samples at 8, 12, ..., 36, of which 2 on each side are margin */
+    RawSegment src = RawSegment(20, 16, 28, 2, data.begin(), data.end(), &raw);
+    ResampledSegment dst = ResampledSegment(20, 16, 28, &resampled);
+    ResampleScratch scratch;
+
+    resample(src, dst, scratch);
+
+    std::vector<double> expected(data.begin() + 2, data.end() - 2);
+    EXPECT_THAT(std::vector<double>(dst.begin(), dst.end()), ::testing::ElementsAreArray(expected));
+}
+
+TEST(ResampleTest, LinearDataIsReproduced) {
+    RawSegmentBlueprint raw = RawSegmentBlueprint(4, 0);
+    ResampledSegmentBlueprint resampled = ResampledSegmentBlueprint(0.5);
+
+    /* Samples at 8, 12, ..., 40 */
+    std::vector<float> data;
+    for (int i = 0; i < 9; ++i) data.push_back(2.5f * (8 + 4 * i) - 7);
+
+    RawSegment src = RawSegment(21, 16, 32, 2, data.begin(), data.end(), &raw);
+    ResampledSegment dst = ResampledSegment(21, 16, 32, &resampled);
+    ResampleScratch scratch;
+
+    resample(src, dst, scratch);
+
+    ASSERT_EQ(dst.size(), 33);
+    std::size_t i = 0;
+    for (double value : dst) {
+        EXPECT_NEAR(2.5 * dst.sample_position_at(i++) - 7, value, 1e-9);
+    }
+}
+
+TEST(ResampleTest, OffSamplesIsInterpolated) {
+    RawSegmentBlueprint raw = RawSegmentBlueprint(4, 0);
+    ResampledSegmentBlueprint resampled = ResampledSegmentBlueprint(4);
+
+    /* Samples at 8, 12, ..., 40 */
+    std::vector<float> data;
+    for (int i = 0; i < 9; ++i) data.push_back(-1.5f * (8 + 4 * i) + 2);
+
+    RawSegment src = RawSegment(21, 16, 32, 2, data.begin(), data.end(), &raw);
+    ResampledSegment dst = ResampledSegment(21, 16, 32, &resampled);
+    ResampleScratch scratch;
+
+    resample(src, dst, scratch);
+
+    std::vector<double> expected{ -1.5 * 17 + 2, -1.5 * 21 + 2, -1.5 * 25 + 2, -1.5 * 29 + 2 };
+    EXPECT_THAT(
+        std::vector<double>(dst.begin(), dst.end()),
+        ::testing::Pointwise(::testing::DoubleNear(1e-9), expected)
+    );
+}
+
+TEST(ResampleTest, ScratchIsReused) {
+    RawSegmentBlueprint raw = RawSegmentBlueprint(4, 0);
+    ResampledSegmentBlueprint resampled = ResampledSegmentBlueprint(1);
+
+    std::vector<float> data{ 3, -1, 4, 1, -5, 9, 2, -6, 5, 3, -5 };
+    RawSegment longer  = RawSegment(18, 16, 36, 2, data.begin(), data.end(), &raw);
+    RawSegment shorter = RawSegment(18, 16, 24, 2, data.begin(), data.begin() + 7, &raw);
+
+    ResampledSegment expected = ResampledSegment(18, 16, 24, &resampled);
+    ResampleScratch fresh;
+    resample(shorter, expected, fresh);
+
+    ResampledSegment dst = ResampledSegment(18, 16, 36, &resampled);
+    ResampleScratch scratch;
+    resample(longer, dst, scratch);
+    dst.reinitialize(18, 16, 24);
+    resample(shorter, dst, scratch);
+
+    EXPECT_THAT(
+        std::vector<double>(dst.begin(), dst.end()),
+        ::testing::ElementsAreArray(expected.begin(), expected.end())
+    );
+}
+
+TEST(ResampleTest, TooFewSamplesThrows) {
+    RawSegmentBlueprint raw = RawSegmentBlueprint(4, 0);
+    ResampledSegmentBlueprint resampled = ResampledSegmentBlueprint(4);
+
+    std::vector<float> data{ 1, 2, 3 };
+    RawSegment src = RawSegment(8, 8, 8, 1, data.begin(), data.end(), &raw);
+    ResampledSegment dst = ResampledSegment(8, 8, 8, &resampled);
+    ResampleScratch scratch;
+
+    EXPECT_THROW(resample(src, dst, scratch), std::domain_error);
+}
+
 } // namespace
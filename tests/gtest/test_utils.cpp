@@ -2,6 +2,43 @@
 
 #include "subvolume.hpp"
 
+std::vector<float> to_vector(struct response const& response_data) {
+    float const* data = reinterpret_cast<float const*>(response_data.data);
+    std::vector<float> values(data, data + response_data.size / sizeof(float));
+    delete[] response_data.data;
+    return values;
+}
+
+std::vector<float> DatahandleRegularCubeTest::slice(
+    Direction const direction,
+    int lineno,
+    std::vector<Bound> const& bounds
+) {
+    struct response response_data;
+    cppapi::slice(datahandle, direction, lineno, bounds, 0, &response_data);
+    return to_vector(response_data);
+}
+
+std::vector<float> DatahandleRegularCubeTest::fence(
+    std::vector<float> const& coordinates,
+    enum interpolation_method interpolation
+) {
+    struct response response_data;
+    cppapi::fence(
+        datahandle,
+        coordinate_system::INDEX,
+        coordinates.data(),
+        coordinates.size() / 2,
+        interpolation,
+        nullptr,
+        nullptr,
+        0,
+        0,
+        &response_data
+    );
+    return to_vector(response_data);
+}
+
 void DatahandleCubeIntersectionTest::check_value(
     int value, int expected_iline, int expected_xline, int expected_sample
 ) {
@@ -4,6 +4,8 @@
 #include "cppapi.hpp"
 #include "ctypes.h"
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -11,6 +13,47 @@
 const std::string CREDENTIALS = "";
 static constexpr float fill = -999.25;
 
+/**
+ * @brief Copy the float values of a response, and free the response data
+ */
+std::vector<float> to_vector(struct response const& response_data);
+
+/**
+ * Fixture with a single datahandle to the regular 8x2 cube, closed after
+ * every test, for tests of the layers between the C++ API and OpenVDS
+ */
+class DatahandleRegularCubeTest : public ::testing::Test {
+protected:
+    const std::string REGULAR_DATA = "file://regular_8x2_cube.vds";
+
+    DatahandleRegularCubeTest()
+        : datahandle(make_single_datahandle(REGULAR_DATA.c_str(), CREDENTIALS.c_str()))
+    {}
+
+    void TearDown() override {
+        datahandle.close();
+    }
+
+    /**
+     * @brief Slice through cppapi::slice at full resolution
+     */
+    std::vector<float> slice(
+        Direction const direction,
+        int lineno,
+        std::vector<Bound> const& bounds = {}
+    );
+
+    /**
+     * @brief Fence of whole traces through cppapi::fence, in index coordinates
+     */
+    std::vector<float> fence(
+        std::vector<float> const& coordinates,
+        enum interpolation_method interpolation
+    );
+
+    SingleDataHandle datahandle;
+};
+
 class DatahandleCubeIntersectionTest : public ::testing::Test {
 protected:
     const std::string REGULAR_DATA = "file://regular_8x2_cube.vds";
@@ -0,0 +1,91 @@
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "threadpool.hpp"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+class ThreadPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        pool.configure(4);
+    }
+
+    void TearDown() override {
+        pool.configure(0);
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+};
+
+TEST_F(ThreadPoolTest, ConfigureSetsSize) {
+    EXPECT_EQ(pool.size(), 4);
+
+    pool.configure(1);
+    EXPECT_EQ(pool.size(), 1);
+
+    pool.configure(0);
+    EXPECT_GE(pool.size(), 1);
+}
+
+TEST_F(ThreadPoolTest, EveryTaskRunsOnce) {
+    for (std::size_t ntasks : { 0, 1, 2, 3, 100, 1000 }) {
+        std::vector< std::atomic< int > > calls(ntasks);
+        pool.parallel_for(ntasks, [&calls](std::size_t i) { ++calls[i]; });
+
+        for (std::size_t i = 0; i < ntasks; ++i) {
+            EXPECT_EQ(calls[i], 1) << "task " << i << " of " << ntasks;
+        }
+    }
+}
+
+TEST_F(ThreadPoolTest, ExceptionIsRethrown) {
+    std::atomic< int > ncalls{ 0 };
+    auto const fn = [&ncalls](std::size_t i) {
+        ++ncalls;
+        if (i == 7) throw std::runtime_error("task 7 failed");
+    };
+
+    EXPECT_THROW(pool.parallel_for(20, fn), std::runtime_error);
+    EXPECT_EQ(ncalls, 20);
+
+    /* The pool is still usable */
+    ncalls = 0;
+    pool.parallel_for(20, [&ncalls](std::size_t) { ++ncalls; });
+    EXPECT_EQ(ncalls, 20);
+}
+
+TEST_F(ThreadPoolTest, ConcurrentCallersShareThePool) {
+    std::size_t const ncallers = 8;
+    std::size_t const ntasks = 200;
+
+    std::vector< std::atomic< int > > sums(ncallers);
+    std::vector< std::thread > callers;
+    for (std::size_t caller = 0; caller < ncallers; ++caller) {
+        callers.emplace_back([&, caller] {
+            pool.parallel_for(ntasks, [&, caller](std::size_t) { ++sums[caller]; });
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+
+    for (std::size_t caller = 0; caller < ncallers; ++caller) {
+        EXPECT_EQ(sums[caller], ntasks);
+    }
+}
+
+TEST_F(ThreadPoolTest, NestedCallsComplete) {
+    std::atomic< int > ncalls{ 0 };
+    pool.parallel_for(8, [&](std::size_t) {
+        pool.parallel_for(8, [&ncalls](std::size_t) { ++ncalls; });
+    });
+    EXPECT_EQ(ncalls, 64);
+}
+
+} // namespace
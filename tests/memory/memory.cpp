@@ -128,14 +128,14 @@ protected:
 
 TEST_F(EndpointTest, SliceEndpoint) {
     Bound bounds[1] = {Bound{4, 8, axis_name::TIME}};
-    int cerr = slice(context, dataHandle, 3, axis_name::INLINE, &bounds[0], 1, &result);
+    int cerr = slice(context, dataHandle, 3, axis_name::INLINE, &bounds[0], 1, 0, &result);
     EXPECT_EQ(cerr, STATUS_OK);
     EXPECT_NE(result.size, 0);
 }
 
 TEST_F(EndpointTest, SliceEndpointInvalidRequest) {
     Bound bounds[1] = {Bound{4, 8, axis_name::TIME}};
-    int cerr = slice(context, dataHandle, 30, axis_name::INLINE, &bounds[0], 0, &result);
+    int cerr = slice(context, dataHandle, 30, axis_name::INLINE, &bounds[0], 0, 0, &result);
     EXPECT_NE(cerr, STATUS_OK);
 
     std::string expected_msg = "Invalid lineno: 30";
@@ -153,6 +153,9 @@ TEST_F(EndpointTest, FenceEndpoint) {
         2,
         interpolation_method::LINEAR,
         nullptr,
+        nullptr,
+        0,
+        0,
         &result
     );
     EXPECT_EQ(cerr, STATUS_OK);
@@ -169,6 +172,9 @@ TEST_F(EndpointTest, FenceEndpointInvalidRequest) {
         2,
         interpolation_method::LINEAR,
         nullptr,
+        nullptr,
+        0,
+        0,
         &result
     );
     EXPECT_NE(cerr, STATUS_OK);
@@ -344,13 +350,13 @@ TEST_F(EndpointTest, MetadataEndpoint) {
 }
 
 TEST_F(EndpointTest, SliceMetadataEndpoint) {
-    int cerr = slice_metadata(context, dataHandle, 3, axis_name::INLINE, nullptr, 0, &result);
+    int cerr = slice_metadata(context, dataHandle, 3, axis_name::INLINE, nullptr, 0, 0, &result);
     EXPECT_EQ(cerr, STATUS_OK);
     EXPECT_NE(result.size, 0);
 }
 
 TEST_F(EndpointTest, FenceMetadataEndpoint) {
-    int cerr = fence_metadata(context, dataHandle, 4, &result);
+    int cerr = fence_metadata(context, dataHandle, 4, nullptr, 0, 0, &result);
     EXPECT_EQ(cerr, STATUS_OK);
     EXPECT_NE(result.size, 0);
 }